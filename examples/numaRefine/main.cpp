@@ -0,0 +1,231 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+//
+// Measures the refinement of a mesh on a pool of threads, with the vertex
+// buffer allocated and first written by the calling thread, and with its
+// pages placed on the NUMA nodes of the threads that refine them (see
+// OsdThreadPoolComputeController::DistributeVertexBuffer()).
+//
+// usage : numaRefine [-l level] [-e elements] [-t maxThreads] [-r repeats]
+//
+
+#include <osd/vertex.h>
+#include <osd/mesh.h>
+#include <osd/cpuComputeContext.h>
+#include <osd/cpuVertexBuffer.h>
+#include <osd/threadPool.h>
+#include <osd/threadPoolComputeController.h>
+
+#include <far/meshFactory.h>
+
+#include "../../regression/common/shape_utils.h"
+#include "../common/stopwatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+using namespace OpenSubdiv;
+
+typedef HbrMesh<OsdVertex> OsdHbrMesh;
+
+//------------------------------------------------------------------------------
+static int g_level = 5,
+           g_numElements = 3,
+           g_maxThreads = -1,
+           g_repeats = 10;
+
+//------------------------------------------------------------------------------
+// Pins the calling thread, which runs the first partition of every loop, to
+// the processor of the first worker
+static void
+pinCallingThread() {
+
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+}
+
+//------------------------------------------------------------------------------
+static FarMesh<OsdVertex> *
+createFarMesh(bool localityOrdering, std::vector<float> & coarseVerts) {
+
+#include "../../regression/shapes/catmark_cube.h"
+
+    OsdHbrMesh * hmesh = simpleHbr<OsdVertex>(catmark_cube.c_str(), kCatmark, coarseVerts);
+
+    FarMeshFactory<OsdVertex> meshFactory(hmesh, g_level);
+    meshFactory.SetLocalityOrdering(localityOrdering);
+
+    FarMesh<OsdVertex> * farMesh = meshFactory.Create();
+
+    delete hmesh;
+
+    return farMesh;
+}
+
+//------------------------------------------------------------------------------
+// Returns the average time of a refinement in milliseconds
+static double
+refine(OsdThreadPoolComputeController * controller, bool distribute, bool localityOrdering) {
+
+    std::vector<float> coarseVerts;
+    FarMesh<OsdVertex> * farMesh = createFarMesh(localityOrdering, coarseVerts);
+
+    OsdCpuComputeContext * context = OsdCpuComputeContext::Create(farMesh);
+
+    int numVertices = farMesh->GetNumVertices(),
+        numCoarseVertices = (int)coarseVerts.size() / 3;
+
+    OsdCpuVertexBuffer * vertexBuffer;
+    if (distribute) {
+        vertexBuffer = OsdCpuVertexBuffer::Create(g_numElements, numVertices,
+                                                  OsdCpuVertexBuffer::ALLOCATE_PAGES);
+        controller->DistributeVertexBuffer(farMesh->GetKernelBatches(), vertexBuffer);
+    } else {
+        // the calling thread writes (and places) all the pages
+        vertexBuffer = OsdCpuVertexBuffer::Create(g_numElements, numVertices);
+        memset(vertexBuffer->BindCpuBuffer(), 0,
+               (size_t)numVertices * g_numElements * sizeof(float));
+    }
+
+    std::vector<float> coarseData((size_t)numCoarseVertices * g_numElements, 0.0f);
+    for (int i = 0; i < numCoarseVertices; ++i)
+        for (int j = 0; j < g_numElements; ++j)
+            coarseData[i * g_numElements + j] = coarseVerts[i * 3 + j % 3];
+
+    vertexBuffer->UpdateData(&coarseData[0], 0, numCoarseVertices);
+
+    // warm up
+    controller->Refine(context, farMesh->GetKernelBatches(), vertexBuffer);
+
+    Stopwatch s;
+    s.Start();
+    for (int i = 0; i < g_repeats; ++i)
+        controller->Refine(context, farMesh->GetKernelBatches(), vertexBuffer);
+    s.Stop();
+
+    delete vertexBuffer;
+    delete context;
+    delete farMesh;
+
+    return s.GetElapsed() * 1000.0 / g_repeats;
+}
+
+//------------------------------------------------------------------------------
+static void
+usage(char const * program) {
+
+    printf("usage : %s [-l level] [-e elements] [-t maxThreads] [-r repeats]\n", program);
+    exit(1);
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc and not strcmp(argv[i], "-l")) {
+            g_level = atoi(argv[++i]);
+        } else if (i + 1 < argc and not strcmp(argv[i], "-e")) {
+            g_numElements = atoi(argv[++i]);
+        } else if (i + 1 < argc and not strcmp(argv[i], "-t")) {
+            g_maxThreads = atoi(argv[++i]);
+        } else if (i + 1 < argc and not strcmp(argv[i], "-r")) {
+            g_repeats = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+
+    if (g_level < 1 or g_numElements < 3 or g_repeats < 1)
+        usage(argv[0]);
+
+    if (g_maxThreads < 1)
+        g_maxThreads = OsdThreadPool::GetNumProcessors();
+
+    pinCallingThread();
+
+    printf("level %d, %d elements, %d repeats\n", g_level, g_numElements, g_repeats);
+    printf("threads   default (ms)   distributed (ms)   speedup\n");
+
+    for (int numThreads = 1; numThreads <= g_maxThreads; numThreads *= 2) {
+
+        OsdThreadPoolComputeController defaultController(numThreads);
+
+        OsdThreadPoolComputeController partitionedController(numThreads, 256, true);
+        partitionedController.SetPartitioned(true);
+
+        double defaultTime = refine(&defaultController, false, false),
+               distributedTime = refine(&partitionedController, true, true);
+
+        printf("%7d   %12.3f   %16.3f   %7.2f\n", numThreads, defaultTime,
+               distributedTime, distributedTime > 0.0 ? defaultTime / distributedTime : 0.0);
+    }
+
+    return 0;
+}
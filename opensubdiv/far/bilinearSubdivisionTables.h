@@ -86,6 +86,7 @@ public:
 private:
     template <class X, class Y> friend class FarBilinearSubdivisionTablesFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
     template <class CONTROLLER> friend class FarComputeController;
 
     FarBilinearSubdivisionTables( FarMesh<U> * mesh, int maxlevel );
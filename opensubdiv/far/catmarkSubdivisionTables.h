@@ -86,6 +86,8 @@ public:
 private:
     template <class X, class Y> friend class FarCatmarkSubdivisionTablesFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyRefiner;
     template <class CONTROLLER> friend class FarComputeController;
 
     // Private constructor called by factory
@@ -0,0 +1,243 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_DEPENDENCY_TABLES_H
+#define FAR_DEPENDENCY_TABLES_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Dependency cones of the control vertices of a mesh.
+///
+/// The cone of a control vertex is the set of the refined vertices, at all
+/// levels, whose position depends on the control vertex. When only a few
+/// control vertices change (animation of a small region, sculpting), the
+/// cones give the refined vertices that have to be recomputed : the kernel
+/// batches of the mesh are restricted to these vertices (see
+/// GetDirtyBatches()), which the compute controllers execute as usual.
+///
+/// The vertices of a cone are stored as ranges of consecutive vertices.
+///
+/// The tables are generated by FarDependencyTablesFactory.
+///
+class FarDependencyTables {
+
+public:
+
+    /// Returns the number of control vertices
+    int GetNumControlVertices() const {
+        return (int)_coneOffsets.size()-1;
+    }
+
+    /// Returns the number of vertices of the mesh (control and refined)
+    int GetNumVertices() const {
+        return _numVertices;
+    }
+
+    /// Returns the number of vertex ranges in the cone of a control vertex
+    int GetNumConeRanges(int vertex) const {
+        return _coneOffsets[vertex+1]-_coneOffsets[vertex];
+    }
+
+    /// Returns the ranges of refined vertices depending on a control vertex,
+    /// sorted by index (hence by level) : range 'i' covers the vertices from
+    /// ranges[2*i] to ranges[2*i+1] (excluded).
+    int const * GetConeRanges(int vertex) const {
+        return &_coneRanges[2*_coneOffsets[vertex]];
+    }
+
+    /// Restricts kernel batches to the refined vertices depending on a set of
+    /// control vertices.
+    ///
+    /// The data of the other refined vertices is left untouched, which
+    /// requires the vertex buffers to hold the result of a previous (full)
+    /// refinement. Each batch is split into runs of consecutive dirty
+    /// vertices : when the dirty vertices exceed 'maxDensity' of the refined
+    /// vertices, the runs cost more than they save and the full batches are
+    /// returned instead. The full batches are also returned for the meshes
+    /// with hierarchical edits, which cannot be applied twice to the same
+    /// vertex.
+    ///
+    /// @param batches       the kernel batches of the mesh
+    ///
+    /// @param vertices      the indices of the control vertices that changed
+    ///
+    /// @param numVertices   the number of control vertices that changed
+    ///
+    /// @param dirtyBatches  the batches to refine with (sparse or full)
+    ///
+    /// @param maxDensity    fraction of dirty refined vertices above which a
+    ///                      full refinement is done
+    ///
+    /// @return              true if the batches are sparse
+    ///
+    bool GetDirtyBatches( FarKernelBatchVector const & batches,
+                          int const * vertices,
+                          int numVertices,
+                          FarKernelBatchVector & dirtyBatches,
+                          float maxDensity=0.4f ) const;
+
+    /// Memory required to store the tables
+    int GetMemoryUsed() const {
+        return (int)((_coneOffsets.size() + _coneRanges.size()) * sizeof(int));
+    }
+
+private:
+    template <class X> friend class FarDependencyTablesFactory;
+
+    FarDependencyTables() : _numVertices(0) { }
+
+    int _numVertices;
+
+    std::vector<int> _coneOffsets,  // index of the first range of each cone
+                     _coneRanges;   // pairs of first and end vertex indices
+};
+
+inline bool
+FarDependencyTables::GetDirtyBatches( FarKernelBatchVector const & batches,
+    int const * vertices, int numVertices, FarKernelBatchVector & dirtyBatches,
+    float maxDensity ) const {
+
+    dirtyBatches.clear();
+
+    bool sparse = true;
+    for (int i=0; i<(int)batches.size(); ++i) {
+        if (batches[i].GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT)
+            sparse = false;
+    }
+
+    int numControlVertices = GetNumControlVertices(),
+        maxDirty = (int)(maxDensity * (float)(_numVertices-numControlVertices));
+
+    // union of the cones : the ranges overlap, so their total length is an
+    // upper bound of the number of dirty vertices
+    std::vector<unsigned char> dirty;
+    int numDirty = 0;
+
+    if (sparse) {
+        dirty.resize(_numVertices, 0);
+        for (int i=0; i<numVertices; ++i) {
+            assert(vertices[i]>=0 and vertices[i]<numControlVertices);
+            int const * ranges = GetConeRanges(vertices[i]);
+            for (int j=0; j<GetNumConeRanges(vertices[i]); ++j) {
+                int first = ranges[2*j], end = ranges[2*j+1];
+                memset(&dirty[first], 1, end-first);
+                numDirty += end-first;
+            }
+        }
+        if (numDirty>maxDirty) {
+            numDirty = (int)std::count(dirty.begin()+numControlVertices,
+                                       dirty.end(), 1);
+            sparse = numDirty<=maxDirty;
+        }
+    }
+
+    if (not sparse) {
+        dirtyBatches = batches;
+        return false;
+    }
+
+    if (numDirty==0)
+        return true;
+
+    // split the batches into runs of consecutive dirty vertices
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarKernelBatch const & batch = batches[i];
+
+        int vertexOffset = batch.GetVertexOffset(),
+            end = vertexOffset + batch.GetEnd();
+
+        unsigned char const * marks = &dirty[0];
+
+        for (int first=vertexOffset+batch.GetStart(); first<end; ) {
+
+            unsigned char const * next = static_cast<unsigned char const *>(
+                memchr(marks+first, 1, end-first));
+            if (not next)
+                break;
+
+            first = (int)(next-marks);
+            int last = first+1;
+            while (last<end and marks[last])
+                ++last;
+
+            dirtyBatches.push_back(FarKernelBatch( batch.GetKernelType(),
+                batch.GetLevel(), batch.GetTableIndex(),
+                first-vertexOffset, last-vertexOffset,
+                batch.GetTableOffset(), vertexOffset, batch.GetMeshIndex()));
+
+            first = last;
+        }
+    }
+    return true;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_DEPENDENCY_TABLES_H */
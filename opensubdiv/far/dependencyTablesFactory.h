@@ -0,0 +1,216 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_DEPENDENCY_TABLES_FACTORY_H
+#define FAR_DEPENDENCY_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/dependencyTables.h"
+#include "../far/stencilTablesFactory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A specialized factory for FarDependencyTables
+///
+/// The dependencies are read from the vertex stencils of the mesh (see
+/// FarStencilTablesFactory) : the control vertices supporting each refined
+/// vertex are gathered level after level, then the supports are inverted into
+/// the cones of the control vertices.
+///
+/// The varying interpolation rules read a subset of the vertices read by the
+/// vertex rules : the cones hold for both.
+///
+template <class U> class FarDependencyTablesFactory {
+
+public:
+
+    /// Creates the dependency tables of 'mesh'
+    ///
+    /// @param mesh  the mesh to generate the dependencies of
+    ///
+    /// @return      the dependency tables (owned by the caller)
+    ///
+    static FarDependencyTables * Create( FarMesh<U> const * mesh );
+};
+
+template <class U> FarDependencyTables *
+FarDependencyTablesFactory<U>::Create( FarMesh<U> const * mesh ) {
+
+    assert(mesh);
+
+    FarStencilTables * stencils =
+        FarStencilTablesFactory<U>::Create(mesh, FarStencilTables::VERTEX);
+
+    FarStencilBatchVector const & batches = stencils->GetBatches();
+
+    int nverts = mesh->GetNumVertices();
+
+    // the control vertices precede the refined vertices
+    int ncontrol = nverts;
+    for (int i=0; i<(int)batches.size(); ++i) {
+        FarStencilBatch const & batch = batches[i];
+        if (batch.GetBatchType()==FarStencilBatch::STENCILS and
+            batch.GetStart()<batch.GetEnd())
+            ncontrol = std::min(ncontrol,
+                                batch.GetVertexOffset()+batch.GetStart());
+    }
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                           & offsets = stencils->GetOffsets(),
+                           & indices = stencils->GetIndices();
+
+    // control vertices supporting each refined vertex, indexed by vertex
+    std::vector<int> supportSizes(nverts, 0),
+                     supportOffsets(nverts, 0),
+                     supportIndices;
+
+    std::vector<int> marks(ncontrol, -1);
+    int mark = 0;
+
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType()==FarStencilBatch::HIERARCHICAL_EDIT)
+            continue;
+
+        for (int j=batch.GetStart(); j<batch.GetEnd(); ++j, ++mark) {
+
+            int vertex = batch.GetVertexOffset() + j,
+                stencil = batch.GetTableOffset() + j;
+
+            supportOffsets[vertex] = (int)supportIndices.size();
+
+            for (int k=0; k<sizes[stencil]; ++k) {
+
+                int src = indices[offsets[stencil]+k];
+
+                if (src<ncontrol) {
+                    if (marks[src]!=mark) {
+                        marks[src] = mark;
+                        supportIndices.push_back(src);
+                    }
+                    continue;
+                }
+
+                // the source vertices are refined by the previous batches
+                for (int l=0; l<supportSizes[src]; ++l) {
+                    int control = supportIndices[supportOffsets[src]+l];
+                    if (marks[control]!=mark) {
+                        marks[control] = mark;
+                        supportIndices.push_back(control);
+                    }
+                }
+            }
+            supportSizes[vertex] =
+                (int)supportIndices.size() - supportOffsets[vertex];
+        }
+    }
+
+    delete stencils;
+
+    // invert the supports : visiting the refined vertices in order sorts the
+    // cones, whose consecutive vertices are merged into ranges
+    std::vector<int> coneSizes(ncontrol, 0), coneEnds(ncontrol, -1);
+
+    for (int vertex=ncontrol; vertex<nverts; ++vertex) {
+        for (int l=0; l<supportSizes[vertex]; ++l) {
+            int control = supportIndices[supportOffsets[vertex]+l];
+            if (coneEnds[control]!=vertex)
+                ++coneSizes[control];
+            coneEnds[control] = vertex+1;
+        }
+    }
+
+    FarDependencyTables * result = new FarDependencyTables;
+
+    result->_numVertices = nverts;
+    result->_coneOffsets.assign(ncontrol+1, 0);
+    for (int i=0; i<ncontrol; ++i)
+        result->_coneOffsets[i+1] = result->_coneOffsets[i] + coneSizes[i];
+    result->_coneRanges.resize(2*result->_coneOffsets[ncontrol]);
+
+    std::vector<int> fill(result->_coneOffsets.begin(),
+                          result->_coneOffsets.end()-1);
+    coneEnds.assign(ncontrol, -1);
+
+    for (int vertex=ncontrol; vertex<nverts; ++vertex) {
+        for (int l=0; l<supportSizes[vertex]; ++l) {
+            int control = supportIndices[supportOffsets[vertex]+l];
+            if (coneEnds[control]!=vertex) {
+                result->_coneRanges[2*fill[control]] = vertex;
+                ++fill[control];
+            }
+            result->_coneRanges[2*fill[control]-1] = vertex+1;
+            coneEnds[control] = vertex+1;
+        }
+    }
+    return result;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_DEPENDENCY_TABLES_FACTORY_H */
@@ -65,6 +65,12 @@
 #include "../far/loopSubdivisionTables.h"
 #include "../far/vertexEditTables.h"
 #include "../far/kernelBatch.h"
+#include "../far/refinePlan.h"
+#include "../far/trace.h"
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+    #include "../far/kernelStats.h"
+#endif
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -84,68 +90,110 @@ namespace OPENSUBDIV_VERSION {
 ///
 /// Note : the caller is responsible for deleting a custom dispatcher
 ///
+/// When built with OPENSUBDIV_KERNEL_STATS, Refine records each batch into
+/// the current FarKernelStats. When built with OPENSUBDIV_TRACE, it records
+/// a span per refinement and per batch into the current FarTrace.
+///
 
 class FarDispatcher {
 public:
     template <class CONTROLLER>
     static void Refine(CONTROLLER const *controller, FarKernelBatchVector const & batches, int maxlevel, void * clientdata=0);
+
+    /// Runs the batches of a plan compiled from the kernel batches of a mesh.
+    template <class CONTROLLER>
+    static void Refine(CONTROLLER const *controller, FarRefinePlan const & plan, void * clientdata=0);
+
+    /// Applies the kernel of a single batch (the batches of a
+    /// FarKernelBatchGraph wave can be applied in any order).
+    template <class CONTROLLER>
+    static void ApplyKernel(CONTROLLER const *controller, FarKernelBatch const & batch, void * clientdata=0);
+
+private:
+    // returns the kernel functions of a controller, indexed by
+    // FarKernelBatch::KernelType
+    template <class CONTROLLER>
+    static void (CONTROLLER::* const * getKernels())(FarKernelBatch const &, void *) const;
 };
 
 template <class CONTROLLER> void
 FarDispatcher::Refine(CONTROLLER const *controller, FarKernelBatchVector const & batches, int maxlevel, void * clientdata) {
 
+    FAR_TRACE_SCOPE("FarDispatcher::Refine", "refine");
+
     for (int i = 0; i < (int)batches.size(); ++i) {
         const FarKernelBatch &batch = batches[i];
 
         if (maxlevel >= 0 && batch.GetLevel() >= maxlevel) continue;
 
-        switch(batch.GetKernelType()) {
-            case FarKernelBatch::CATMARK_FACE_VERTEX:
-                controller->ApplyCatmarkFaceVerticesKernel(batch, clientdata);
-                break;
-            case FarKernelBatch::CATMARK_EDGE_VERTEX:
-                controller->ApplyCatmarkEdgeVerticesKernel(batch, clientdata);
-                break;
-            case FarKernelBatch::CATMARK_VERT_VERTEX_B:
-                controller->ApplyCatmarkVertexVerticesKernelB(batch, clientdata);
-                break;
-            case FarKernelBatch::CATMARK_VERT_VERTEX_A1:
-                controller->ApplyCatmarkVertexVerticesKernelA1(batch, clientdata);
-                break;
-            case FarKernelBatch::CATMARK_VERT_VERTEX_A2:
-                controller->ApplyCatmarkVertexVerticesKernelA2(batch, clientdata);
-                break;
-
-            case FarKernelBatch::LOOP_EDGE_VERTEX:
-                controller->ApplyLoopEdgeVerticesKernel(batch, clientdata);
-                break;
-            case FarKernelBatch::LOOP_VERT_VERTEX_B:
-                controller->ApplyLoopVertexVerticesKernelB(batch, clientdata);
-                break;
-            case FarKernelBatch::LOOP_VERT_VERTEX_A1:
-                controller->ApplyLoopVertexVerticesKernelA1(batch, clientdata);
-                break;
-            case FarKernelBatch::LOOP_VERT_VERTEX_A2:
-                controller->ApplyLoopVertexVerticesKernelA2(batch, clientdata);
-                break;
-
-            case FarKernelBatch::BILINEAR_FACE_VERTEX:
-                controller->ApplyBilinearFaceVerticesKernel(batch, clientdata);
-                break;
-            case FarKernelBatch::BILINEAR_EDGE_VERTEX:
-                controller->ApplyBilinearEdgeVerticesKernel(batch, clientdata);
-                break;
-            case FarKernelBatch::BILINEAR_VERT_VERTEX:
-                controller->ApplyBilinearVertexVerticesKernel(batch, clientdata);
-                break;
-
-            case FarKernelBatch::HIERARCHICAL_EDIT:
-                controller->ApplyVertexEdits(batch, clientdata);
-                break;
+        FAR_TRACE_SCOPE(FarKernelStats::GetKernelName(batch.GetKernelType()), "kernel");
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+        if (FarKernelStats * stats = FarKernelStats::GetCurrent()) {
+            FarKernelStats::Sample sample = stats->Begin();
+            ApplyKernel(controller, batch, clientdata);
+            stats->End(batch, sample);
+            continue;
         }
+#endif
+        ApplyKernel(controller, batch, clientdata);
     }
 }
 
+template <class CONTROLLER> void
+FarDispatcher::Refine(CONTROLLER const *controller, FarRefinePlan const & plan, void * clientdata) {
+
+    void (CONTROLLER::* const * kernels)(FarKernelBatch const &, void *) const =
+        getKernels<CONTROLLER>();
+
+    FarKernelBatchVector const & batches = plan.GetBatches();
+
+    FAR_TRACE_SCOPE("FarDispatcher::Refine", "refine");
+
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        const FarKernelBatch &batch = batches[i];
+
+        FAR_TRACE_SCOPE(FarKernelStats::GetKernelName(batch.GetKernelType()), "kernel");
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+        if (FarKernelStats * stats = FarKernelStats::GetCurrent()) {
+            FarKernelStats::Sample sample = stats->Begin();
+            (controller->*kernels[batch.GetKernelType()])(batch, clientdata);
+            stats->End(batch, sample);
+            continue;
+        }
+#endif
+        (controller->*kernels[batch.GetKernelType()])(batch, clientdata);
+    }
+}
+
+template <class CONTROLLER> void
+FarDispatcher::ApplyKernel(CONTROLLER const *controller, FarKernelBatch const & batch, void * clientdata) {
+
+    (controller->*getKernels<CONTROLLER>()[batch.GetKernelType()])(batch, clientdata);
+}
+
+template <class CONTROLLER> void (CONTROLLER::* const * FarDispatcher::getKernels())(FarKernelBatch const &, void *) const {
+
+    // constant initialized : the table is built at compile time
+    static void (CONTROLLER::* const kernels[])(FarKernelBatch const &, void *) const = {
+        &CONTROLLER::ApplyCatmarkFaceVerticesKernel,        // CATMARK_FACE_VERTEX
+        &CONTROLLER::ApplyCatmarkEdgeVerticesKernel,        // CATMARK_EDGE_VERTEX
+        &CONTROLLER::ApplyCatmarkVertexVerticesKernelA1,    // CATMARK_VERT_VERTEX_A1
+        &CONTROLLER::ApplyCatmarkVertexVerticesKernelA2,    // CATMARK_VERT_VERTEX_A2
+        &CONTROLLER::ApplyCatmarkVertexVerticesKernelB,     // CATMARK_VERT_VERTEX_B
+        &CONTROLLER::ApplyLoopEdgeVerticesKernel,           // LOOP_EDGE_VERTEX
+        &CONTROLLER::ApplyLoopVertexVerticesKernelA1,       // LOOP_VERT_VERTEX_A1
+        &CONTROLLER::ApplyLoopVertexVerticesKernelA2,       // LOOP_VERT_VERTEX_A2
+        &CONTROLLER::ApplyLoopVertexVerticesKernelB,        // LOOP_VERT_VERTEX_B
+        &CONTROLLER::ApplyBilinearFaceVerticesKernel,       // BILINEAR_FACE_VERTEX
+        &CONTROLLER::ApplyBilinearEdgeVerticesKernel,       // BILINEAR_EDGE_VERTEX
+        &CONTROLLER::ApplyBilinearVertexVerticesKernel,     // BILINEAR_VERT_VERTEX
+        &CONTROLLER::ApplyVertexEdits,                      // HIERARCHICAL_EDIT
+    };
+    return kernels;
+}
+
 // -----------------------------------------------------------------------------
 
 
@@ -156,6 +204,8 @@ class FarComputeController
 public:
     void Refine(FarMesh<U> * mesh, int maxlevel=-1) const;
 
+    void Refine(FarMesh<U> * mesh, FarRefinePlan const & plan) const;
+
     void ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
 
     void ApplyBilinearEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
@@ -197,14 +247,20 @@ FarComputeController<U>::Refine(FarMesh<U> *mesh, int maxlevel) const {
     FarDispatcher::Refine(this, mesh->GetKernelBatches(), maxlevel, mesh);
 }
 
+template <class U> void
+FarComputeController<U>::Refine(FarMesh<U> *mesh, FarRefinePlan const & plan) const {
+
+    FarDispatcher::Refine(this, plan, mesh);
+}
+
 template <class U> void
 FarComputeController<U>::ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const {
 
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeFacePoints( batch.GetVertexOffset(),
                                     batch.GetTableOffset(),
@@ -219,8 +275,8 @@ FarComputeController<U>::ApplyBilinearEdgeVerticesKernel(FarKernelBatch const &b
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeEdgePoints( batch.GetVertexOffset(),
                                     batch.GetTableOffset(),
@@ -235,9 +291,8 @@ FarComputeController<U>::ApplyBilinearVertexVerticesKernel(FarKernelBatch const
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarBilinearSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarBilinearSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPoints( batch.GetVertexOffset(),
                                       batch.GetTableOffset(),
@@ -252,9 +307,8 @@ FarComputeController<U>::ApplyCatmarkFaceVerticesKernel(FarKernelBatch const &ba
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeFacePoints( batch.GetVertexOffset(),
                                     batch.GetTableOffset(),
@@ -269,9 +323,8 @@ FarComputeController<U>::ApplyCatmarkEdgeVerticesKernel(FarKernelBatch const &ba
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeEdgePoints( batch.GetVertexOffset(),
                                     batch.GetTableOffset(),
@@ -286,9 +339,8 @@ FarComputeController<U>::ApplyCatmarkVertexVerticesKernelB(FarKernelBatch const
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsB( batch.GetVertexOffset(),
                                        batch.GetTableOffset(),
@@ -303,9 +355,8 @@ FarComputeController<U>::ApplyCatmarkVertexVerticesKernelA1(FarKernelBatch const
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsA( batch.GetVertexOffset(),
                                        false,
@@ -321,9 +372,8 @@ FarComputeController<U>::ApplyCatmarkVertexVerticesKernelA2(FarKernelBatch const
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarCatmarkSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsA( batch.GetVertexOffset(),
                                        true,
@@ -339,9 +389,8 @@ FarComputeController<U>::ApplyLoopEdgeVerticesKernel(FarKernelBatch const &batch
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeEdgePoints( batch.GetVertexOffset(),
                                     batch.GetTableOffset(),
@@ -356,9 +405,8 @@ FarComputeController<U>::ApplyLoopVertexVerticesKernelB(FarKernelBatch const &ba
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsB( batch.GetVertexOffset(),
                                        batch.GetTableOffset(),
@@ -373,9 +421,8 @@ FarComputeController<U>::ApplyLoopVertexVerticesKernelA1(FarKernelBatch const &b
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsA( batch.GetVertexOffset(),
                                        false,
@@ -391,9 +438,8 @@ FarComputeController<U>::ApplyLoopVertexVerticesKernelA2(FarKernelBatch const &b
     FarMesh<U> * mesh = static_cast<FarMesh<U> *>(clientdata);
 
     FarLoopSubdivisionTables<U> const * subdivision =
-        dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
-
-    assert(subdivision);
+        static_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables());
+    assert(dynamic_cast<FarLoopSubdivisionTables<U> const *>(mesh->GetSubdivisionTables()));
 
     subdivision->computeVertexPointsA( batch.GetVertexOffset(),
                                        true,
@@ -60,11 +60,145 @@
 #include "../version.h"
 
 #include "../far/kernelBatch.h"
+#include "../far/kernelBatchGraph.h"
+
+#include <algorithm>
+#include <cassert>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 
+/// \brief Merges kernel batches into fewer, larger ones.
+///
+/// Spliced and adaptive meshes produce many small batches of the same kernel.
+/// Two batches can be merged when they apply the same kernel to the same
+/// level, and their table entries and vertices are both contiguous, since
+/// the kernels compute vertex 'vertexOffset + i' from table entry
+/// 'tableOffset + i'. Merging moves a batch up to an earlier one : it is
+/// only done when the batch does not depend on the batches in between (see
+/// FarKernelBatchGraph::IsDependent), so the result computes the same
+/// vertices as the original sequence.
+///
+class FarKernelBatchFactory {
+
+public:
+
+    /// Merges the contiguous batches of a batch vector.
+    ///
+    /// @param batches  the kernel batches, in dispatch order
+    ///
+    /// @param result   the merged batches, in dispatch order. Batches merged
+    ///                 across meshes have a mesh index of -1.
+    ///
+    static void Coalesce(FarKernelBatchVector const & batches, FarKernelBatchVector * result);
+
+private:
+
+    // returns true if 'second' computes the vertices right before or after
+    // those of 'first', with the same kernel
+    static bool isContiguous(FarKernelBatch const & first, FarKernelBatch const & second);
+
+    // returns a batch computing the vertices of two contiguous batches
+    static FarKernelBatch merge(FarKernelBatch const & first, FarKernelBatch const & second);
+
+    // merges each batch into an earlier batch where possible
+    static void coalesce(FarKernelBatchVector const & batches, FarKernelBatchVector * result);
+};
+
+inline bool
+FarKernelBatchFactory::isContiguous(FarKernelBatch const & first, FarKernelBatch const & second) {
+
+    if (first.GetKernelType()!=second.GetKernelType() or
+        first.GetLevel()!=second.GetLevel() or
+        first.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT)
+        return false;
+
+    // the table entries and the vertices must be shifted by the same amount
+    if (first.GetTableOffset()-first.GetVertexOffset()!=
+        second.GetTableOffset()-second.GetVertexOffset())
+        return false;
+
+    int start0 = first.GetTableOffset()+first.GetStart(),
+        end0 = first.GetTableOffset()+first.GetEnd(),
+        start1 = second.GetTableOffset()+second.GetStart(),
+        end1 = second.GetTableOffset()+second.GetEnd();
+
+    return end0==start1 or end1==start0;
+}
+
+inline FarKernelBatch
+FarKernelBatchFactory::merge(FarKernelBatch const & first, FarKernelBatch const & second) {
+
+    int tableOffset = first.GetTableOffset(),
+        vertexOffset = first.GetVertexOffset(),
+        shift = second.GetTableOffset()-tableOffset,
+        start = std::min(first.GetStart(), second.GetStart()+shift),
+        end = std::max(first.GetEnd(), second.GetEnd()+shift);
+
+    // keep the range positive
+    if (start<0) {
+        tableOffset += start;
+        vertexOffset += start;
+        end -= start;
+        start = 0;
+    }
+
+    int meshIndex = first.GetMeshIndex()==second.GetMeshIndex() ? first.GetMeshIndex() : -1;
+
+    return FarKernelBatch(first.GetKernelType(), first.GetLevel(), 0,
+                          start, end, tableOffset, vertexOffset, meshIndex);
+}
+
+inline void
+FarKernelBatchFactory::coalesce(FarKernelBatchVector const & batches, FarKernelBatchVector * result) {
+
+    result->clear();
+    result->reserve(batches.size());
+
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarKernelBatch const & batch = batches[i];
+
+        // look for a batch to merge with, up to the last batch this one
+        // depends on
+        bool merged = false;
+        for (int j=(int)result->size()-1; j>=0; --j) {
+
+            FarKernelBatch & previous = (*result)[j];
+
+            if (isContiguous(previous, batch)) {
+                previous = merge(previous, batch);
+                merged = true;
+                break;
+            }
+
+            if (FarKernelBatchGraph::IsDependent(previous, batch))
+                break;
+        }
+
+        if (not merged)
+            result->push_back(batch);
+    }
+}
+
+inline void
+FarKernelBatchFactory::Coalesce(FarKernelBatchVector const & batches, FarKernelBatchVector * result) {
+
+    assert(result and result!=&batches);
+
+    coalesce(batches, result);
+
+    // a merged batch can become contiguous with an earlier one
+    FarKernelBatchVector merged;
+    while (true) {
+        coalesce(*result, &merged);
+        if (merged.size()==result->size())
+            break;
+        result->swap(merged);
+    }
+}
+
 class FarVertexKernelBatchFactory {
 
 public:
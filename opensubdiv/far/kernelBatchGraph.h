@@ -0,0 +1,258 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_KERNEL_BATCH_GRAPH_H
+#define FAR_KERNEL_BATCH_GRAPH_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Dependency graph of kernel batches.
+///
+/// FarDispatcher runs the kernel batches of a mesh in sequence, although many
+/// of them do not depend on each other : the batches of different meshes
+/// spliced by FarMultiMeshFactory are independent, and within a level the
+/// face-vertex, edge-vertex and vertex-vertex batches only depend on a few
+/// of the others (Catmark edge and vertex kernels read the new face
+/// vertices, vertex kernels accumulate over the same vertices).
+///
+/// The graph connects each batch to the earlier batches it conflicts with,
+/// and groups the batches into waves : the batches of a wave are independent
+/// of each other and only depend on batches of earlier waves, so that a
+/// compute controller can run them concurrently. Running the waves in order
+/// gives the same results as the sequential dispatch.
+///
+class FarKernelBatchGraph {
+
+public:
+
+    /// Constructor.
+    ///
+    /// @param batches  the kernel batches, in dispatch order
+    ///
+    explicit FarKernelBatchGraph( FarKernelBatchVector const & batches );
+
+    /// Returns the kernel batches
+    FarKernelBatchVector const & GetBatches() const {
+        return _batches;
+    }
+
+    /// Returns the number of kernel batches
+    int GetNumBatches() const {
+        return (int)_batches.size();
+    }
+
+    /// Returns the number of batches that must complete before a batch
+    int GetNumDependencies(int batch) const {
+        return _dependencyOffsets[batch+1]-_dependencyOffsets[batch];
+    }
+
+    /// Returns the indices of the batches that must complete before a batch
+    int const * GetDependencies(int batch) const {
+        return _dependencies.empty() ? 0 : &_dependencies[_dependencyOffsets[batch]];
+    }
+
+    /// Returns the number of waves (the length of the critical path, in
+    /// batches)
+    int GetNumWaves() const {
+        return (int)_waveOffsets.size()-1;
+    }
+
+    /// Returns the number of batches in a wave
+    int GetNumWaveBatches(int wave) const {
+        return _waveOffsets[wave+1]-_waveOffsets[wave];
+    }
+
+    /// Returns the indices of the batches of a wave, in dispatch order
+    int const * GetWaveBatches(int wave) const {
+        return &_waveBatches[_waveOffsets[wave]];
+    }
+
+    /// Returns true if 'second' reads or writes vertices written or read by
+    /// 'first', so that 'second' cannot run before 'first' completes.
+    static bool IsDependent( FarKernelBatch const & first, FarKernelBatch const & second );
+
+private:
+
+    // returns true if the kernel reads the face-vertices of its own level
+    static bool readsFaceVertices( FarKernelBatch::KernelType type );
+
+    FarKernelBatchVector _batches;
+
+    std::vector<int> _dependencyOffsets,
+                     _dependencies,
+                     _waveOffsets,
+                     _waveBatches;
+};
+
+inline bool
+FarKernelBatchGraph::readsFaceVertices( FarKernelBatch::KernelType type ) {
+
+    return type==FarKernelBatch::CATMARK_EDGE_VERTEX or
+           type==FarKernelBatch::CATMARK_VERT_VERTEX_B;
+}
+
+inline bool
+FarKernelBatchGraph::IsDependent( FarKernelBatch const & first, FarKernelBatch const & second ) {
+
+    // spliced meshes do not share vertices (a negative index marks a batch
+    // coalesced across several meshes)
+    if (first.GetMeshIndex()!=second.GetMeshIndex() and
+        first.GetMeshIndex()>=0 and second.GetMeshIndex()>=0)
+        return false;
+
+    int level0 = first.GetLevel(),
+        level1 = second.GetLevel();
+
+    // the kernels of a level read all the vertices of the previous level
+    if (level0==level1+1 or level1==level0+1)
+        return true;
+
+    if (level0!=level1)
+        return false;
+
+    // hierarchical edits read and write any vertex of their level
+    if (first.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT or
+        second.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT)
+        return true;
+
+    // the vertex kernels accumulate over the vertices of the previous ones
+    int start0 = first.GetVertexOffset()+first.GetStart(),
+        end0 = first.GetVertexOffset()+first.GetEnd(),
+        start1 = second.GetVertexOffset()+second.GetStart(),
+        end1 = second.GetVertexOffset()+second.GetEnd();
+
+    if (start0<end1 and start1<end0)
+        return true;
+
+    return (first.GetKernelType()==FarKernelBatch::CATMARK_FACE_VERTEX and
+            readsFaceVertices(second.GetKernelType())) or
+           (second.GetKernelType()==FarKernelBatch::CATMARK_FACE_VERTEX and
+            readsFaceVertices(first.GetKernelType()));
+}
+
+inline
+FarKernelBatchGraph::FarKernelBatchGraph( FarKernelBatchVector const & batches ) :
+    _batches(batches) {
+
+    int nbatches = (int)batches.size();
+
+    // batches coalesced across meshes may conflict with the batches of any
+    // mesh : all the batches are then compared with each other
+    bool spansMeshes = false;
+    for (int i=0; i<nbatches; ++i)
+        spansMeshes |= batches[i].GetMeshIndex()<0;
+
+    // the batches of each mesh, in dispatch order
+    std::vector<std::vector<int> > meshBatches;
+    for (int i=0; i<nbatches; ++i) {
+        int mesh = spansMeshes ? 0 : batches[i].GetMeshIndex();
+        if (mesh>=(int)meshBatches.size())
+            meshBatches.resize(mesh+1);
+        meshBatches[mesh].push_back(i);
+    }
+
+    // a batch depends on the earlier batches of its mesh it conflicts with,
+    // and runs in the wave after the last of them
+    std::vector<int> waves(nbatches, 0);
+    std::vector<std::vector<int> > dependencies(nbatches);
+
+    int nwaves = nbatches ? 1 : 0;
+    for (int m=0; m<(int)meshBatches.size(); ++m) {
+        std::vector<int> const & mbatches = meshBatches[m];
+        for (int j=0; j<(int)mbatches.size(); ++j) {
+            int batch = mbatches[j];
+            for (int i=0; i<j; ++i) {
+                if (IsDependent(batches[mbatches[i]], batches[batch])) {
+                    dependencies[batch].push_back(mbatches[i]);
+                    waves[batch] = std::max(waves[batch], waves[mbatches[i]]+1);
+                }
+            }
+            nwaves = std::max(nwaves, waves[batch]+1);
+        }
+    }
+
+    _dependencyOffsets.resize(nbatches+1, 0);
+    for (int i=0; i<nbatches; ++i) {
+        _dependencyOffsets[i+1] = _dependencyOffsets[i]+(int)dependencies[i].size();
+        _dependencies.insert(_dependencies.end(), dependencies[i].begin(), dependencies[i].end());
+    }
+
+    _waveOffsets.resize(nwaves+1, 0);
+    for (int i=0; i<nbatches; ++i)
+        ++_waveOffsets[waves[i]+1];
+    for (int i=0; i<nwaves; ++i)
+        _waveOffsets[i+1] += _waveOffsets[i];
+
+    _waveBatches.resize(nbatches);
+    std::vector<int> fill(_waveOffsets.begin(), _waveOffsets.end()-1);
+    for (int i=0; i<nbatches; ++i)
+        _waveBatches[fill[waves[i]]++] = i;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_KERNEL_BATCH_GRAPH_H */
@@ -0,0 +1,447 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_KERNEL_STATS_H
+#define FAR_KERNEL_STATS_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <time.h>
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+    #include <cstring>
+#else
+    #include <sys/time.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Per-kernel instrumentation counters.
+///
+/// When OpenSubdiv is built with OPENSUBDIV_KERNEL_STATS defined (cmake
+/// -DKERNEL_STATS=1), FarDispatcher::Refine records the time spent in each
+/// kernel batch into the current FarKernelStats, along with the number of
+/// vertices computed and an estimate of the memory traffic of the batch,
+/// per kernel type and level. Without the define, the dispatcher does not
+/// reference the stats at all.
+///
+/// The traffic is estimated from the size of a vertex, set by the compute
+/// context when the buffers are bound (see SetVertexSize()), and from the
+/// average number of vertices gathered by each kernel on regular topology
+/// (4 for a quad face, 2 * valence 4 + 1 for a Catmark vertex, ...) : it
+/// gives the order of magnitude of the effective bandwidth of a kernel, not
+/// the exact traffic of an irregular mesh.
+///
+/// On Linux, the last level cache misses of the refining thread can also be
+/// counted (see EnableCacheMisses()).
+///
+/// OsdThreadPoolComputeController records its wave refinement (see
+/// FarKernelBatchGraph) per wave : the time of a wave is shared between its
+/// concurrent batches in proportion to their vertices, and its cache misses
+/// are not counted.
+///
+/// The counters are not thread safe, and the current stats is a single
+/// global : refinements recorded into the same stats must not run
+/// concurrently, so no stats may be current while an OsdRefineScheduler or
+/// an asynchronous controller is refining. The times of the asynchronous
+/// (GPU) controllers only cover the launch of their kernels.
+///
+/// Example :
+///
+///     FarKernelStats stats;
+///     FarKernelStats::SetCurrent(&stats);
+///     controller->Refine(context, batches, vertexBuffer);
+///     FarKernelStats::SetCurrent(0);
+///     stats.PrintStats(std::cout);
+///
+class FarKernelStats {
+
+public:
+
+    /// \brief Counters of a kernel type at a given level
+    struct Counters {
+
+        Counters() : numBatches(0), numVertices(0), bytesRead(0),
+                     bytesWritten(0), cacheMisses(0), seconds(0.0) { }
+
+        /// Returns the effective bandwidth of the kernel in GB/s
+        double GetBandwidth() const {
+            return seconds > 0.0 ? (bytesRead + bytesWritten) / seconds * 1e-9 : 0.0;
+        }
+
+        int       numBatches;     ///< number of batches applied
+        long long numVertices,    ///< number of vertices computed
+                  bytesRead,      ///< estimated bytes read
+                  bytesWritten,   ///< estimated bytes written
+                  cacheMisses;    ///< cache misses (when enabled)
+        double    seconds;        ///< wall time
+    };
+
+    /// \brief Start of a measured batch
+    struct Sample {
+        double    time;
+        long long cacheMisses;
+    };
+
+    /// Constructor
+    FarKernelStats() : _vertexSize(3 * sizeof(float)), _perfEvent(-1) { }
+
+    /// Destructor
+    ~FarKernelStats() {
+        EnableCacheMisses(false);
+    }
+
+    /// Returns the stats the dispatcher records into (null by default)
+    static FarKernelStats * GetCurrent() {
+        return *getCurrent();
+    }
+
+    /// Sets the stats the dispatcher records into (null stops the recording)
+    static void SetCurrent(FarKernelStats * stats) {
+        *getCurrent() = stats;
+    }
+
+    /// Returns the name of a kernel type
+    static char const * GetKernelName(int kernelType) {
+        static char const * names[] = {
+            "CATMARK_FACE_VERTEX",
+            "CATMARK_EDGE_VERTEX",
+            "CATMARK_VERT_VERTEX_A1",
+            "CATMARK_VERT_VERTEX_A2",
+            "CATMARK_VERT_VERTEX_B",
+            "LOOP_EDGE_VERTEX",
+            "LOOP_VERT_VERTEX_A1",
+            "LOOP_VERT_VERTEX_A2",
+            "LOOP_VERT_VERTEX_B",
+            "BILINEAR_FACE_VERTEX",
+            "BILINEAR_EDGE_VERTEX",
+            "BILINEAR_VERT_VERTEX",
+            "HIERARCHICAL_EDIT",
+        };
+        return (kernelType >= 0 and kernelType < NUM_KERNEL_TYPES) ? names[kernelType] : "UNKNOWN";
+    }
+
+    /// Returns a time stamp in seconds
+    static double GetTime() {
+#if defined(_WIN32)
+        LARGE_INTEGER counter, frequency;
+        QueryPerformanceCounter(&counter);
+        QueryPerformanceFrequency(&frequency);
+        return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined(__linux__)
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return t.tv_sec + t.tv_nsec * 1e-9;
+#else
+        struct timeval t;
+        gettimeofday(&t, 0);
+        return t.tv_sec + t.tv_usec * 1e-6;
+#endif
+    }
+
+    /// Sets the size in bytes of the vertex and varying data of a vertex
+    void SetVertexSize(int vertexSize) {
+        _vertexSize = vertexSize;
+    }
+
+    /// Returns the size in bytes of the vertex and varying data of a vertex
+    int GetVertexSize() const {
+        return _vertexSize;
+    }
+
+    /// Counts the last level cache misses of the calling thread (Linux only).
+    /// Returns false if the counter is not available (permissions, virtual
+    /// machines, other systems).
+    bool EnableCacheMisses(bool enable) {
+#if defined(__linux__)
+        if (enable and _perfEvent < 0) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            _perfEvent = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        } else if (not enable and _perfEvent >= 0) {
+            close(_perfEvent);
+            _perfEvent = -1;
+        }
+        return enable == (_perfEvent >= 0);
+#else
+        return not enable;
+#endif
+    }
+
+    /// Returns true if the cache misses are counted
+    bool GetCacheMissesEnabled() const {
+        return _perfEvent >= 0;
+    }
+
+    /// Starts measuring a batch
+    Sample Begin() const {
+        Sample sample;
+        sample.cacheMisses = readCacheMisses();
+        sample.time = GetTime();
+        return sample;
+    }
+
+    /// Records a batch started with Begin()
+    void End(FarKernelBatch const & batch, Sample const & sample) {
+        double time = GetTime();
+        Record(batch, time - sample.time, readCacheMisses() - sample.cacheMisses);
+    }
+
+    /// Records a batch
+    ///
+    /// @param batch        the batch applied
+    ///
+    /// @param seconds      the time spent applying the batch
+    ///
+    /// @param cacheMisses  the cache misses of the batch
+    ///
+    void Record(FarKernelBatch const & batch, double seconds, long long cacheMisses=0) {
+
+        int level = batch.GetLevel(),
+            kernelType = batch.GetKernelType();
+        if (level < 0)
+            return;
+        if (level >= (int)_counters.size())
+            _counters.resize(level + 1, std::vector<Counters>(NUM_KERNEL_TYPES));
+
+        int numVertices = batch.GetEnd() - batch.GetStart();
+
+        Counters & counters = _counters[level][kernelType];
+        ++counters.numBatches;
+        counters.numVertices += numVertices;
+        counters.bytesRead += (long long)numVertices * getBytesRead(kernelType);
+        counters.bytesWritten += (long long)numVertices * _vertexSize;
+        counters.cacheMisses += cacheMisses;
+        counters.seconds += seconds;
+    }
+
+    /// Resets all the counters
+    void Reset() {
+        _counters.clear();
+    }
+
+    /// Returns the number of levels recorded
+    int GetNumLevels() const {
+        return (int)_counters.size();
+    }
+
+    /// Returns the counters of a kernel type at a level
+    Counters const & GetCounters(int kernelType, int level) const {
+        static Counters empty;
+        return level < (int)_counters.size() ? _counters[level][kernelType] : empty;
+    }
+
+    /// Returns the sum of the counters of all kernel types and levels
+    Counters GetTotal() const {
+        Counters total;
+        for (int level = 0; level < (int)_counters.size(); ++level)
+            for (int kernelType = 0; kernelType < NUM_KERNEL_TYPES; ++kernelType)
+                add(total, _counters[level][kernelType]);
+        return total;
+    }
+
+    /// Prints a table of the counters
+    void PrintStats(std::ostream & out) const {
+
+        out << "level kernel                  batches   vertices        ms    MB read MB written    GB/s";
+        if (GetCacheMissesEnabled())
+            out << "  cache misses";
+        out << "\n";
+
+        for (int level = 0; level < (int)_counters.size(); ++level) {
+            for (int kernelType = 0; kernelType < NUM_KERNEL_TYPES; ++kernelType) {
+                Counters const & counters = _counters[level][kernelType];
+                if (counters.numBatches == 0)
+                    continue;
+                char line[256];
+                snprintf(line, sizeof(line), "%5d %-22s %8d %10lld %9.3f %10.3f %10.3f %7.2f",
+                         level, GetKernelName(kernelType), counters.numBatches,
+                         counters.numVertices, counters.seconds * 1e3,
+                         counters.bytesRead * 1e-6, counters.bytesWritten * 1e-6,
+                         counters.GetBandwidth());
+                out << line;
+                if (GetCacheMissesEnabled())
+                    out << "  " << counters.cacheMisses;
+                out << "\n";
+            }
+        }
+
+        Counters total = GetTotal();
+        char line[256];
+        snprintf(line, sizeof(line), "total %-22s %8d %10lld %9.3f %10.3f %10.3f %7.2f",
+                 "", total.numBatches, total.numVertices, total.seconds * 1e3,
+                 total.bytesRead * 1e-6, total.bytesWritten * 1e-6, total.GetBandwidth());
+        out << line;
+        if (GetCacheMissesEnabled())
+            out << "  " << total.cacheMisses;
+        out << "\n";
+    }
+
+    /// Writes the counters as a JSON object
+    void WriteJSON(std::ostream & out) const {
+
+        out << "{\n  \"vertexSize\": " << _vertexSize << ",\n  \"kernels\": [";
+
+        bool first = true;
+        for (int level = 0; level < (int)_counters.size(); ++level) {
+            for (int kernelType = 0; kernelType < NUM_KERNEL_TYPES; ++kernelType) {
+                Counters const & counters = _counters[level][kernelType];
+                if (counters.numBatches == 0)
+                    continue;
+                out << (first ? "\n" : ",\n");
+                first = false;
+
+                char line[512];
+                snprintf(line, sizeof(line),
+                         "    { \"kernel\": \"%s\", \"level\": %d, \"batches\": %d, "
+                         "\"vertices\": %lld, \"seconds\": %.9f, \"bytesRead\": %lld, "
+                         "\"bytesWritten\": %lld, \"bandwidth\": %.3f",
+                         GetKernelName(kernelType), level, counters.numBatches,
+                         counters.numVertices, counters.seconds, counters.bytesRead,
+                         counters.bytesWritten, counters.GetBandwidth());
+                out << line;
+                if (GetCacheMissesEnabled())
+                    out << ", \"cacheMisses\": " << counters.cacheMisses;
+                out << " }";
+            }
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+
+    enum { NUM_KERNEL_TYPES = FarKernelBatch::HIERARCHICAL_EDIT + 1 };
+
+    FarKernelStats(FarKernelStats const &);
+    FarKernelStats & operator = (FarKernelStats const &);
+
+    static FarKernelStats ** getCurrent() {
+        static FarKernelStats * current = 0;
+        return &current;
+    }
+
+    static void add(Counters & total, Counters const & counters) {
+        total.numBatches += counters.numBatches;
+        total.numVertices += counters.numVertices;
+        total.bytesRead += counters.bytesRead;
+        total.bytesWritten += counters.bytesWritten;
+        total.cacheMisses += counters.cacheMisses;
+        total.seconds += counters.seconds;
+    }
+
+    // estimated bytes read per vertex computed : gathered vertices and
+    // subdivision table entries, on regular topology
+    long long getBytesRead(int kernelType) const {
+
+        // gathered vertices, table bytes
+        static int const reads[NUM_KERNEL_TYPES][2] = {
+            { 4, 24 },      // CATMARK_FACE_VERTEX    : quad, F_ITa + F_IT
+            { 4, 24 },      // CATMARK_EDGE_VERTEX    : E_IT + E_W
+            { 3, 24 },      // CATMARK_VERT_VERTEX_A1 : V_ITa + V_W
+            { 4, 24 },      // CATMARK_VERT_VERTEX_A2 : accumulates into the vertex
+            { 9, 56 },      // CATMARK_VERT_VERTEX_B  : valence 4, V_ITa + V_W + V_IT
+            { 4, 24 },      // LOOP_EDGE_VERTEX
+            { 3, 24 },      // LOOP_VERT_VERTEX_A1
+            { 4, 24 },      // LOOP_VERT_VERTEX_A2
+            { 7, 48 },      // LOOP_VERT_VERTEX_B     : valence 6
+            { 4, 24 },      // BILINEAR_FACE_VERTEX
+            { 2,  8 },      // BILINEAR_EDGE_VERTEX
+            { 1,  4 },      // BILINEAR_VERT_VERTEX
+            { 1,  0 },      // HIERARCHICAL_EDIT      : edit values
+        };
+        return (long long)reads[kernelType][0] * _vertexSize + reads[kernelType][1];
+    }
+
+    long long readCacheMisses() const {
+#if defined(__linux__)
+        long long count = 0;
+        if (_perfEvent >= 0 and read(_perfEvent, &count, sizeof(count)) != sizeof(count))
+            count = 0;
+        return count;
+#else
+        return 0;
+#endif
+    }
+
+    std::vector<std::vector<Counters> > _counters;  // [level][kernel type]
+
+    int _vertexSize,  // bytes of vertex and varying data per vertex
+        _perfEvent;   // perf event file descriptor of the cache misses
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // FAR_KERNEL_STATS_H
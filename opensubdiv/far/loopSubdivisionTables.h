@@ -83,6 +83,7 @@ public:
 private:
     template <class X, class Y> friend class FarLoopSubdivisionTablesFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
     template <class CONTROLLER> friend class FarComputeController;
 
     FarLoopSubdivisionTables( FarMesh<U> * mesh, int maxlevel );
@@ -0,0 +1,236 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_MEMORY_REPORT_H
+#define FAR_MEMORY_REPORT_H
+
+#include "../version.h"
+
+#include "../far/table.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+template <class T> class HbrMesh;
+
+/// \brief Per-component breakdown of the memory used by Hbr, Far and Osd
+/// objects.
+///
+/// The objects list the arrays they own into a report with their
+/// ReportMemoryUsage() method, under a name prefixed by the caller
+/// ("car.far.subdivision.E_IT"), so that the memory of a whole scene can be
+/// gathered into a single report and broken down by asset or by table. The
+/// size of an array is the size of its allocation (the capacity of the
+/// std::vectors), not the size of its content. The memory of an HbrMesh is
+/// added with AddHbrMesh().
+///
+/// FarMeshFactory records the peak of the memory used while it creates a
+/// mesh (see FarMeshFactory::GetPeakMemoryUsed()), which may be recorded in
+/// the report with UpdatePeak().
+///
+/// Example :
+///
+///     FarMemoryReport report;
+///     FarMemoryReport::AddHbrMesh(report, hmesh, "car.hbr.");
+///     farMesh->ReportMemoryUsage(report, "car.far.");
+///     computeContext->ReportMemoryUsage(report, "car.osd.");
+///     report.WriteJSON(std::cout);
+///
+class FarMemoryReport {
+
+public:
+
+    /// Constructor
+    FarMemoryReport() : _peak(0) { }
+
+    /// Adds 'bytes' to a component (created on first use)
+    void Add(std::string const & component, size_t bytes) {
+        for (int i = 0; i < (int)_components.size(); ++i) {
+            if (_components[i].name == component) {
+                _components[i].bytes += bytes;
+                return;
+            }
+        }
+        _components.push_back(Component(component, bytes));
+    }
+
+    /// Adds the allocation of a vector to a component
+    template <class T>
+    void Add(std::string const & component, std::vector<T> const & array) {
+        Add(component, array.capacity() * sizeof(T));
+    }
+
+    /// Adds the allocation of a Far table to a component (none for a table
+    /// referencing memory)
+    template <class T>
+    void Add(std::string const & component, FarTable<T> const & table) {
+        Add(component, table.capacity() * sizeof(T));
+    }
+
+    /// Adds the memory of an HbrMesh : its faces, vertices and face children
+    /// blocks, and its arrays
+    template <class T>
+    static void AddHbrMesh(FarMemoryReport & report, HbrMesh<T> const * mesh,
+                           std::string const & prefix=std::string()) {
+        report.Add(prefix + "faces", mesh->GetFaceMemStats());
+        report.Add(prefix + "vertices", mesh->GetVertexMemStats());
+        report.Add(prefix + "faceChildren", mesh->GetFaceChildrenMemStats());
+        report.Add(prefix + "arrays", mesh->GetArrayMemStats());
+    }
+
+    /// Returns the number of components
+    int GetNumComponents() const {
+        return (int)_components.size();
+    }
+
+    /// Returns the name of a component
+    std::string const & GetComponentName(int component) const {
+        return _components[component].name;
+    }
+
+    /// Returns the size in bytes of a component
+    size_t GetComponentSize(int component) const {
+        return _components[component].bytes;
+    }
+
+    /// Returns the size in bytes of the components whose name starts with
+    /// 'prefix'
+    size_t GetSize(std::string const & prefix) const {
+        size_t result = 0;
+        for (int i = 0; i < (int)_components.size(); ++i)
+            if (_components[i].name.compare(0, prefix.size(), prefix) == 0)
+                result += _components[i].bytes;
+        return result;
+    }
+
+    /// Returns the size in bytes of all the components
+    size_t GetTotal() const {
+        return GetSize(std::string());
+    }
+
+    /// Raises the recorded peak usage to 'bytes'
+    void UpdatePeak(size_t bytes) {
+        if (bytes > _peak)
+            _peak = bytes;
+    }
+
+    /// Returns the peak usage : the largest of the peak recorded and of the
+    /// total of the components
+    size_t GetPeak() const {
+        size_t total = GetTotal();
+        return _peak > total ? _peak : total;
+    }
+
+    /// Removes all the components and the peak
+    void Clear() {
+        _components.clear();
+        _peak = 0;
+    }
+
+    /// Prints the components, the total and the peak
+    void PrintReport(std::ostream & out) const {
+        for (int i = 0; i < (int)_components.size(); ++i)
+            out << _components[i].name << " : " << _components[i].bytes << " bytes\n";
+        out << "total : " << GetTotal() << " bytes\n"
+            << "peak : " << GetPeak() << " bytes\n";
+    }
+
+    /// Writes the components, the total and the peak as a JSON object
+    void WriteJSON(std::ostream & out) const {
+
+        out << "{\n  \"total\": " << GetTotal() << ",\n  \"peak\": " << GetPeak()
+            << ",\n  \"components\": [";
+
+        for (int i = 0; i < (int)_components.size(); ++i) {
+            out << (i ? ",\n" : "\n") << "    { \"name\": \"";
+            writeEscaped(out, _components[i].name);
+            out << "\", \"bytes\": " << _components[i].bytes << " }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+
+    struct Component {
+        Component(std::string const & n, size_t b) : name(n), bytes(b) { }
+
+        std::string name;
+        size_t      bytes;
+    };
+
+    static void writeEscaped(std::ostream & out, std::string const & s) {
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == '"' or s[i] == '\\')
+                out << '\\';
+            out << s[i];
+        }
+    }
+
+    std::vector<Component> _components;
+
+    size_t _peak;
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_MEMORY_REPORT_H */
@@ -119,13 +119,34 @@ public:
     /// scheme to the vertices in the mesh.    
     const FarKernelBatchVector & GetKernelBatches() const { return _batches; }
 
+    /// Adds the memory allocated by the mesh to a report : the subdivision,
+    /// patch and vertex edit tables ("subdivision.", "patches." and
+    /// "vertexEdits." components), the kernel batches and the vertices
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the tables in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report, std::string const & prefix=std::string()) const {
+        if (_subdivisionTables)
+            _subdivisionTables->ReportMemoryUsage(report, prefix + "subdivision.");
+        if (_patchTables)
+            _patchTables->ReportMemoryUsage(report, prefix + "patches.");
+        if (_vertexEditTables)
+            _vertexEditTables->ReportMemoryUsage(report, prefix + "vertexEdits.");
+        report.Add(prefix + "batches", _batches);
+        report.Add(prefix + "vertices", _vertices);
+    }
+
 private:
     // Note : the vertex classes are renamed <X,Y> so as not to shadow the 
     // declaration of the templated vertex class U.
     template <class X, class Y> friend class FarMeshFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyRefiner;
 
-    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0) { }
+    FarMesh() : _subdivisionTables(0), _patchTables(0), _vertexEditTables(0), _storage(0) { }
 
     // non-copyable, so these are not implemented:
     FarMesh(FarMesh<U> const &);
@@ -149,6 +170,9 @@ private:
     int _totalFVarWidth;    // width of the face-varying data 
 
     int _numPtexFaces;
+
+    // memory referenced by the tables (see FarMeshSerializer)
+    FarTableStorage * _storage;
 };
 
 template <class U>
@@ -157,6 +181,7 @@ FarMesh<U>::~FarMesh()
     delete _subdivisionTables;
     delete _patchTables;
     delete _vertexEditTables;
+    delete _storage;
 }
 
 } // end namespace OPENSUBDIV_VERSION
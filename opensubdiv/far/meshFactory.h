@@ -73,6 +73,8 @@
 
 #include "../far/mesh.h"
 #include "../far/dispatcher.h"
+#include "../far/memoryReport.h"
+#include "../far/trace.h"
 #include "../far/bilinearSubdivisionTablesFactory.h"
 #include "../far/catmarkSubdivisionTablesFactory.h"
 #include "../far/loopSubdivisionTablesFactory.h"
@@ -169,12 +171,36 @@ public:
     ///
     int GetVertexID( HbrVertex<T> * v );
 
+    /// Orders the refined vertices of each type by a breadth-first traversal
+    /// of the faces, instead of the order in which the coarse faces were
+    /// declared : the vertices gathered by the compute kernels are then close
+    /// to each other, which saves cache misses on large meshes with a
+    /// scattered face order. The batches of kernels are unchanged. Must be set
+    /// before Create().
+    ///
+    /// @param enable  true to enable the locality ordering (disabled by default)
+    ///
+    void SetLocalityOrdering( bool enable ) { _localityOrdering = enable; }
+
+    /// Returns true if the refined vertices are ordered for locality
+    bool GetLocalityOrdering() const { return _localityOrdering; }
+
     /// Returns a the mapping between HbrVertex<T>->GetID() and Far vertices indices
     ///
     /// @return the table that maps HbrMesh to FarMesh vertex indices
     ///
     std::vector<int> const & GetRemappingTable( ) const { return _remapTable; }
 
+    /// Returns the peak of the memory used by the HbrMesh, the transient
+    /// arrays of the factory and the tables of the FarMesh, as sampled after
+    /// the refinement of the HbrMesh and after the creation of each table
+    /// (see FarMemoryReport). The allocations internal to the creation of a
+    /// table are not included.
+    ///
+    /// @return the peak memory in bytes
+    ///
+    size_t GetPeakMemoryUsed() const { return _peakMemory; }
+
 private:
     friend class FarBilinearSubdivisionTablesFactory<T,U>;
     friend class FarCatmarkSubdivisionTablesFactory<T,U>;
@@ -218,6 +244,9 @@ private:
 
     // Adaptively refine the Hbr mesh
     int refineAdaptive( HbrMesh<T> * mesh, int maxIsolate );
+
+    // Samples the memory used by the Hbr mesh, the factory and 'mesh'
+    void updatePeakMemory( FarMesh<U> const * mesh );
     
     typedef std::vector<std::vector< HbrFace<T> *> > FacesList;
     
@@ -227,7 +256,8 @@ private:
 private:
     HbrMesh<T> * _hbrMesh;
 
-    bool _adaptive;
+    bool _adaptive,
+         _localityOrdering;
 
     int _maxlevel,
         _numVertices,
@@ -241,6 +271,8 @@ private:
     std::vector<int> _remapTable;
 
     FacesList _facesList;
+
+    size_t _peakMemory;
 };
 
 template <class T, class U>
@@ -592,14 +624,18 @@ template <class T, class U>
 FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adaptive ) :
     _hbrMesh(mesh),
     _adaptive(adaptive),
+    _localityOrdering(false),
     _maxlevel(maxlevel),
     _numVertices(-1),
     _numCoarseVertices(-1),
     _numFaces(-1),
     _maxValence(4),
     _numPtexFaces(-1),
-    _facesList(maxlevel+1)
+    _facesList(maxlevel+1),
+    _peakMemory(0)
 {
+    FAR_TRACE_SCOPE("FarMeshFactory::FarMeshFactory", "far");
+
     _numCoarseVertices = mesh->GetNumVertices();
     _numPtexFaces = getNumPtexFaces(mesh);
     
@@ -607,10 +643,13 @@ FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adapt
     //
     // Note : using a placeholder vertex class 'T' can greatly speed up the 
     // topological analysis if the interpolation results are not used.
-    if (adaptive)
+    if (adaptive) {
+        FAR_TRACE_SCOPE("FarMeshFactory::refineAdaptive", "hbr");
         _maxlevel=refineAdaptive( mesh, maxlevel );
-    else
+    } else {
+        FAR_TRACE_SCOPE("FarMeshFactory::refine", "hbr");
         refine( mesh, maxlevel);
+    }
     
     _numFaces = mesh->GetNumFaces();
 
@@ -638,6 +677,27 @@ FarMeshFactory<T,U>::FarMeshFactory( HbrMesh<T> * mesh, int maxlevel, bool adapt
                 _facesList[ f->GetDepth() ].push_back(f);
         }
     }
+
+    updatePeakMemory(0);
+}
+
+template <class T, class U> void
+FarMeshFactory<T,U>::updatePeakMemory( FarMesh<U> const * mesh ) {
+
+    FarMemoryReport report;
+
+    FarMemoryReport::AddHbrMesh(report, _hbrMesh);
+
+    report.Add("remapTable", _remapTable);
+    report.Add("facesList", _facesList);
+    for (int i=0; i<(int)_facesList.size(); ++i)
+        report.Add("facesList", _facesList[i]);
+
+    if (mesh)
+        mesh->ReportMemoryUsage(report);
+
+    report.UpdatePeak(_peakMemory);
+    _peakMemory = report.GetPeak();
 }
 
 template <class T, class U> bool
@@ -772,8 +832,12 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
     if (GetMaxLevel()<1)
         return 0;
 
+    FAR_TRACE_SCOPE("FarMeshFactory::Create", "far");
+
     FarMesh<U> * result = new FarMesh<U>();
     
+    {
+    FAR_TRACE_SCOPE("FarSubdivisionTablesFactory::Create", "far");
     if ( isBilinear( GetHbrMesh() ) ) {
         result->_subdivisionTables = FarBilinearSubdivisionTablesFactory<T,U>::Create(this, result, &result->_batches);
     } else if ( isCatmark( GetHbrMesh() ) ) {
@@ -783,6 +847,7 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
     } else
         assert(0);
     assert(result->_subdivisionTables);
+    }
 
     // If the vertex classes aren't place-holders, copy the data of the coarse
     // vertices into the vertex buffer.
@@ -792,7 +857,11 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
             copyVertex(result->_vertices[i], GetHbrMesh()->GetVertex(i)->GetData());
     }
 
+    updatePeakMemory(result);
+
     // Create the element indices tables (patches for adaptive, quads for non-adaptive)
+    {
+    FAR_TRACE_SCOPE("FarPatchTablesFactory::Create", "far");
     if (isAdaptive()) {
 
         FarPatchTablesFactory<T> factory(GetHbrMesh(), _numFaces, _remapTable);
@@ -804,6 +873,9 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
         result->_patchTables = FarPatchTablesFactory<T>::Create(GetHbrMesh(), _facesList, _remapTable, -1, requireFVarData );
     }
     assert( result->_patchTables );
+    }
+
+    updatePeakMemory(result);
 
     result->_numPtexFaces = _numPtexFaces;
     
@@ -813,8 +885,11 @@ FarMeshFactory<T,U>::Create( bool requireFVarData ) {
 
     // Create VertexEditTables if necessary
     if (GetHbrMesh()->HasVertexEdits()) {
+        FAR_TRACE_SCOPE("FarVertexEditTablesFactory::Create", "far");
         result->_vertexEditTables = FarVertexEditTablesFactory<T,U>::Create( this, result, &result->_batches, GetMaxLevel() );
         assert(result->_vertexEditTables);
+
+        updatePeakMemory(result);
     }
     
     return result;
@@ -0,0 +1,836 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_MESH_SERIALIZER_H
+#define FAR_MESH_SERIALIZER_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/bilinearSubdivisionTables.h"
+#include "../far/catmarkSubdivisionTables.h"
+#include "../far/loopSubdivisionTables.h"
+#include "../far/patchTables.h"
+#include "../far/vertexEditTables.h"
+#include "../far/trace.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Binary serialization of FarMesh.
+///
+/// Saves the topology of a FarMesh (subdivision tables, kernel batches, patch
+/// tables and hierarchical edit tables) into a versioned binary image, and
+/// creates meshes back from it without Hbr.
+///
+/// The image starts with a 64 bytes header followed by a table of sections,
+/// one per array. Each array is stored in native byte order and aligned on 64
+/// bytes, in the layout of the tables : the subdivision tables of a mesh can
+/// reference the arrays of its image in place (see FarTable), without parsing
+/// or copying them. Create(char const *) maps the file in memory and releases
+/// the mapping along with the mesh. The kernel batches, patch tables and
+/// hierarchical edits are converted into the classes of the mesh, and always
+/// copied. Images written by a different version of the format, byte order or
+/// vertex class are rejected, as well as images whose checksum does not match
+/// or whose kernel batches would address vertices or table entries out of
+/// range.
+///
+/// The vertex data of the mesh is not saved : with a non-placeholder vertex
+/// class, the vertices of the created mesh are default constructed and the
+/// coarse vertices must be set by the client before refining.
+///
+template <class U> class FarMeshSerializer {
+
+public:
+
+    enum { VERSION = 2 };
+
+    /// Returns the size in bytes of the image of a mesh
+    static size_t GetSize(FarMesh<U> const * mesh);
+
+    /// Writes the image of a mesh
+    ///
+    /// @param mesh  the mesh to serialize
+    ///
+    /// @param data  destination of GetSize(mesh) bytes (aligned on 64 bytes
+    ///              for the arrays to be aligned)
+    ///
+    static void Write(FarMesh<U> const * mesh, void * data);
+
+    /// Writes the image of a mesh into a file, returns false on error
+    static bool Write(FarMesh<U> const * mesh, char const * path);
+
+    /// Returns true if 'data' holds a valid image of this version
+    static bool IsValid(void const * data, size_t size);
+
+    /// Creates a mesh from an image, returns NULL if the image is not valid
+    ///
+    /// @param data  the image written by Write()
+    ///
+    /// @param size  the number of bytes available at 'data'
+    ///
+    /// @param copy  copies the arrays of the image into the subdivision
+    ///              tables. Otherwise the tables reference the arrays of the
+    ///              image, which must neither be modified nor released during
+    ///              the lifetime of the mesh.
+    ///
+    static FarMesh<U> * Create(void const * data, size_t size, bool copy=true);
+
+    /// Creates a mesh from an image file, returns NULL if the file cannot be
+    /// read or is not valid. The file is mapped in memory when possible (read
+    /// otherwise) and referenced by the subdivision tables of the mesh until
+    /// the mesh is deleted.
+    static FarMesh<U> * Create(char const * path);
+
+private:
+
+    enum Scheme {
+        SCHEME_BILINEAR,
+        SCHEME_CATMARK,
+        SCHEME_LOOP
+    };
+
+    enum SectionType {
+        VERTS_OFFSETS,
+        F_ITA,
+        F_IT,
+        E_IT,
+        E_W,
+        V_ITA,
+        V_IT,
+        V_W,
+        KERNEL_BATCHES,     // 8 ints per batch
+        PATCH_ARRAYS,       // 7 unsigned ints per array
+        PATCH_TABLE,
+        VERTEX_VALENCES,
+        QUAD_OFFSETS,
+        PATCH_PARAMS,
+        FVAR_DATA,
+        EDIT_BATCHES,       // 7 ints per batch
+        EDIT_INDICES,
+        EDIT_VALUES,
+
+        NUM_SECTIONS
+    };
+
+    enum Flags {
+        HAS_PATCH_TABLES = 1,
+        HAS_VERTEX_EDITS = 2
+    };
+
+    struct Header {
+        char magic[8];              // "FARMESH\0"
+        unsigned int version,
+                     byteOrder,     // 0x01020304 in the byte order of the writer
+                     headerSize,
+                     numSections,
+                     scheme,
+                     vertexSize,    // sizeof(U)
+                     flags;
+        int totalFVarWidth,
+            numPtexFaces,
+            maxValence;
+        unsigned int checksum;      // of the image, with this field cleared
+        unsigned long long size;    // total size of the image
+    };
+
+    struct Section {
+        unsigned int type,
+                     elementSize;
+        unsigned long long offset,  // from the start of the image
+                           count;   // number of elements
+    };
+
+    // layout of an image : the sections and the arrays they are copied from
+    struct Layout {
+        Header header;
+        Section sections[NUM_SECTIONS];
+        void const * arrays[NUM_SECTIONS];
+
+        // arrays converted from the classes of the mesh
+        std::vector<int> batches,
+                         editBatches;
+        std::vector<unsigned int> patchArrays,
+                                  editIndices;
+        std::vector<float> editValues;
+    };
+
+    static size_t align(size_t offset) {
+        return (offset + 63) & ~(size_t)63;
+    }
+
+    template <class TABLE>
+    static void addSection(Layout & layout, int type, TABLE const & array) {
+        layout.sections[type].elementSize = sizeof(typename TABLE::value_type);
+        layout.sections[type].count = array.size();
+        layout.arrays[type] = array.empty() ? 0 : &array[0];
+    }
+
+    static void buildLayout(FarMesh<U> const * mesh, Layout & layout);
+
+    template <class T>
+    static bool readSection(unsigned char const * image, int type, std::vector<T> & array);
+
+    template <class T>
+    static bool readSection(unsigned char const * image, int type, FarTable<T> & table, bool copy);
+
+    // an image file referenced by the tables of a mesh : mapped in memory
+    // when possible, read otherwise
+    class FileImage : public FarTableStorage {
+    public:
+        FileImage() : _data(0), _size(0), _mapped(false) { }
+
+        virtual ~FileImage() {
+#if defined(__unix__) || defined(__APPLE__)
+            if (_mapped)
+                munmap(_data, _size);
+#endif
+        }
+
+        bool Open(char const * path);
+
+        void const * GetData() const {
+            return _data;
+        }
+
+        size_t GetSize() const {
+            return _size;
+        }
+
+    private:
+        void * _data;
+        size_t _size;
+        bool _mapped;
+        std::vector<unsigned char> _buffer;  // the content of a file not mapped
+    };
+
+    static char const * getMagic() {
+        return "FARMESH";
+    }
+
+    static unsigned int computeChecksum(unsigned char const * image, size_t size);
+
+    static void hashWords(unsigned long long lanes[4], void const * data, size_t size) {
+        unsigned char const * bytes = static_cast<unsigned char const *>(data);
+        for (size_t i = 0; i + 16 <= size; i += 16) {
+            unsigned int words[4];
+            memcpy(words, bytes + i, 16);
+            for (int j = 0; j < 4; ++j)
+                lanes[j] = (lanes[j] ^ words[j]) * 1099511628211ULL;
+        }
+    }
+
+    static bool isValidBatch(FarKernelBatch const & batch,
+                             FarSubdivisionTables<U> const * tables,
+                             FarVertexEditTables<U> const * editTables);
+};
+
+template <class U> void
+FarMeshSerializer<U>::buildLayout(FarMesh<U> const * mesh, Layout & layout) {
+
+    assert(mesh and mesh->_subdivisionTables);
+
+    Header & header = layout.header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, getMagic(), 8);
+    header.version = VERSION;
+    header.byteOrder = 0x01020304;
+    header.headerSize = sizeof(Header);
+    header.numSections = NUM_SECTIONS;
+    header.vertexSize = sizeof(U);
+    header.totalFVarWidth = mesh->_totalFVarWidth;
+    header.numPtexFaces = mesh->_numPtexFaces;
+
+    memset(layout.sections, 0, sizeof(layout.sections));
+    for (int i = 0; i < NUM_SECTIONS; ++i) {
+        layout.sections[i].type = i;
+        layout.arrays[i] = 0;
+    }
+
+    // subdivision tables
+    FarSubdivisionTables<U> const * tables = mesh->_subdivisionTables;
+
+    if (dynamic_cast<FarCatmarkSubdivisionTables<U> const *>(tables)) {
+        header.scheme = SCHEME_CATMARK;
+    } else if (dynamic_cast<FarLoopSubdivisionTables<U> const *>(tables)) {
+        header.scheme = SCHEME_LOOP;
+    } else {
+        assert(dynamic_cast<FarBilinearSubdivisionTables<U> const *>(tables));
+        header.scheme = SCHEME_BILINEAR;
+    }
+
+    addSection(layout, VERTS_OFFSETS, tables->_vertsOffsets);
+    addSection(layout, F_ITA, tables->_F_ITa);
+    addSection(layout, F_IT, tables->_F_IT);
+    addSection(layout, E_IT, tables->_E_IT);
+    addSection(layout, E_W, tables->_E_W);
+    addSection(layout, V_ITA, tables->_V_ITa);
+    addSection(layout, V_IT, tables->_V_IT);
+    addSection(layout, V_W, tables->_V_W);
+
+    // kernel batches
+    FarKernelBatchVector const & batches = mesh->_batches;
+    layout.batches.reserve(batches.size() * 8);
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        FarKernelBatch const & batch = batches[i];
+        int values[8] = { batch.GetKernelType(), batch.GetLevel(), batch.GetTableIndex(),
+                          batch.GetStart(), batch.GetEnd(), batch.GetTableOffset(),
+                          batch.GetVertexOffset(), batch.GetMeshIndex() };
+        layout.batches.insert(layout.batches.end(), values, values + 8);
+    }
+    addSection(layout, KERNEL_BATCHES, layout.batches);
+
+    // patch tables
+    if (FarPatchTables const * patchTables = mesh->_patchTables) {
+        header.flags |= HAS_PATCH_TABLES;
+        header.maxValence = patchTables->GetMaxValence();
+
+        FarPatchTables::PatchArrayVector const & patchArrays = patchTables->GetPatchArrayVector();
+        layout.patchArrays.reserve(patchArrays.size() * 7);
+        for (int i = 0; i < (int)patchArrays.size(); ++i) {
+            FarPatchTables::PatchArray const & patchArray = patchArrays[i];
+            FarPatchTables::Descriptor desc = patchArray.GetDescriptor();
+            unsigned int values[7] = { (unsigned int)desc.GetType(), (unsigned int)desc.GetPattern(),
+                                       desc.GetRotation(), patchArray.GetVertIndex(),
+                                       patchArray.GetPatchIndex(), patchArray.GetNumPatches(),
+                                       patchArray.GetQuadOffsetIndex() };
+            layout.patchArrays.insert(layout.patchArrays.end(), values, values + 7);
+        }
+        addSection(layout, PATCH_ARRAYS, layout.patchArrays);
+        addSection(layout, PATCH_TABLE, patchTables->GetPatchTable());
+        addSection(layout, VERTEX_VALENCES, patchTables->GetVertexValenceTable());
+        addSection(layout, QUAD_OFFSETS, patchTables->GetQuadOffsetTable());
+        addSection(layout, PATCH_PARAMS, patchTables->GetPatchParamTable());
+        addSection(layout, FVAR_DATA, patchTables->GetFVarDataTable());
+    }
+
+    // hierarchical edits : the arrays of the batches are concatenated
+    if (FarVertexEditTables<U> const * editTables = mesh->_vertexEditTables) {
+        header.flags |= HAS_VERTEX_EDITS;
+
+        for (int i = 0; i < editTables->GetNumBatches(); ++i) {
+            typename FarVertexEditTables<U>::VertexEditBatch const & batch = editTables->GetBatch(i);
+
+            int values[7] = { batch.GetPrimvarIndex(), batch.GetPrimvarWidth(), batch.GetOperation(),
+                              (int)layout.editIndices.size(), (int)batch.GetVertexIndices().size(),
+                              (int)layout.editValues.size(), (int)batch.GetValues().size() };
+            layout.editBatches.insert(layout.editBatches.end(), values, values + 7);
+
+            layout.editIndices.insert(layout.editIndices.end(),
+                batch.GetVertexIndices().begin(), batch.GetVertexIndices().end());
+            layout.editValues.insert(layout.editValues.end(),
+                batch.GetValues().begin(), batch.GetValues().end());
+        }
+        addSection(layout, EDIT_BATCHES, layout.editBatches);
+        addSection(layout, EDIT_INDICES, layout.editIndices);
+        addSection(layout, EDIT_VALUES, layout.editValues);
+    }
+
+    // place the arrays after the header and the section table
+    size_t offset = align(sizeof(Header) + sizeof(layout.sections));
+    for (int i = 0; i < NUM_SECTIONS; ++i) {
+        Section & section = layout.sections[i];
+        section.offset = offset;
+        offset = align(offset + (size_t)(section.elementSize * section.count));
+    }
+    header.size = offset;
+}
+
+template <class U> size_t
+FarMeshSerializer<U>::GetSize(FarMesh<U> const * mesh) {
+
+    Layout layout;
+    buildLayout(mesh, layout);
+    return (size_t)layout.header.size;
+}
+
+template <class U> void
+FarMeshSerializer<U>::Write(FarMesh<U> const * mesh, void * data) {
+
+    Layout layout;
+    buildLayout(mesh, layout);
+
+    unsigned char * image = static_cast<unsigned char *>(data);
+
+    // the padding is cleared so that identical meshes give identical images
+    memset(image, 0, (size_t)layout.header.size);
+    memcpy(image, &layout.header, sizeof(Header));
+    memcpy(image + sizeof(Header), layout.sections, sizeof(layout.sections));
+
+    for (int i = 0; i < NUM_SECTIONS; ++i) {
+        Section const & section = layout.sections[i];
+        if (layout.arrays[i])
+            memcpy(image + section.offset, layout.arrays[i],
+                   (size_t)(section.elementSize * section.count));
+    }
+
+    unsigned int checksum = computeChecksum(image, (size_t)layout.header.size);
+    memcpy(image + offsetof(Header, checksum), &checksum, sizeof(checksum));
+}
+
+template <class U> bool
+FarMeshSerializer<U>::Write(FarMesh<U> const * mesh, char const * path) {
+
+    FAR_TRACE_SCOPE("FarMeshSerializer::Write", "far");
+
+    std::vector<unsigned char> image(GetSize(mesh));
+    Write(mesh, &image[0]);
+
+    FILE * file = fopen(path, "wb");
+    if (not file)
+        return false;
+
+    bool result = fwrite(&image[0], 1, image.size(), file) == image.size();
+    return (fclose(file) == 0) and result;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::IsValid(void const * data, size_t size) {
+
+    if (not data or size < sizeof(Header) + NUM_SECTIONS * sizeof(Section))
+        return false;
+
+    unsigned char const * image = static_cast<unsigned char const *>(data);
+
+    Header header;
+    memcpy(&header, image, sizeof(Header));
+
+    if (memcmp(header.magic, getMagic(), 8) != 0 or
+        header.version != VERSION or
+        header.byteOrder != 0x01020304 or
+        header.headerSize != sizeof(Header) or
+        header.numSections != NUM_SECTIONS or
+        header.scheme > SCHEME_LOOP or
+        header.vertexSize != sizeof(U) or
+        header.size > size or
+        header.size % 64 != 0)
+        return false;
+
+    for (int i = 0; i < NUM_SECTIONS; ++i) {
+        Section section;
+        memcpy(&section, image + sizeof(Header) + i * sizeof(Section), sizeof(Section));
+
+        if (section.type != (unsigned int)i or
+            section.offset % 64 != 0 or
+            section.offset > header.size or
+            (section.elementSize != 0 and
+             section.count > (header.size - section.offset) / section.elementSize))
+            return false;
+    }
+
+    // a single pass over the image rejects the corrupted ones
+    return computeChecksum(image, (size_t)header.size) == header.checksum;
+}
+
+// FNV-1a over the 32 bits words of the image, on 4 interleaved lanes : the
+// checksum field of the header is hashed as 0
+template <class U> unsigned int
+FarMeshSerializer<U>::computeChecksum(unsigned char const * image, size_t size) {
+
+    assert(size >= sizeof(Header) and size % 16 == 0);
+
+    Header header;
+    memcpy(&header, image, sizeof(Header));
+    header.checksum = 0;
+
+    unsigned long long lanes[4];
+    for (int i = 0; i < 4; ++i)
+        lanes[i] = 14695981039346656037ULL + i;
+
+    hashWords(lanes, &header, sizeof(Header));
+    hashWords(lanes, image + sizeof(Header), size - sizeof(Header));
+
+    unsigned long long hash = lanes[0];
+    for (int i = 1; i < 4; ++i)
+        hash = (hash ^ lanes[i]) * 1099511628211ULL;
+    return (unsigned int)(hash ^ (hash >> 32));
+}
+
+template <class U> bool
+FarMeshSerializer<U>::isValidBatch(FarKernelBatch const & batch,
+                                   FarSubdivisionTables<U> const * tables,
+                                   FarVertexEditTables<U> const * editTables) {
+
+    std::vector<int> const & vertsOffsets = tables->_vertsOffsets;
+
+    int level = batch.GetLevel();
+    if (level < 1 or level >= (int)vertsOffsets.size() - 1 or
+        batch.GetStart() < 0 or batch.GetStart() > batch.GetEnd())
+        return false;
+
+    // the entries of the tables read by the batch
+    long long first = (long long)batch.GetStart() + batch.GetTableOffset(),
+              last = (long long)batch.GetEnd() + batch.GetTableOffset();
+    if (first < 0)
+        return false;
+
+    if (batch.GetKernelType() == FarKernelBatch::HIERARCHICAL_EDIT) {
+
+        if (not editTables or batch.GetTableIndex() < 0 or
+            batch.GetTableIndex() >= editTables->GetNumBatches())
+            return false;
+
+        // the edits address vertices from the vertex offset
+        std::vector<unsigned int> const & indices =
+            editTables->GetBatch(batch.GetTableIndex()).GetVertexIndices();
+        if (last > (long long)indices.size())
+            return false;
+        for (long long i = first; i < last; ++i) {
+            long long vertex = (long long)indices[(size_t)i] + batch.GetVertexOffset();
+            if (vertex < 0 or vertex >= vertsOffsets.back())
+                return false;
+        }
+        return true;
+    }
+
+    // the kernels compute the vertices of the level of the batch
+    if ((long long)batch.GetVertexOffset() + batch.GetStart() < vertsOffsets[level] or
+        (long long)batch.GetVertexOffset() + batch.GetEnd() > vertsOffsets[level+1])
+        return false;
+
+    switch (batch.GetKernelType()) {
+        case FarKernelBatch::CATMARK_FACE_VERTEX :
+        case FarKernelBatch::BILINEAR_FACE_VERTEX :
+            return 2 * last <= (long long)tables->_F_ITa.size();
+
+        case FarKernelBatch::CATMARK_EDGE_VERTEX :
+        case FarKernelBatch::LOOP_EDGE_VERTEX :
+            return 4 * last <= (long long)tables->_E_IT.size() and
+                   2 * last <= (long long)tables->_E_W.size();
+
+        case FarKernelBatch::BILINEAR_EDGE_VERTEX :
+            return 2 * last <= (long long)tables->_E_IT.size();
+
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A1 :
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A2 :
+        case FarKernelBatch::CATMARK_VERT_VERTEX_B :
+        case FarKernelBatch::LOOP_VERT_VERTEX_A1 :
+        case FarKernelBatch::LOOP_VERT_VERTEX_A2 :
+        case FarKernelBatch::LOOP_VERT_VERTEX_B :
+            return 5 * last <= (long long)tables->_V_ITa.size() and
+                   last <= (long long)tables->_V_W.size();
+
+        case FarKernelBatch::BILINEAR_VERT_VERTEX :
+            return last <= (long long)tables->_V_ITa.size();
+
+        default :
+            return false;
+    }
+}
+
+template <class U>
+template <class T> bool
+FarMeshSerializer<U>::readSection(unsigned char const * image, int type, std::vector<T> & array) {
+
+    Section section;
+    memcpy(&section, image + sizeof(Header) + type * sizeof(Section), sizeof(Section));
+
+    if (section.count == 0) {
+        array.clear();
+        return true;
+    }
+    if (section.elementSize != sizeof(T))
+        return false;
+
+    // a single bulk copy : the array is stored in its in-memory layout
+    array.resize((size_t)section.count);
+    memcpy(&array[0], image + section.offset, (size_t)(section.count * sizeof(T)));
+    return true;
+}
+
+template <class U>
+template <class T> bool
+FarMeshSerializer<U>::readSection(unsigned char const * image, int type, FarTable<T> & table, bool copy) {
+
+    Section section;
+    memcpy(&section, image + sizeof(Header) + type * sizeof(Section), sizeof(Section));
+
+    if (section.count == 0) {
+        table.clear();
+        return true;
+    }
+    if (section.elementSize != sizeof(T))
+        return false;
+
+    T const * data = reinterpret_cast<T const *>(image + section.offset);
+
+    // the array is referenced in place, unless the image is not aligned for
+    // its elements
+    if (not copy and reinterpret_cast<size_t>(data) % sizeof(T) == 0) {
+        table.Reference(data, (size_t)section.count);
+    } else {
+        table.resize((size_t)section.count);
+        memcpy(&table[0], data, (size_t)(section.count * sizeof(T)));
+    }
+    return true;
+}
+
+template <class U> FarMesh<U> *
+FarMeshSerializer<U>::Create(void const * data, size_t size, bool copy) {
+
+    FAR_TRACE_SCOPE("FarMeshSerializer::Create", "far");
+
+    if (not IsValid(data, size))
+        return 0;
+
+    unsigned char const * image = static_cast<unsigned char const *>(data);
+
+    Header header;
+    memcpy(&header, image, sizeof(Header));
+
+    std::vector<int> vertsOffsets;
+    if (not readSection(image, VERTS_OFFSETS, vertsOffsets) or vertsOffsets.size() < 3 or
+        vertsOffsets[0] != 0)
+        return 0;
+
+    // the vertices of each level follow the vertices of the previous levels
+    for (size_t i = 1; i < vertsOffsets.size(); ++i)
+        if (vertsOffsets[i] < vertsOffsets[i-1])
+            return 0;
+
+    int maxlevel = (int)vertsOffsets.size() - 2;
+
+    FarMesh<U> * mesh = new FarMesh<U>();
+    mesh->_totalFVarWidth = header.totalFVarWidth;
+    mesh->_numPtexFaces = header.numPtexFaces;
+
+    FarSubdivisionTables<U> * tables = 0;
+    switch (header.scheme) {
+        case SCHEME_BILINEAR : tables = new FarBilinearSubdivisionTables<U>(mesh, maxlevel); break;
+        case SCHEME_CATMARK  : tables = new FarCatmarkSubdivisionTables<U>(mesh, maxlevel); break;
+        case SCHEME_LOOP     : tables = new FarLoopSubdivisionTables<U>(mesh, maxlevel); break;
+    }
+    mesh->_subdivisionTables = tables;
+
+    tables->_vertsOffsets.swap(vertsOffsets);
+
+    bool valid = readSection(image, F_ITA, tables->_F_ITa, copy) and
+                 readSection(image, F_IT, tables->_F_IT, copy) and
+                 readSection(image, E_IT, tables->_E_IT, copy) and
+                 readSection(image, E_W, tables->_E_W, copy) and
+                 readSection(image, V_ITA, tables->_V_ITa, copy) and
+                 readSection(image, V_IT, tables->_V_IT, copy) and
+                 readSection(image, V_W, tables->_V_W, copy);
+
+    // kernel batches
+    std::vector<int> batches;
+    valid = valid and readSection(image, KERNEL_BATCHES, batches) and batches.size() % 8 == 0;
+    if (valid) {
+        mesh->_batches.reserve(batches.size() / 8);
+        for (int i = 0; i < (int)batches.size(); i += 8) {
+            if (batches[i] < 0 or batches[i] > FarKernelBatch::HIERARCHICAL_EDIT) {
+                valid = false;
+                break;
+            }
+            mesh->_batches.push_back(FarKernelBatch((FarKernelBatch::KernelType)batches[i],
+                batches[i+1], batches[i+2], batches[i+3], batches[i+4],
+                batches[i+5], batches[i+6], batches[i+7]));
+        }
+    }
+
+    // patch tables
+    if (valid and (header.flags & HAS_PATCH_TABLES)) {
+
+        std::vector<unsigned int> arrays;
+        FarPatchTables::PTable patches;
+        FarPatchTables::VertexValenceTable valences;
+        FarPatchTables::QuadOffsetTable quadOffsets;
+        FarPatchTables::PatchParamTable params;
+        FarPatchTables::FVarDataTable fvarData;
+
+        valid = readSection(image, PATCH_ARRAYS, arrays) and arrays.size() % 7 == 0 and
+                readSection(image, PATCH_TABLE, patches) and
+                readSection(image, VERTEX_VALENCES, valences) and
+                readSection(image, QUAD_OFFSETS, quadOffsets) and
+                readSection(image, PATCH_PARAMS, params) and
+                readSection(image, FVAR_DATA, fvarData);
+
+        if (valid) {
+            FarPatchTables::PatchArrayVector patchArrays;
+            patchArrays.reserve(arrays.size() / 7);
+            for (int i = 0; i < (int)arrays.size(); i += 7) {
+                FarPatchTables::Descriptor desc(arrays[i], arrays[i+1], (unsigned char)arrays[i+2]);
+                patchArrays.push_back(FarPatchTables::PatchArray(desc,
+                    arrays[i+3], arrays[i+4], arrays[i+5], arrays[i+6]));
+            }
+            mesh->_patchTables = new FarPatchTables(patchArrays, patches,
+                &valences, &quadOffsets, &params, &fvarData, header.maxValence);
+        }
+    }
+
+    // hierarchical edits
+    if (valid and (header.flags & HAS_VERTEX_EDITS)) {
+
+        std::vector<int> editBatches;
+        std::vector<unsigned int> indices;
+        std::vector<float> values;
+
+        valid = readSection(image, EDIT_BATCHES, editBatches) and editBatches.size() % 7 == 0 and
+                readSection(image, EDIT_INDICES, indices) and
+                readSection(image, EDIT_VALUES, values);
+
+        if (valid) {
+            FarVertexEditTables<U> * editTables = new FarVertexEditTables<U>(mesh);
+            mesh->_vertexEditTables = editTables;
+
+            for (int i = 0; i < (int)editBatches.size(); i += 7) {
+                int const * b = &editBatches[i];
+                if (b[3] < 0 or b[4] < 0 or b[3] + b[4] > (int)indices.size() or
+                    b[5] < 0 or b[6] < 0 or b[5] + b[6] > (int)values.size()) {
+                    valid = false;
+                    break;
+                }
+                if (b[0] < 0 or b[1] < 0 or (long long)b[4] * b[1] > b[6]) {
+                    valid = false;
+                    break;
+                }
+                typename FarVertexEditTables<U>::VertexEditBatch batch(b[0], b[1],
+                    (FarVertexEdit::Operation)b[2]);
+                batch._vertIndices.assign(indices.begin() + b[3], indices.begin() + b[3] + b[4]);
+                batch._edits.assign(values.begin() + b[5], values.begin() + b[5] + b[6]);
+                editTables->_batches.push_back(batch);
+            }
+        }
+    }
+
+    // the batches address the vertices of their level and the entries of
+    // their tables : the content of the tables is covered by the checksum
+    for (int i = 0; valid and i < (int)mesh->_batches.size(); ++i)
+        valid = isValidBatch(mesh->_batches[i], tables, mesh->_vertexEditTables);
+
+    if (not valid) {
+        delete mesh;
+        return 0;
+    }
+
+    // placeholder vertex classes do not store data
+    if (sizeof(U) > 1)
+        mesh->_vertices.resize(mesh->GetNumVertices());
+
+    return mesh;
+}
+
+template <class U> bool
+FarMeshSerializer<U>::FileImage::Open(char const * path) {
+
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 and st.st_size > 0) {
+            void * data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                _data = data;
+                _size = (size_t)st.st_size;
+                _mapped = true;
+            }
+        }
+        close(fd);
+        if (_mapped)
+            return true;
+    }
+#endif
+
+    FILE * file = fopen(path, "rb");
+    if (not file)
+        return false;
+
+    unsigned char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        _buffer.insert(_buffer.end(), buffer, buffer + n);
+    fclose(file);
+
+    _data = _buffer.empty() ? 0 : &_buffer[0];
+    _size = _buffer.size();
+    return _size > 0;
+}
+
+template <class U> FarMesh<U> *
+FarMeshSerializer<U>::Create(char const * path) {
+
+    FileImage * image = new FileImage;
+
+    // the tables of the mesh reference the image, released along with it
+    FarMesh<U> * mesh = image->Open(path) ?
+        Create(image->GetData(), image->GetSize(), false) : 0;
+
+    if (mesh)
+        mesh->_storage = image;
+    else
+        delete image;
+    return mesh;
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // FAR_MESH_SERIALIZER_H
@@ -67,6 +67,11 @@
 #include "../far/patchTablesFactory.h"
 #include "../far/vertexEditTablesFactory.h"
 
+#include "../far/kernelBatchFactory.h"
+#include "../far/trace.h"
+
+#include <algorithm>
+#include <climits>
 #include <typeinfo>
 
 namespace OpenSubdiv {
@@ -86,7 +91,7 @@ public:
     typedef std::vector<FarMesh<U> const *> FarMeshVector;
 
     /// Constructor.
-    FarMultiMeshFactory() {}
+    FarMultiMeshFactory() : _coalesceBatches(false) {}
     
     /// Splices a vector of Far meshes into a single Far mesh
     ///
@@ -100,6 +105,28 @@ public:
         return _multiPatchArrays; 
     }
 
+    /// Merges the kernel batches of the spliced meshes, so that each kernel
+    /// runs once per level instead of once per mesh and level. The refined
+    /// vertices are laid out level by level instead of mesh by mesh : the
+    /// vertices of each level are grouped by kernel across all the meshes.
+    /// The coarse vertices come first, still mesh by mesh. Meshes with
+    /// hierarchical edits keep the mesh by mesh layout, and only their
+    /// contiguous batches are merged. Must be set before Create().
+    ///
+    /// @param enable  true to merge the batches (disabled by default)
+    ///
+    void SetCoalesceBatches(bool enable) { _coalesceBatches = enable; }
+
+    /// Returns true if the kernel batches of the spliced meshes are merged
+    bool GetCoalesceBatches() const { return _coalesceBatches; }
+
+    /// Returns the index in the spliced mesh of each vertex of the meshes,
+    /// taken in order (the vertices of the first mesh, then of the second
+    /// one...). Empty if the vertices were not laid out level by level.
+    std::vector<int> const & GetRemappingTable() const {
+        return _remapTable;
+    }
+
 private:
 
     // splice subdivision tables
@@ -119,6 +146,39 @@ private:
     // splice hierarchical edit tables
     FarVertexEditTables<U> * spliceVertexEditTables(FarMesh<U> *farmesh, FarMeshVector const &meshes);
 
+    // lays out the vertices of the spliced mesh level by level and replaces
+    // its batches with one batch per kernel and level (returns false if the
+    // mesh cannot be laid out this way)
+    bool layoutLevels(FarMesh<U> *farmesh, FarMeshVector const &meshes);
+
+    // returns the position of a kernel within the batches of a level
+    static int kernelOrder(FarKernelBatch::KernelType type);
+
+    // orders vertices by key, then by index
+    struct KeyCompare {
+        KeyCompare(std::vector<int> const & keys) : _keys(keys) { }
+
+        bool operator()(int a, int b) const {
+            return _keys[a]<_keys[b] or (_keys[a]==_keys[b] and a<b);
+        }
+
+        std::vector<int> const & _keys;
+    };
+
+    // the vertices computed by a kernel at a level, across the meshes
+    struct KernelRange {
+        KernelRange() : start(INT_MAX), end(0), count(0), tableOffset(INT_MAX),
+            meshIndex(-2), type(FarKernelBatch::HIERARCHICAL_EDIT) { }
+
+        int start, end, count, tableOffset, meshIndex;
+        FarKernelBatch::KernelType type;
+    };
+
+    bool _coalesceBatches;
+
+    // spliced index of the vertices of the meshes (level layout only)
+    std::vector<int> _remapTable;
+
     int _maxlevel;
     int _maxvalence;
 
@@ -132,6 +192,8 @@ FarMultiMeshFactory<T, U>::Create(std::vector<FarMesh<U> const *> const &meshes)
 
     if (meshes.empty()) return NULL;
 
+    FAR_TRACE_SCOPE("FarMultiMeshFactory::Create", "far");
+
     bool adaptive = (meshes[0]->GetPatchTables() != NULL);
     const std::type_info &scheme = typeid(*(meshes[0]->GetSubdivisionTables()));
     _maxlevel = 0;
@@ -179,6 +241,16 @@ FarMultiMeshFactory<T, U>::Create(std::vector<FarMesh<U> const *> const &meshes)
     result->_numPtexFaces = numPtexFaces;
     result->_totalFVarWidth = 0;  // XXX: fvar for multimesh hasn't been implemented yet.
 
+    _remapTable.clear();
+    if (_coalesceBatches) {
+        if (not result->_vertexEditTables)
+            layoutLevels(result, meshes);
+
+        FarKernelBatchVector batches;
+        FarKernelBatchFactory::Coalesce(result->_batches, &batches);
+        result->_batches.swap(batches);
+    }
+
     return result;
 }
 
@@ -333,8 +405,8 @@ FarMultiMeshFactory<T, U>::spliceSubdivisionTables(FarMesh<U> *farMesh, FarMeshV
     }
 
     // concat F_IT and V_IT
-    std::vector<unsigned int>::iterator F_IT = result->_F_IT.begin();
-    std::vector<unsigned int>::iterator V_IT = result->_V_IT.begin();
+    FarTable<unsigned int>::iterator F_IT = result->_F_IT.begin();
+    FarTable<unsigned int>::iterator V_IT = result->_V_IT.begin();
 
     for (size_t i = 0; i < meshes.size(); ++i) {
         FarSubdivisionTables<U> const * tables = meshes[i]->GetSubdivisionTables();
@@ -346,11 +418,11 @@ FarMultiMeshFactory<T, U>::spliceSubdivisionTables(FarMesh<U> *farMesh, FarMeshV
     }
 
     // merge other tables
-    std::vector<int>::iterator F_ITa = result->_F_ITa.begin();
-    std::vector<int>::iterator E_IT  = result->_E_IT.begin();
-    std::vector<float>::iterator E_W = result->_E_W.begin();
-    std::vector<float>::iterator V_W = result->_V_W.begin();
-    std::vector<int>::iterator V_ITa = result->_V_ITa.begin();
+    FarTable<int>::iterator F_ITa = result->_F_ITa.begin();
+    FarTable<int>::iterator E_IT  = result->_E_IT.begin();
+    FarTable<float>::iterator E_W = result->_E_W.begin();
+    FarTable<float>::iterator V_W = result->_V_W.begin();
+    FarTable<int>::iterator V_ITa = result->_V_ITa.begin();
 
     for (size_t i = 0; i < meshes.size(); ++i) {
         FarSubdivisionTables<U> const * tables = meshes[i]->GetSubdivisionTables();
@@ -379,6 +451,7 @@ FarMultiMeshFactory<T, U>::spliceSubdivisionTables(FarMesh<U> *farMesh, FarMeshV
         for (int j = 0; j < (int)meshes[i]->_batches.size(); ++j) {
             FarKernelBatch batch = meshes[i]->_batches[j];
             batch._vertexOffset += vertexOffsets[i];
+            batch._meshIndex = (int)i;
             
             if (batch._kernelType == FarKernelBatch::CATMARK_FACE_VERTEX or
                 batch._kernelType == FarKernelBatch::BILINEAR_FACE_VERTEX) {
@@ -410,12 +483,14 @@ FarMultiMeshFactory<T, U>::spliceSubdivisionTables(FarMesh<U> *farMesh, FarMeshV
         editTableIndexOffset += meshes[i]->_vertexEditTables ? meshes[i]->_vertexEditTables->GetNumBatches() : 0;
     }
 
-    // count verts offsets
+    // count verts offsets (the offsets of a mesh with fewer levels stay at
+    // its total number of vertices for the levels it does not have)
     result->_vertsOffsets.resize(_maxlevel+2);
     for (size_t i = 0; i < meshes.size(); ++i) {
         FarSubdivisionTables<U> const * tables = meshes[i]->GetSubdivisionTables();
-        for (size_t j = 0; j < tables->_vertsOffsets.size(); ++j) {
-            result->_vertsOffsets[j] += tables->_vertsOffsets[j];
+        for (size_t j = 0; j < result->_vertsOffsets.size(); ++j) {
+            result->_vertsOffsets[j] += j < tables->_vertsOffsets.size() ?
+                tables->_vertsOffsets[j] : tables->_vertsOffsets.back();
         }
     }
 
@@ -589,6 +664,230 @@ FarMultiMeshFactory<T, U>::splicePatchTables(FarMeshVector const &meshes) {
     return result;
 }
 
+// the vertex kernels come in the order of FarVertexKernelBatchFactory
+template <class T, class U> int
+FarMultiMeshFactory<T, U>::kernelOrder(FarKernelBatch::KernelType type) {
+
+    switch (type) {
+        case FarKernelBatch::CATMARK_FACE_VERTEX:
+        case FarKernelBatch::BILINEAR_FACE_VERTEX:   return 0;
+        case FarKernelBatch::CATMARK_EDGE_VERTEX:
+        case FarKernelBatch::LOOP_EDGE_VERTEX:
+        case FarKernelBatch::BILINEAR_EDGE_VERTEX:   return 1;
+        case FarKernelBatch::CATMARK_VERT_VERTEX_B:
+        case FarKernelBatch::LOOP_VERT_VERTEX_B:
+        case FarKernelBatch::BILINEAR_VERT_VERTEX:   return 2;
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A1:
+        case FarKernelBatch::LOOP_VERT_VERTEX_A1:    return 3;
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A2:
+        case FarKernelBatch::LOOP_VERT_VERTEX_A2:    return 4;
+        default:                                     return 5;
+    }
+}
+
+template <class T, class U> bool
+FarMultiMeshFactory<T, U>::layoutLevels(FarMesh<U> *farMesh, FarMeshVector const &meshes) {
+
+    FarSubdivisionTables<U> * tables = farMesh->_subdivisionTables;
+    FarKernelBatchVector const & batches = farMesh->_batches;
+
+    const std::type_info &scheme = typeid(*tables);
+    bool bilinear = (scheme == typeid(FarBilinearSubdivisionTables<U>));
+
+    int nverts = 0;
+    for (size_t i = 0; i < meshes.size(); ++i)
+        nverts += meshes[i]->GetNumVertices();
+
+    // level of each vertex
+    std::vector<int> levels(nverts, 0);
+    for (size_t i = 0, vertexOffset = 0; i < meshes.size(); ++i) {
+        FarSubdivisionTables<U> const * mtables = meshes[i]->GetSubdivisionTables();
+        for (int level = 0; level < mtables->GetMaxLevel(); ++level) {
+            for (int j = mtables->GetFirstVertexOffset(level); j < mtables->GetNumVerticesTotal(level); ++j)
+                levels[vertexOffset + j] = level;
+        }
+        vertexOffset += meshes[i]->GetNumVertices();
+    }
+
+    // kernel type (face, edge, vertex) of each refined vertex, the vertex
+    // kernels applied to it, and its table entry
+    std::vector<int> types(nverts, 3), kernels(nverts, 0), entries(nverts, -1);
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        FarKernelBatch const & batch = batches[i];
+        int order = kernelOrder(batch.GetKernelType());
+        for (int j = batch.GetStart(); j < batch.GetEnd(); ++j) {
+            int vertex = batch.GetVertexOffset() + j;
+            types[vertex] = std::min(order, 2);
+            kernels[vertex] |= 1 << order;
+            entries[vertex] = batch.GetTableOffset() + j;
+        }
+    }
+
+    // group the vertex-vertices so that the ranges of the B, A1 and A2 kernels
+    // stay contiguous across the meshes : B, B & A2, A1 & A2, A1
+    std::vector<int> keys(nverts);
+    for (int i = 0; i < nverts; ++i) {
+        int group = 0;
+        switch (kernels[i] >> 2) {
+            case 0x0 :
+            case 0x1 : group = 0; break;   // B
+            case 0x5 : group = 1; break;   // B & A2
+            case 0x6 : group = 2; break;   // A1 & A2
+            case 0x2 : group = 3; break;   // A1
+            default : return false;
+        }
+        keys[i] = (levels[i] * 4 + types[i]) * 4 + group;
+    }
+
+    std::vector<int> order(nverts);
+    for (int i = 0; i < nverts; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), KeyCompare(keys));
+
+    std::vector<int> remap(nverts),
+                     remapEntries(nverts, -1);
+    int counts[3] = { 0, 0, 0 };
+    for (int i = 0; i < nverts; ++i) {
+        int vertex = order[i];
+        remap[vertex] = i;
+        if (types[vertex] < 3)
+            remapEntries[vertex] = counts[types[vertex]]++;
+    }
+
+    // one batch per kernel and level : the vertices it computes must be
+    // contiguous, and shifted from their table entries by the same amount
+    std::vector<KernelRange> ranges((_maxlevel + 1) * 5);
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        FarKernelBatch const & batch = batches[i];
+        int kernel = kernelOrder(batch.GetKernelType());
+        assert(kernel < 5 and batch.GetLevel() <= _maxlevel);
+        KernelRange & range = ranges[batch.GetLevel() * 5 + kernel];
+        for (int j = batch.GetStart(); j < batch.GetEnd(); ++j) {
+            int vertex = batch.GetVertexOffset() + j;
+            range.start = std::min(range.start, remap[vertex]);
+            range.end = std::max(range.end, remap[vertex] + 1);
+            range.tableOffset = std::min(range.tableOffset, remapEntries[vertex]);
+        }
+        range.count += batch.GetEnd() - batch.GetStart();
+        range.type = batch.GetKernelType();
+        range.meshIndex = (range.meshIndex == -2 or range.meshIndex == batch.GetMeshIndex()) ?
+            batch.GetMeshIndex() : -1;
+    }
+
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        if (ranges[i].count > 0 and ranges[i].end - ranges[i].start != ranges[i].count)
+            return false;
+    }
+
+    for (int vertex = 0; vertex < nverts; ++vertex) {
+        for (int kernel = 0; kernel < 5; ++kernel) {
+            if (not (kernels[vertex] & (1 << kernel)))
+                continue;
+            KernelRange const & range = ranges[levels[vertex] * 5 + kernel];
+            if (remap[vertex] - remapEntries[vertex] != range.start - range.tableOffset)
+                return false;
+        }
+    }
+
+    // reorder the table entries of the face, edge and vertex kernels
+    int strideE = bilinear ? 2 : 4,
+        strideV = bilinear ? 1 : 5,
+        strideEW = counts[1] ? (int)tables->_E_W.size() / counts[1] : 0,
+        strideVW = counts[2] ? (int)tables->_V_W.size() / counts[2] : 0;
+
+    assert((int)tables->_F_ITa.size() == 2 * counts[0] and
+           (int)tables->_E_IT.size() == strideE * counts[1] and
+           (int)tables->_V_ITa.size() == strideV * counts[2]);
+
+    std::vector<int> F_ITa(tables->_F_ITa.size()),
+                     E_IT(tables->_E_IT.size()),
+                     V_ITa(tables->_V_ITa.size());
+    std::vector<float> E_W(tables->_E_W.size()),
+                       V_W(tables->_V_W.size());
+
+    for (int vertex = 0; vertex < nverts; ++vertex) {
+
+        int src = entries[vertex],
+            dst = remapEntries[vertex];
+
+        switch (types[vertex]) {
+            case 0 :
+                F_ITa[2*dst  ] = tables->_F_ITa[2*src  ];
+                F_ITa[2*dst+1] = tables->_F_ITa[2*src+1];
+                break;
+            case 1 :
+                for (int k = 0; k < strideE; ++k) {
+                    int index = tables->_E_IT[strideE*src+k];
+                    E_IT[strideE*dst+k] = index == -1 ? -1 : remap[index];
+                }
+                for (int k = 0; k < strideEW; ++k)
+                    E_W[strideEW*dst+k] = tables->_E_W[strideEW*src+k];
+                break;
+            case 2 :
+                for (int k = 0; k < strideV; ++k) {
+                    int index = tables->_V_ITa[strideV*src+k];
+                    // the offset and the valence are not vertex indices
+                    if (strideV == 5 and k < 2)
+                        V_ITa[strideV*dst+k] = index;
+                    else
+                        V_ITa[strideV*dst+k] = index == -1 ? -1 : remap[index];
+                }
+                for (int k = 0; k < strideVW; ++k)
+                    V_W[strideVW*dst+k] = tables->_V_W[strideVW*src+k];
+                break;
+        }
+    }
+
+    tables->_F_ITa.swap(F_ITa);
+    tables->_E_IT.swap(E_IT);
+    tables->_E_W.swap(E_W);
+    tables->_V_ITa.swap(V_ITa);
+    tables->_V_W.swap(V_W);
+
+    for (int i = 0; i < (int)tables->_F_IT.size(); ++i)
+        tables->_F_IT[i] = remap[tables->_F_IT[i]];
+    for (int i = 0; i < (int)tables->_V_IT.size(); ++i)
+        tables->_V_IT[i] = remap[tables->_V_IT[i]];
+
+    // remap the control vertices of the patches
+    if (FarPatchTables * patchTables = farMesh->_patchTables) {
+
+        for (int i = 0; i < (int)patchTables->_patches.size(); ++i)
+            patchTables->_patches[i] = remap[patchTables->_patches[i]];
+
+        FarPatchTables::VertexValenceTable & valences = patchTables->_vertexValenceTable;
+        if (not valences.empty()) {
+            int stride = (int)valences.size() / nverts;
+            FarPatchTables::VertexValenceTable remapped(valences.size(), 0);
+            for (int vertex = 0; vertex < nverts; ++vertex) {
+                int const * src = &valences[vertex * stride];
+                int * dst = &remapped[remap[vertex] * stride];
+                int valence = abs(src[0]);
+                dst[0] = src[0];
+                for (int k = 1; k <= 2 * valence; ++k)
+                    dst[k] = remap[src[k]];
+            }
+            valences.swap(remapped);
+        }
+    }
+
+    // one batch per kernel and level
+    FarKernelBatchVector levelBatches;
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        KernelRange const & range = ranges[i];
+        if (range.count > 0)
+            levelBatches.push_back(FarKernelBatch(range.type, i / 5, 0,
+                                                  0, range.count,
+                                                  range.tableOffset, range.start,
+                                                  range.meshIndex));
+    }
+    farMesh->_batches.swap(levelBatches);
+
+    _remapTable.swap(remap);
+
+    return true;
+}
+
 template <class T, class U> FarVertexEditTables<U> *
 FarMultiMeshFactory<T, U>::spliceVertexEditTables(FarMesh<U> *farMesh, FarMeshVector const &meshes) {
 
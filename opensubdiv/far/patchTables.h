@@ -61,6 +61,7 @@
 #include "../version.h"
 
 #include "../far/patchParam.h"
+#include "../far/memoryReport.h"
 
 #include <cstdlib>
 #include <cassert>
@@ -368,6 +369,17 @@ public:
         /// @param patches   a set of pointers to the individual patch handles
         ///
         bool GetChildPatchesHandles( int faceid, int * npatches, PatchHandle const ** patches ) const;
+
+        /// Adds the memory allocated by the map to a report
+        ///
+        /// @param report  the report
+        ///
+        /// @param prefix  prefix of the names of the tables in the report
+        ///
+        void ReportMemoryUsage( FarMemoryReport & report, std::string const & prefix=std::string() ) const {
+            report.Add(prefix + "handles", _handles);
+            report.Add(prefix + "offsets", _offsets);
+        }
         
     private:
         typedef std::multimap<unsigned int, PatchHandle> MultiMap;
@@ -475,6 +487,21 @@ public:
     
     /// True if the patches are of feature adaptive types
     bool IsFeatureAdaptive() const;
+
+    /// Adds the memory allocated by the tables to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the tables in the report
+    ///
+    void ReportMemoryUsage( FarMemoryReport & report, std::string const & prefix=std::string() ) const {
+        report.Add(prefix + "patchArrays", _patchArrays);
+        report.Add(prefix + "patches", _patches);
+        report.Add(prefix + "vertexValences", _vertexValenceTable);
+        report.Add(prefix + "quadOffsets", _quadOffsetTable);
+        report.Add(prefix + "patchParams", _paramTable);
+        report.Add(prefix + "fvarData", _fvarTable);
+    }
     
 private:
 
@@ -0,0 +1,141 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_REFINE_PLAN_H
+#define FAR_REFINE_PLAN_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Kernel batches of a mesh compiled for repeated refinement.
+///
+/// FarDispatcher::Refine walks the whole batch vector of a mesh on every call,
+/// testing the level of each batch and switching over its kernel type. A plan
+/// is built once per FarMesh : it keeps the batches below the refinement level
+/// that have vertices to compute, stored contiguously, along with the finest
+/// level they write. FarDispatcher runs a plan through a table of kernel
+/// functions resolved once per controller class, so that the same plan can be
+/// refined by the CPU, OpenMP and thread pool controllers.
+///
+/// The plan copies the batches : it does not reference the mesh and remains
+/// valid as long as the topology of the mesh does not change.
+///
+class FarRefinePlan {
+public:
+    /// Constructor.
+    ///
+    /// @param batches   the kernel batches of a mesh
+    ///
+    /// @param maxlevel  the batches of this level and above are left out
+    ///                  (-1 keeps all the levels)
+    ///
+    explicit FarRefinePlan(FarKernelBatchVector const & batches, int maxlevel=-1) :
+        _finestLevel(-1) {
+
+        _batches.reserve(batches.size());
+        for (int i = 0; i < (int)batches.size(); ++i) {
+
+            FarKernelBatch const & batch = batches[i];
+
+            if (maxlevel >= 0 and batch.GetLevel() >= maxlevel)
+                continue;
+
+            if (batch.GetStart() >= batch.GetEnd())
+                continue;
+
+            _batches.push_back(batch);
+
+            // hierarchical edits modify existing vertices
+            if (batch.GetKernelType() != FarKernelBatch::HIERARCHICAL_EDIT and
+                batch.GetLevel() > _finestLevel)
+                _finestLevel = batch.GetLevel();
+        }
+    }
+
+    /// Returns the batches of the plan, in order of execution
+    FarKernelBatchVector const & GetBatches() const {
+        return _batches;
+    }
+
+    /// Returns the number of batches of the plan
+    int GetNumBatches() const {
+        return (int)_batches.size();
+    }
+
+    /// Returns the finest level of subdivision computed by the plan (-1 if
+    /// the plan is empty)
+    int GetFinestLevel() const {
+        return _finestLevel;
+    }
+
+private:
+    FarKernelBatchVector _batches;
+
+    int _finestLevel;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // FAR_REFINE_PLAN_H
@@ -0,0 +1,244 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_STENCIL_TABLES_H
+#define FAR_STENCIL_TABLES_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+
+#include <cassert>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A batch of stencils or of hierarchical edits.
+///
+/// Stencil batches are executed in sequence : the stencils of a batch only
+/// read vertices computed by the previous batches (or the control vertices),
+/// so they can be applied in any order within a batch. The indexing follows
+/// FarKernelBatch : stencil 'i' of the batch (start <= i < end) is stored at
+/// 'tableOffset + i' in the stencil tables and writes vertex 'vertexOffset + i'.
+///
+/// Hierarchical edits have to be applied on the vertices of their level before
+/// the next level is refined : they are interleaved with the stencil batches
+/// and refer to the edit tables of the mesh (see GetEditBatch()).
+///
+class FarStencilBatch {
+
+public:
+
+    enum BatchType {
+        STENCILS,
+        HIERARCHICAL_EDIT
+    };
+
+    /// Constructor.
+    ///
+    /// @param batchType     the type of batch
+    ///
+    /// @param level         the level of subdivision of the vertices in the batch
+    ///
+    /// @param tableIndex    edit index (for the hierarchical edit batches only)
+    ///
+    /// @param start         index of the first stencil (or edit) in the batch
+    ///
+    /// @param end           index of the last stencil (or edit) in the batch
+    ///
+    /// @param tableOffset   offset of the batch in the stencil (or edit) tables
+    ///
+    /// @param vertexOffset  offset of the vertices written by the batch
+    ///
+    /// @param meshIndex     index of the mesh (in spliced meshes)
+    ///
+    FarStencilBatch( BatchType batchType,
+                     int level,
+                     int tableIndex,
+                     int start,
+                     int end,
+                     int tableOffset,
+                     int vertexOffset,
+                     int meshIndex=0) :
+        _batchType(batchType),
+        _level(level),
+        _tableIndex(tableIndex),
+        _start(start),
+        _end(end),
+        _tableOffset(tableOffset),
+        _vertexOffset(vertexOffset),
+        _meshIndex(meshIndex) {
+    }
+
+    /// Returns the type of the batch
+    BatchType GetBatchType() const { return _batchType; }
+
+    /// Returns the subdivision level of the vertices in the batch
+    int GetLevel() const { return _level; }
+
+    /// Returns the index of the first stencil in the batch
+    int GetStart() const { return _start; }
+
+    /// Returns the index of the last stencil in the batch
+    int GetEnd() const { return _end; }
+
+    /// Returns the offset of the batch in the stencil tables
+    int GetTableOffset() const { return _tableOffset; }
+
+    /// Returns the offset of the vertices written by the batch
+    int GetVertexOffset() const { return _vertexOffset; }
+
+    /// Returns the mesh index
+    int GetMeshIndex() const { return _meshIndex; }
+
+    /// Returns the kernel batch applying the hierarchical edits of a
+    /// HIERARCHICAL_EDIT batch, as found in the kernel batches of the mesh
+    FarKernelBatch GetEditBatch() const {
+        assert(_batchType==HIERARCHICAL_EDIT);
+        return FarKernelBatch( FarKernelBatch::HIERARCHICAL_EDIT, _level,
+            _tableIndex, _start, _end, _tableOffset, _vertexOffset, _meshIndex );
+    }
+
+private:
+    BatchType _batchType;
+    int _level;
+    int _tableIndex;
+    int _start;
+    int _end;
+    int _tableOffset;
+    int _vertexOffset;
+    int _meshIndex;
+};
+
+typedef std::vector<FarStencilBatch> FarStencilBatchVector;
+
+
+/// \brief Flattened refinement stencils.
+///
+/// FarStencilTables are an alternative to the scheme-specific subdivision
+/// tables : each refined vertex is described by a stencil, i.e. the list of
+/// the vertices it is interpolated from and their precomputed weights.
+/// Refinement reduces to a sparse matrix-vector product applied batch after
+/// batch, with a single kernel for all the subdivision schemes and rules.
+///
+/// Vertex and varying interpolation use separate tables (see
+/// FarStencilTablesFactory).
+///
+class FarStencilTables {
+
+public:
+
+    enum Interpolation {
+        VERTEX,   // vertex-interpolated primvar data
+        VARYING   // varying-interpolated primvar data
+    };
+
+    /// Returns the interpolation of the primvar data refined with the stencils
+    Interpolation GetInterpolation() const { return _interpolation; }
+
+    /// Returns the number of stencils in the tables
+    int GetNumStencils() const { return (int)_sizes.size(); }
+
+    /// Returns the batches of stencils and hierarchical edits
+    FarStencilBatchVector const & GetBatches() const { return _batches; }
+
+    /// Returns the number of source vertices of each stencil
+    std::vector<int> const & GetSizes() const { return _sizes; }
+
+    /// Returns the offset of each stencil in the indices and weights tables
+    std::vector<int> const & GetOffsets() const { return _offsets; }
+
+    /// Returns the indices of the source vertices
+    std::vector<int> const & GetIndices() const { return _indices; }
+
+    /// Returns the weights of the source vertices
+    std::vector<float> const & GetWeights() const { return _weights; }
+
+    /// Memory required to store the tables
+    int GetMemoryUsed() const;
+
+private:
+    template <class X> friend class FarStencilTablesFactory;
+
+    explicit FarStencilTables(Interpolation interpolation) :
+        _interpolation(interpolation) { }
+
+    Interpolation _interpolation;
+
+    FarStencilBatchVector _batches;
+
+    std::vector<int>   _sizes,    // number of source vertices per stencil
+                       _offsets,  // offset of each stencil in _indices
+                       _indices;  // indices of the source vertices
+    std::vector<float> _weights;  // weights of the source vertices
+};
+
+inline int
+FarStencilTables::GetMemoryUsed() const {
+    return (int)(_batches.size() * sizeof(FarStencilBatch) +
+                 _sizes.size() * sizeof(int) +
+                 _offsets.size() * sizeof(int) +
+                 _indices.size() * sizeof(int) +
+                 _weights.size() * sizeof(float));
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_STENCIL_TABLES_H */
@@ -0,0 +1,708 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_STENCIL_TABLES_FACTORY_H
+#define FAR_STENCIL_TABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/stencilTables.h"
+#include "../far/trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief A specialized factory for FarStencilTables
+///
+/// The stencils are generated by running the subdivision kernels of the mesh
+/// symbolically : each refined vertex accumulates the weights of its source
+/// vertices instead of their data. References to the vertices of the level
+/// being refined (the face-vertices read by the Catmark edge and vertex
+/// kernels) are expanded, so that the stencils of a level only read the
+/// vertices of the previous level and can be applied in any order.
+///
+/// The floating point operations are not executed in the same order as with
+/// the subdivision tables kernels : results match within rounding precision.
+///
+template <class U> class FarStencilTablesFactory {
+
+public:
+
+    /// Creates the stencil tables refining 'mesh' up to its maximum level
+    ///
+    /// @param mesh          the mesh to generate stencils for
+    ///
+    /// @param interpolation vertex or varying interpolation rules
+    ///
+    /// @return              the stencil tables (owned by the caller)
+    ///
+    static FarStencilTables * Create( FarMesh<U> const * mesh,
+        FarStencilTables::Interpolation interpolation=FarStencilTables::VERTEX );
+
+    /// Creates composite stencil tables refining the finest level of 'mesh'
+    /// directly from its coarse vertices, skipping the intermediate levels.
+    ///
+    /// The tables consist of a single batch of stencils per mesh, which reads
+    /// and writes a compacted vertex buffer : the intermediate levels are
+    /// removed and the coarse and finest vertices keep their relative order
+    /// (for a single mesh, the finest vertices immediately follow the coarse
+    /// vertices).
+    ///
+    /// Hierarchical edits cannot be factored into the stencils and feature
+    /// adaptive patches reference vertices of the intermediate levels : no
+    /// composite tables are created for these meshes.
+    ///
+    /// @param mesh          the mesh to generate stencils for
+    ///
+    /// @param interpolation vertex or varying interpolation rules
+    ///
+    /// @param tolerance     weights below the tolerance are pruned from the
+    ///                      stencils (the remaining weights are rescaled to
+    ///                      preserve their sum)
+    ///
+    /// @return              the stencil tables (owned by the caller), or NULL
+    ///                      if the mesh has hierarchical edits or is adaptive
+    ///
+    static FarStencilTables * CreateComposite( FarMesh<U> const * mesh,
+        FarStencilTables::Interpolation interpolation=FarStencilTables::VERTEX,
+        float tolerance=0.0f );
+
+private:
+
+    // Sparse linear combination of vertices : weights are accumulated in the
+    // order of the kernels and merged when the stencil is written to the tables
+    class Stencil {
+    public:
+        void Clear() {
+            _indices.clear();
+            _weights.clear();
+        }
+
+        void AddWithWeight(int index, float weight) {
+            _indices.push_back(index);
+            _weights.push_back(weight);
+        }
+
+        void AddWithWeight(Stencil const & src, float weight) {
+            for (int i=0; i<(int)src._indices.size(); ++i)
+                AddWithWeight(src._indices[i], src._weights[i]*weight);
+        }
+
+    private:
+        friend class FarStencilTablesFactory;
+
+        std::vector<int> _indices;
+        std::vector<float> _weights;
+    };
+
+    // Appends a stencil to the tables : the source vertices are sorted and
+    // duplicate indices merged
+    static void appendStencil(FarStencilTables * tables, Stencil const & stencil);
+
+    // Stencils of the vertices refined by a run of kernel batches
+    class Builder {
+    public:
+        Builder(FarSubdivisionTables<U> const * tables, bool varying) :
+            _tables(tables), _varying(varying), _first(0) { }
+
+        void Reset(int first, int last) {
+            _first = first;
+            _stencils.resize(last-first);
+            for (int i=0; i<(int)_stencils.size(); ++i)
+                _stencils[i].Clear();
+        }
+
+        void ApplyBatch(FarKernelBatch const & batch);
+
+        std::vector<Stencil> const & GetStencils() const { return _stencils; }
+
+    private:
+        Stencil & dst(int index) {
+            assert(index>=_first and index<_first+(int)_stencils.size());
+            return _stencils[index-_first];
+        }
+
+        // adds a source vertex, expanding the vertices refined in this run
+        void add(Stencil & stencil, int index, float weight) {
+            if (index>=_first and index<_first+(int)_stencils.size())
+                stencil.AddWithWeight(_stencils[index-_first], weight);
+            else
+                stencil.AddWithWeight(index, weight);
+        }
+
+        void computeFacePoints(FarKernelBatch const & batch);
+        void computeEdgePoints(FarKernelBatch const & batch);
+        void computeVertexPointsA(FarKernelBatch const & batch, bool pass);
+        void computeVertexPointsB(FarKernelBatch const & batch);
+        void computeLoopVertexPointsB(FarKernelBatch const & batch);
+        void computeBilinearEdgePoints(FarKernelBatch const & batch);
+        void computeBilinearVertexPoints(FarKernelBatch const & batch);
+
+        FarSubdivisionTables<U> const * _tables;
+        bool _varying;
+        int _first;
+        std::vector<Stencil> _stencils;
+    };
+};
+
+template <class U> FarStencilTables *
+FarStencilTablesFactory<U>::Create( FarMesh<U> const * mesh,
+    FarStencilTables::Interpolation interpolation ) {
+
+    assert(mesh);
+
+    FAR_TRACE_SCOPE("FarStencilTablesFactory::Create", "far");
+
+    FarStencilTables * result = new FarStencilTables(interpolation);
+
+    Builder builder(mesh->GetSubdivisionTables(),
+                    interpolation==FarStencilTables::VARYING);
+
+    FarKernelBatchVector const & batches = mesh->GetKernelBatches();
+
+    for (int i=0; i<(int)batches.size(); ) {
+
+        FarKernelBatch const & batch = batches[i];
+
+        if (batch.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT) {
+            result->_batches.push_back(FarStencilBatch(
+                FarStencilBatch::HIERARCHICAL_EDIT, batch.GetLevel(),
+                batch.GetTableIndex(), batch.GetStart(), batch.GetEnd(),
+                batch.GetTableOffset(), batch.GetVertexOffset(),
+                batch.GetMeshIndex()));
+            ++i;
+            continue;
+        }
+
+        // gather the kernel batches refining the same level of the same mesh
+        int first = batch.GetVertexOffset() + batch.GetStart(),
+            last = batch.GetVertexOffset() + batch.GetEnd(),
+            end = i;
+
+        for (; end<(int)batches.size(); ++end) {
+            FarKernelBatch const & b = batches[end];
+            if (b.GetKernelType()==FarKernelBatch::HIERARCHICAL_EDIT or
+                b.GetLevel()!=batch.GetLevel() or
+                b.GetMeshIndex()!=batch.GetMeshIndex())
+                break;
+            first = std::min(first, b.GetVertexOffset() + b.GetStart());
+            last = std::max(last, b.GetVertexOffset() + b.GetEnd());
+        }
+
+        builder.Reset(first, last);
+        for (; i<end; ++i)
+            builder.ApplyBatch(batches[i]);
+
+        int tableOffset = result->GetNumStencils();
+
+        std::vector<Stencil> const & stencils = builder.GetStencils();
+        for (int j=0; j<(int)stencils.size(); ++j)
+            appendStencil(result, stencils[j]);
+
+        result->_batches.push_back(FarStencilBatch(
+            FarStencilBatch::STENCILS, batch.GetLevel(), 0,
+            0, last-first, tableOffset, first, batch.GetMeshIndex()));
+    }
+    return result;
+}
+
+template <class U> FarStencilTables *
+FarStencilTablesFactory<U>::CreateComposite( FarMesh<U> const * mesh,
+    FarStencilTables::Interpolation interpolation, float tolerance ) {
+
+    assert(mesh);
+
+    if (mesh->GetPatchTables() and mesh->IsFeatureAdaptive())
+        return NULL;
+
+    FarStencilTables * levels = Create(mesh, interpolation);
+
+    FarStencilBatchVector const & batches = levels->GetBatches();
+
+    int nverts = mesh->GetNumVertices();
+
+    // level of each vertex and finest level of each mesh
+    std::vector<int> vertLevels(nverts, 0), finestLevels;
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType()==FarStencilBatch::HIERARCHICAL_EDIT) {
+            delete levels;
+            return NULL;
+        }
+
+        if (batch.GetMeshIndex()>=(int)finestLevels.size())
+            finestLevels.resize(batch.GetMeshIndex()+1, 0);
+        finestLevels[batch.GetMeshIndex()] =
+            std::max(finestLevels[batch.GetMeshIndex()], batch.GetLevel());
+
+        for (int j=batch.GetStart(); j<batch.GetEnd(); ++j)
+            vertLevels[batch.GetVertexOffset()+j] = batch.GetLevel();
+    }
+
+    // index of the coarse and finest vertices in the compacted vertex buffer
+    std::vector<int> remap(nverts, -1);
+    for (int i=0; i<(int)batches.size(); ++i) {
+        FarStencilBatch const & batch = batches[i];
+        if (batch.GetLevel()==finestLevels[batch.GetMeshIndex()])
+            for (int j=batch.GetStart(); j<batch.GetEnd(); ++j)
+                remap[batch.GetVertexOffset()+j] = 0;
+    }
+    for (int i=0, count=0; i<nverts; ++i)
+        if (vertLevels[i]==0 or remap[i]==0)
+            remap[i] = count++;
+
+    FarStencilTables * result = new FarStencilTables(interpolation);
+
+    std::vector<int> const & sizes = levels->GetSizes(),
+                           & offsets = levels->GetOffsets(),
+                           & indices = levels->GetIndices();
+    std::vector<float> const & weights = levels->GetWeights();
+
+    // composite stencils of the intermediate vertices, indexed by vertex
+    std::vector<int> compSizes(nverts, 0),
+                     compOffsets(nverts, 0),
+                     compIndices;
+    std::vector<float> compWeights;
+
+    // dense accumulation of the coarse vertex weights of a stencil
+    std::vector<double> accum(nverts, 0.0);
+    std::vector<int> touched, marks(nverts, -1);
+    int mark = 0;
+
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        bool finest = batch.GetLevel()==finestLevels[batch.GetMeshIndex()];
+
+        int tableOffset = result->GetNumStencils();
+
+        for (int j=batch.GetStart(); j<batch.GetEnd(); ++j) {
+
+            int stencil = batch.GetTableOffset()+j;
+
+            for (int k=0; k<sizes[stencil]; ++k) {
+
+                int index = indices[offsets[stencil]+k];
+                float weight = weights[offsets[stencil]+k];
+
+                if (vertLevels[index]==0) {
+                    if (marks[index]!=mark) {
+                        marks[index] = mark;
+                        touched.push_back(index);
+                    }
+                    accum[index] += weight;
+                } else {
+                    for (int l=0; l<compSizes[index]; ++l) {
+                        int cindex = compIndices[compOffsets[index]+l];
+                        if (marks[cindex]!=mark) {
+                            marks[cindex] = mark;
+                            touched.push_back(cindex);
+                        }
+                        accum[cindex] += (double)compWeights[compOffsets[index]+l] * weight;
+                    }
+                }
+            }
+
+            std::sort(touched.begin(), touched.end());
+
+            if (finest) {
+                // prune the weights below the tolerance and rescale the
+                // remaining ones so that their sum is preserved
+                double sum = 0.0, kept = 0.0;
+                for (int k=0; k<(int)touched.size(); ++k) {
+                    double weight = accum[touched[k]];
+                    sum += weight;
+                    if (std::fabs(weight)>=tolerance)
+                        kept += weight;
+                }
+                double scale = kept!=0.0 ? sum/kept : 1.0;
+
+                result->_offsets.push_back((int)result->_indices.size());
+                int size = 0;
+                for (int k=0; k<(int)touched.size(); ++k) {
+                    double weight = accum[touched[k]];
+                    if (weight!=0.0 and std::fabs(weight)>=tolerance) {
+                        result->_indices.push_back(remap[touched[k]]);
+                        result->_weights.push_back((float)(weight*scale));
+                        ++size;
+                    }
+                }
+                result->_sizes.push_back(size);
+            } else {
+                int vert = batch.GetVertexOffset()+j;
+                compOffsets[vert] = (int)compIndices.size();
+                for (int k=0; k<(int)touched.size(); ++k) {
+                    if (accum[touched[k]]!=0.0) {
+                        compIndices.push_back(touched[k]);
+                        compWeights.push_back((float)accum[touched[k]]);
+                    }
+                }
+                compSizes[vert] = (int)compIndices.size() - compOffsets[vert];
+            }
+
+            for (int k=0; k<(int)touched.size(); ++k)
+                accum[touched[k]] = 0.0;
+            touched.clear();
+            ++mark;
+        }
+
+        if (finest)
+            result->_batches.push_back(FarStencilBatch(
+                FarStencilBatch::STENCILS, batch.GetLevel(), 0,
+                batch.GetStart(), batch.GetEnd(), tableOffset - batch.GetStart(),
+                remap[batch.GetVertexOffset()+batch.GetStart()] - batch.GetStart(),
+                batch.GetMeshIndex()));
+    }
+
+    delete levels;
+
+    return result;
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::appendStencil(FarStencilTables * tables,
+                                          Stencil const & stencil) {
+
+    // sort the source vertices (stable, so that the weights of a vertex are
+    // summed in the order of the kernels)
+    std::vector<std::pair<int, int> > order(stencil._indices.size());
+    for (int i=0; i<(int)order.size(); ++i)
+        order[i] = std::make_pair(stencil._indices[i], i);
+    std::sort(order.begin(), order.end());
+
+    tables->_offsets.push_back((int)tables->_indices.size());
+
+    int size = 0;
+    for (int i=0; i<(int)order.size(); ) {
+        int index = order[i].first;
+        float weight = 0.0f;
+        for (; i<(int)order.size() and order[i].first==index; ++i)
+            weight += stencil._weights[order[i].second];
+
+        if (weight!=0.0f) {
+            tables->_indices.push_back(index);
+            tables->_weights.push_back(weight);
+            ++size;
+        }
+    }
+    tables->_sizes.push_back(size);
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::ApplyBatch(FarKernelBatch const & batch) {
+
+    switch (batch.GetKernelType()) {
+        case FarKernelBatch::CATMARK_FACE_VERTEX  :
+        case FarKernelBatch::BILINEAR_FACE_VERTEX : computeFacePoints(batch); break;
+
+        case FarKernelBatch::CATMARK_EDGE_VERTEX  :
+        case FarKernelBatch::LOOP_EDGE_VERTEX     : computeEdgePoints(batch); break;
+
+        case FarKernelBatch::CATMARK_VERT_VERTEX_B : computeVertexPointsB(batch); break;
+
+        case FarKernelBatch::LOOP_VERT_VERTEX_B    : computeLoopVertexPointsB(batch); break;
+
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A1 :
+        case FarKernelBatch::LOOP_VERT_VERTEX_A1    : computeVertexPointsA(batch, false); break;
+
+        case FarKernelBatch::CATMARK_VERT_VERTEX_A2 :
+        case FarKernelBatch::LOOP_VERT_VERTEX_A2    : computeVertexPointsA(batch, true); break;
+
+        case FarKernelBatch::BILINEAR_EDGE_VERTEX : computeBilinearEdgePoints(batch); break;
+
+        case FarKernelBatch::BILINEAR_VERT_VERTEX : computeBilinearVertexPoints(batch); break;
+
+        case FarKernelBatch::HIERARCHICAL_EDIT : assert(0); break;
+    }
+}
+
+//
+// The compute functions below mirror the Osd CPU kernels (see osd/cpuKernel.cpp)
+//
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeFacePoints(FarKernelBatch const & batch) {
+
+    FarTable<int> const & F_ITa = _tables->Get_F_ITa();
+    FarTable<unsigned int> const & F_IT = _tables->Get_F_IT();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        int h = F_ITa[2*i  ],
+            n = F_ITa[2*i+1];
+        float weight = 1.0f/n;
+
+        for (int j=0; j<n; ++j)
+            add(stencil, F_IT[h+j], weight);
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeEdgePoints(FarKernelBatch const & batch) {
+
+    FarTable<int> const & E_IT = _tables->Get_E_IT();
+    FarTable<float> const & E_W = _tables->Get_E_W();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        int eidx0 = E_IT[4*i+0],
+            eidx1 = E_IT[4*i+1],
+            eidx2 = E_IT[4*i+2],
+            eidx3 = E_IT[4*i+3];
+
+        if (_varying) {
+            add(stencil, eidx0, 0.5f);
+            add(stencil, eidx1, 0.5f);
+            continue;
+        }
+
+        float vertWeight = E_W[i*2+0];
+
+        add(stencil, eidx0, vertWeight);
+        add(stencil, eidx1, vertWeight);
+
+        if (eidx2!=-1) {
+            float faceWeight = E_W[i*2+1];
+
+            add(stencil, eidx2, faceWeight);
+            add(stencil, eidx3, faceWeight);
+        }
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeVertexPointsA(FarKernelBatch const & batch, bool pass) {
+
+    FarTable<int> const & V_ITa = _tables->Get_V_ITa();
+    FarTable<float> const & V_W = _tables->Get_V_W();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+
+        int     n=V_ITa[5*i+1],
+                p=V_ITa[5*i+2],
+            eidx0=V_ITa[5*i+3],
+            eidx1=V_ITa[5*i+4];
+
+        if (_varying) {
+            // varying data is only interpolated by the first pass
+            if (not pass) {
+                stencil.Clear();
+                add(stencil, p, 1.0f);
+            }
+            continue;
+        }
+
+        if (not pass)
+            stencil.Clear();
+
+        float weight = pass ? V_W[i] : 1.0f - V_W[i];
+
+        // fractional weights are inverted (see FarCatmarkSubdivisionTables)
+        if (weight>0.0f and weight<1.0f and n>0)
+            weight=1.0f-weight;
+
+        if (eidx0==-1 or (pass==false and (n==-1)) ) {
+            add(stencil, p, weight);
+        } else {
+            add(stencil, p, weight * 0.75f);
+            add(stencil, eidx0, weight * 0.125f);
+            add(stencil, eidx1, weight * 0.125f);
+        }
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeVertexPointsB(FarKernelBatch const & batch) {
+
+    FarTable<int> const & V_ITa = _tables->Get_V_ITa();
+    FarTable<unsigned int> const & V_IT = _tables->Get_V_IT();
+    FarTable<float> const & V_W = _tables->Get_V_W();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        int h = V_ITa[5*i  ],
+            n = V_ITa[5*i+1],
+            p = V_ITa[5*i+2];
+
+        if (_varying) {
+            add(stencil, p, 1.0f);
+            continue;
+        }
+
+        float weight = V_W[i],
+                  wp = 1.0f/static_cast<float>(n*n),
+                  wv = (n-2.0f)*n*wp;
+
+        add(stencil, p, weight * wv);
+
+        for (int j=0; j<n; ++j) {
+            add(stencil, V_IT[h+j*2  ], weight * wp);
+            add(stencil, V_IT[h+j*2+1], weight * wp);
+        }
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeLoopVertexPointsB(FarKernelBatch const & batch) {
+
+    FarTable<int> const & V_ITa = _tables->Get_V_ITa();
+    FarTable<unsigned int> const & V_IT = _tables->Get_V_IT();
+    FarTable<float> const & V_W = _tables->Get_V_W();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        int h = V_ITa[5*i  ],
+            n = V_ITa[5*i+1],
+            p = V_ITa[5*i+2];
+
+        if (_varying) {
+            add(stencil, p, 1.0f);
+            continue;
+        }
+
+        float weight = V_W[i],
+                  wp = 1.0f/static_cast<float>(n),
+                beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
+        beta = beta * beta;
+        beta = (0.625f - beta) * wp;
+
+        add(stencil, p, weight * (1.0f - (beta * n)));
+
+        for (int j=0; j<n; ++j)
+            add(stencil, V_IT[h+j], weight * beta);
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeBilinearEdgePoints(FarKernelBatch const & batch) {
+
+    FarTable<int> const & E_IT = _tables->Get_E_IT();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        add(stencil, E_IT[2*i+0], 0.5f);
+        add(stencil, E_IT[2*i+1], 0.5f);
+    }
+}
+
+template <class U> void
+FarStencilTablesFactory<U>::Builder::computeBilinearVertexPoints(FarKernelBatch const & batch) {
+
+    FarTable<int> const & V_ITa = _tables->Get_V_ITa();
+
+    int tableOffset = batch.GetTableOffset(),
+        vertexOffset = batch.GetVertexOffset();
+
+    for (int i=batch.GetStart()+tableOffset; i<batch.GetEnd()+tableOffset; ++i) {
+
+        Stencil & stencil = dst(i+vertexOffset-tableOffset);
+        stencil.Clear();
+
+        add(stencil, V_ITa[i], 1.0f);
+    }
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_STENCIL_TABLES_FACTORY_H */
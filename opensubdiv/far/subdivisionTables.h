@@ -60,6 +60,9 @@
 
 #include "../version.h"
 
+#include "../far/memoryReport.h"
+#include "../far/table.h"
+
 #include <cassert>
 #include <utility>
 #include <vector>
@@ -121,6 +124,14 @@ public:
     /// Memory required to store the indexing tables
     int GetMemoryUsed() const;
 
+    /// Adds the memory allocated by the tables to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the tables in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report, std::string const & prefix=std::string()) const;
+
     /// Pointer back to the mesh owning the table
     FarMesh<U> * GetMesh() { return _mesh; }
 
@@ -141,25 +152,25 @@ public:
     /// Indexing tables accessors
 
     /// Returns the face vertices codex table
-    std::vector<int> const &          Get_F_ITa( ) const { return _F_ITa; }
+    FarTable<int> const &          Get_F_ITa( ) const { return _F_ITa; }
 
     /// Returns the face vertices indexing table
-    std::vector<unsigned int> const & Get_F_IT( ) const { return _F_IT; }
+    FarTable<unsigned int> const & Get_F_IT( ) const { return _F_IT; }
 
     /// Returns the edge vertices indexing table
-    std::vector<int> const &          Get_E_IT() const { return _E_IT; }
+    FarTable<int> const &          Get_E_IT() const { return _E_IT; }
 
     /// Returns the edge vertices weights table
-    std::vector<float> const &        Get_E_W() const { return _E_W; }
+    FarTable<float> const &        Get_E_W() const { return _E_W; }
 
     /// Returns the vertex vertices codex table
-    std::vector<int> const &          Get_V_ITa() const { return _V_ITa; }
+    FarTable<int> const &          Get_V_ITa() const { return _V_ITa; }
 
     /// Returns the vertex vertices indexing table
-    std::vector<unsigned int> const & Get_V_IT() const { return _V_IT; }
+    FarTable<unsigned int> const & Get_V_IT() const { return _V_IT; }
 
     /// Returns the vertex vertices weights table
-    std::vector<float> const &        Get_V_W() const { return _V_W; }
+    FarTable<float> const &        Get_V_W() const { return _V_W; }
 
     /// Returns the number of indexing tables needed to represent this particular
     /// subdivision scheme.
@@ -168,21 +179,23 @@ public:
 protected:
     template <class X, class Y> friend class FarMeshFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
+    template <class X> friend class FarTopologyRefiner;
 
     FarSubdivisionTables<U>( FarMesh<U> * mesh, int maxlevel );
 
     // mesh that owns this subdivisionTable
     FarMesh<U> * _mesh;
 
-    std::vector<int>          _F_ITa; // vertices from face refinement
-    std::vector<unsigned int> _F_IT;  // indices of face vertices
+    FarTable<int>          _F_ITa; // vertices from face refinement
+    FarTable<unsigned int> _F_IT;  // indices of face vertices
 
-    std::vector<int>          _E_IT;  // vertices from edge refinement
-    std::vector<float>        _E_W;   // weigths
+    FarTable<int>          _E_IT;  // vertices from edge refinement
+    FarTable<float>        _E_W;   // weigths
 
-    std::vector<int>          _V_ITa; // vertices from vertex refinement
-    std::vector<unsigned int> _V_IT;  // indices of adjacent vertices
-    std::vector<float>        _V_W;   // weights
+    FarTable<int>          _V_ITa; // vertices from vertex refinement
+    FarTable<unsigned int> _V_IT;  // indices of adjacent vertices
+    FarTable<float>        _V_W;   // weights
 
     std::vector<int> _vertsOffsets; // offset to the first vertex of each level
 };
@@ -235,6 +248,18 @@ FarSubdivisionTables<U>::GetMemoryUsed() const {
                  _V_W.size() * sizeof(float));
 }
 
+template <class U> void
+FarSubdivisionTables<U>::ReportMemoryUsage(FarMemoryReport & report, std::string const & prefix) const {
+    report.Add(prefix + "F_ITa", _F_ITa);
+    report.Add(prefix + "F_IT", _F_IT);
+    report.Add(prefix + "E_IT", _E_IT);
+    report.Add(prefix + "E_W", _E_W);
+    report.Add(prefix + "V_ITa", _V_ITa);
+    report.Add(prefix + "V_IT", _V_IT);
+    report.Add(prefix + "V_W", _V_W);
+    report.Add(prefix + "vertsOffsets", _vertsOffsets);
+}
+
 } // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
 
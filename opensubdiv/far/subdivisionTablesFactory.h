@@ -63,6 +63,7 @@
 #include "../far/meshFactory.h"
 #include "../far/subdivisionTables.h"
 
+#include <algorithm>
 #include <cassert>
 #include <utility>
 #include <vector>
@@ -91,7 +92,11 @@ protected:
     // specialized subdivision scheme factories (Bilinear / Catmark / Loop).
     // It also populates the FarMeshFactory vertex remapping vector that ties the
     // Hbr vertex indices to the FarVertexEdit tables.
-    FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable );
+    //
+    // With 'localityOrdering', the vertices of each type are ordered by the
+    // rank of their incident faces in a breadth-first traversal of the mesh
+    // (see FarMeshFactory::SetLocalityOrdering).
+    FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable, bool localityOrdering=false );
 
     /// Returns the number of coarse vertices found in the mesh
     int GetNumCoarseVertices() const { 
@@ -149,10 +154,37 @@ private:
     // Compares vertices based on their topological configuration 
     // (see subdivisionTables::GetMaskRanking for more details)
     static bool compareVertices( HbrVertex<T> const *x, HbrVertex<T> const *y );
+
+    // Ranks the faces of the HbrMesh for the locality ordering : the coarse
+    // faces in breadth-first order, then level after level the children of
+    // each face in the order of their parent
+    static void rankFaces( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & faceRanks );
+
+    // Sorts the vertices [first, last) of a list by the lowest rank of their
+    // incident faces, vertices with the same key keeping their relative order
+    static void sortByFaceRank( std::vector<HbrVertex<T> *> & list, int first, int last, std::vector<int> const & faceRanks );
+
+    // Gathers the lowest rank of the faces around a vertex
+    class FaceRankOperator : public HbrFaceOperator<T> {
+    public:
+        FaceRankOperator( std::vector<int> const & faceRanks ) : _faceRanks(faceRanks), _rank(-1) { }
+
+        virtual void operator() (HbrFace<T> &face) {
+            int rank = _faceRanks[face.GetID()];
+            if (_rank==-1 or rank<_rank)
+                _rank = rank;
+        }
+
+        int GetRank() const { return _rank; }
+
+    private:
+        std::vector<int> const & _faceRanks;
+        int _rank;
+    };
 };
 
 template <class T, class U> 
-FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable ) :
+FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & remapTable, bool localityOrdering ) :
     _faceVertIdx(maxlevel+1,0),
     _edgeVertIdx(maxlevel+1,0),
     _vertVertIdx(maxlevel+1,0),
@@ -260,7 +292,44 @@ FarSubdivisionTablesFactory<T,U>::FarSubdivisionTablesFactory( HbrMesh<T> const
         for (size_t i=0; i<_vertVertsList[l].size(); ++i)
             remapTable[ _vertVertsList[l][i]->GetID() ]=_vertVertIdx[l]+(int)i;
 
-
+    // Locality ordering : the vertices returned by the HbrMesh follow the
+    // order in which the coarse faces were declared, which can scatter the
+    // vertices gathered by the compute kernels across the previous level.
+    // Ranking the faces from a breadth-first traversal of the coarse faces,
+    // and ordering the vertices of each type by the rank of their incident
+    // faces, keeps the neighborhoods together in every batch, level after
+    // level. The vertex-vertices are only reordered within each mask ranking,
+    // which preserves the contiguity of the kernel batches.
+    if (localityOrdering) {
+
+        std::vector<int> faceRanks;
+        rankFaces(mesh, maxlevel, faceRanks);
+
+        for (int l=1; l<(maxlevel+1); ++l) {
+
+            sortByFaceRank(_faceVertsList[l], 0, (int)_faceVertsList[l].size(), faceRanks);
+            for (size_t i=0; i<_faceVertsList[l].size(); ++i)
+                remapTable[ _faceVertsList[l][i]->GetID() ]=_faceVertIdx[l]+(int)i;
+
+            sortByFaceRank(_edgeVertsList[l], 0, (int)_edgeVertsList[l].size(), faceRanks);
+            for (size_t i=0; i<_edgeVertsList[l].size(); ++i)
+                remapTable[ _edgeVertsList[l][i]->GetID() ]=_edgeVertIdx[l]+(int)i;
+
+            std::vector<HbrVertex<T> *> & vertVerts = _vertVertsList[l];
+            for (int first=0, last=0; first<(int)vertVerts.size(); first=last) {
+                HbrVertex<T> * pv = vertVerts[first]->GetParentVertex();
+                int rank = GetMaskRanking(pv->GetMask(false), pv->GetMask(true));
+                for (last=first+1; last<(int)vertVerts.size(); ++last) {
+                    pv = vertVerts[last]->GetParentVertex();
+                    if (GetMaskRanking(pv->GetMask(false), pv->GetMask(true))!=rank)
+                        break;
+                }
+                sortByFaceRank(vertVerts, first, last, faceRanks);
+            }
+            for (size_t i=0; i<vertVerts.size(); ++i)
+                remapTable[ vertVerts[i]->GetID() ]=_vertVertIdx[l]+(int)i;
+        }
+    }
 }
 
 
@@ -367,6 +436,79 @@ FarSubdivisionTablesFactory<T,U>::compareVertices( HbrVertex<T> const * x, HbrVe
            GetMaskRanking(py->GetMask(false), py->GetMask(true) );
 }
 
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::rankFaces( HbrMesh<T> const * mesh, int maxlevel, std::vector<int> & faceRanks ) {
+
+    int nfaces = mesh->GetNumFaces(),
+        rank = 0;
+
+    faceRanks.assign(nfaces, -1);
+
+    // breadth-first traversal of the coarse faces, across edges
+    std::vector<HbrFace<T> *> faces, children;
+    faces.reserve(mesh->GetNumCoarseFaces());
+
+    for (int i=0; i<nfaces; ++i) {
+
+        HbrFace<T> * root = mesh->GetFace(i);
+        if (root->GetDepth()>0 or faceRanks[root->GetID()]!=-1)
+            continue;
+
+        size_t next = faces.size();
+        faceRanks[root->GetID()] = rank++;
+        faces.push_back(root);
+
+        for (; next<faces.size(); ++next) {
+            HbrFace<T> * f = faces[next];
+            for (int j=0; j<f->GetNumVertices(); ++j) {
+                HbrFace<T> * neighbor = f->GetEdge(j)->GetRightFace();
+                if (neighbor and faceRanks[neighbor->GetID()]==-1) {
+                    faceRanks[neighbor->GetID()] = rank++;
+                    faces.push_back(neighbor);
+                }
+            }
+        }
+    }
+
+    // the children of each face follow the order of their parent
+    for (int l=1; l<(maxlevel+1); ++l) {
+        children.clear();
+        for (size_t i=0; i<faces.size(); ++i) {
+            HbrFace<T> * f = faces[i];
+            int nchildren = mesh->GetSubdivision()->GetFaceChildrenCount(f->GetNumVertices());
+            for (int j=0; j<nchildren; ++j) {
+                HbrFace<T> * child = f->GetChild(j);
+                if (child) {
+                    faceRanks[child->GetID()] = rank++;
+                    children.push_back(child);
+                }
+            }
+        }
+        faces.swap(children);
+    }
+}
+
+template <class T, class U> void
+FarSubdivisionTablesFactory<T,U>::sortByFaceRank( std::vector<HbrVertex<T> *> & list, int first, int last, std::vector<int> const & faceRanks ) {
+
+    // (rank, position) pairs : sorting the positions along keeps the order of
+    // the vertices with the same rank deterministic
+    std::vector<std::pair<int, int> > keys(last-first);
+    for (int i=first; i<last; ++i) {
+        FaceRankOperator op(faceRanks);
+        if (list[i]->IsConnected())
+            list[i]->ApplyOperatorSurroundingFaces(op);
+        keys[i-first] = std::make_pair( op.GetRank(), i );
+    }
+
+    std::sort( keys.begin(), keys.end() );
+
+    std::vector<HbrVertex<T> *> sorted(last-first);
+    for (int i=first; i<last; ++i)
+        sorted[i-first] = list[ keys[i-first].second ];
+
+    std::copy( sorted.begin(), sorted.end(), list.begin()+first );
+}
 
 } // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
@@ -0,0 +1,254 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_TABLE_H
+#define FAR_TABLE_H
+
+#include "../version.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief An array of the Far tables, owning its elements or referencing
+/// memory owned by the client.
+///
+/// FarTable has the interface of the std::vector it replaces in the
+/// subdivision tables. The tables built by the factories own their elements.
+/// A table can instead reference an array in memory (see Reference()), for
+/// instance a mesh image mapped by FarMeshSerializer : the elements are then
+/// neither copied nor released, and the memory must remain valid and
+/// unchanged as long as the table references it.
+///
+/// A table referencing memory is never written through : the non-const
+/// accessors first copy the referenced elements into the table.
+///
+template <class T> class FarTable {
+
+public:
+
+    typedef T           value_type;
+    typedef T *         iterator;
+    typedef T const *   const_iterator;
+
+    /// Constructor
+    FarTable() : _data(0), _size(0), _owned(true) { }
+
+    /// Constructor
+    explicit FarTable(size_t size, T const & value=T()) :
+        _vector(size, value), _owned(true) {
+        sync();
+    }
+
+    /// Copy constructor : the copy owns its elements
+    FarTable(FarTable const & table) :
+        _vector(table.begin(), table.end()), _owned(true) {
+        sync();
+    }
+
+    /// Assignment : the table owns a copy of the elements
+    FarTable & operator = (FarTable const & table) {
+        if (this != &table) {
+            std::vector<T>(table.begin(), table.end()).swap(_vector);
+            _owned = true;
+            sync();
+        }
+        return *this;
+    }
+
+    /// References 'size' elements at 'data', releasing the elements owned
+    /// by the table
+    void Reference(T const * data, size_t size) {
+        std::vector<T>().swap(_vector);
+        _data = const_cast<T *>(data);
+        _size = size;
+        _owned = false;
+    }
+
+    /// Returns true if the table owns its elements
+    bool IsOwned() const {
+        return _owned;
+    }
+
+    /// Returns the number of elements
+    size_t size() const {
+        return _size;
+    }
+
+    /// Returns true if the table has no elements
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /// Returns the number of elements allocated by the table (0 for a table
+    /// referencing memory)
+    size_t capacity() const {
+        return _owned ? _vector.capacity() : 0;
+    }
+
+    T const & operator [] (size_t index) const {
+        return _data[index];
+    }
+
+    T & operator [] (size_t index) {
+        own();
+        return _data[index];
+    }
+
+    const_iterator begin() const {
+        return _data;
+    }
+
+    const_iterator end() const {
+        return _data + _size;
+    }
+
+    iterator begin() {
+        own();
+        return _data;
+    }
+
+    iterator end() {
+        own();
+        return _data + _size;
+    }
+
+    void resize(size_t size, T const & value=T()) {
+        own();
+        _vector.resize(size, value);
+        sync();
+    }
+
+    void reserve(size_t size) {
+        own();
+        _vector.reserve(size);
+        sync();
+    }
+
+    void push_back(T const & value) {
+        own();
+        _vector.push_back(value);
+        sync();
+    }
+
+    void clear() {
+        own();
+        _vector.clear();
+        sync();
+    }
+
+    void swap(FarTable & table) {
+        _vector.swap(table._vector);
+        std::swap(_data, table._data);
+        std::swap(_size, table._size);
+        std::swap(_owned, table._owned);
+    }
+
+    /// Swaps the elements of the table with a vector : the table then owns
+    /// the elements of the vector
+    void swap(std::vector<T> & vector) {
+        own();
+        _vector.swap(vector);
+        sync();
+    }
+
+private:
+
+    // copies the referenced elements before the table is modified
+    void own() {
+        if (not _owned) {
+            _vector.assign(_data, _data + _size);
+            _owned = true;
+            sync();
+        }
+    }
+
+    void sync() {
+        _data = _vector.empty() ? 0 : &_vector[0];
+        _size = _vector.size();
+    }
+
+    std::vector<T> _vector;     // the elements owned by the table
+
+    T * _data;                  // the elements of the table, owned or not
+
+    size_t _size;
+
+    bool _owned;
+};
+
+/// \brief Memory referenced by the tables of a mesh.
+///
+/// A FarMesh deletes its storage after its tables : the memory referenced
+/// by the tables (see FarTable::Reference()) is released along with the mesh.
+///
+class FarTableStorage {
+
+public:
+
+    virtual ~FarTableStorage() { }
+};
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_TABLE_H */
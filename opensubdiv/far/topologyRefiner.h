@@ -0,0 +1,939 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#ifndef FAR_TOPOLOGY_REFINER_H
+#define FAR_TOPOLOGY_REFINER_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/catmarkSubdivisionTables.h"
+#include "../far/kernelBatchFactory.h"
+#include "../far/patchTables.h"
+#include "../far/trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Creates uniformly refined Catmark FarMeshes from face-vertex arrays,
+/// without an HbrMesh.
+///
+/// FarMeshFactory walks a fully refined HbrMesh, which costs several
+/// pointer-linked records per vertex, half-edge and face of every level.
+/// FarTopologyRefiner takes the coarse topology as flat arrays (the number
+/// of vertices of each face and the face-vertex indices) with crease and
+/// corner sharpness tags, and refines it level by level into integer arrays,
+/// keeping only two levels at a time. It produces the same
+/// FarCatmarkSubdivisionTables, kernel batches and uniform FarPatchTables as
+/// FarMeshFactory would for the equivalent HbrMesh, except for the order of
+/// the refined vertices of each type (face, edge and vertex vertices) and of
+/// the quads.
+///
+/// Limitations : only the Catmark scheme and uniform refinement are
+/// supported. The mesh must be manifold and consistently oriented, and may
+/// not have holes, isolated vertices, hierarchical edits or face-varying
+/// data. Creases are refined with the normal (non Chaikin) rule.
+///
+/// Example :
+///
+///     FarTopologyRefiner<OsdVertex> refiner(nverts, nfaces, nvertsPerFace, faceVerts, 3);
+///     refiner.SetInterpolateBoundary(FarTopologyRefiner<OsdVertex>::INTERPOLATE_BOUNDARY_EDGE_ONLY);
+///     refiner.SetCreaseSharpness(0, 1, 2.0f);
+///     FarMesh<OsdVertex> * farMesh = refiner.Create();
+///
+template <class U> class FarTopologyRefiner {
+
+public:
+
+    /// Boundary interpolation rules (see HbrMesh::InterpolateBoundaryMethod)
+    enum InterpolateBoundary {
+        INTERPOLATE_BOUNDARY_NONE,
+        INTERPOLATE_BOUNDARY_EDGE_ONLY,
+        INTERPOLATE_BOUNDARY_EDGE_AND_CORNER
+    };
+
+    /// Edge rule next to triangles (see HbrCatmarkSubdivision::TriangleSubdivision)
+    enum TriangleSubdivision {
+        TRIANGLE_SUBDIVISION_CATMARK,   ///< standard Catmull-Clark weights
+        TRIANGLE_SUBDIVISION_SMOOTH     ///< "smoothtriangle" weights
+    };
+
+    /// Constructor : builds the edges and the adjacency of the coarse mesh.
+    ///
+    /// @param numVertices      the number of coarse vertices
+    ///
+    /// @param numFaces         the number of coarse faces
+    ///
+    /// @param numVertsPerFace  the number of vertices of each face
+    ///
+    /// @param faceVerts        the vertex indices of the faces, in
+    ///                         counter-clockwise order
+    ///
+    /// @param maxlevel         the highest level of subdivision
+    ///
+    FarTopologyRefiner( int numVertices, int numFaces, int const * numVertsPerFace,
+                        int const * faceVerts, int maxlevel );
+
+    /// True if the coarse topology is supported (see the limitations above)
+    bool IsValid() const { return _valid; }
+
+    /// Returns the highest level of subdivision
+    int GetMaxLevel() const { return _maxlevel; }
+
+    /// Returns the number of coarse vertices
+    int GetNumCoarseVertices() const { return _coarse.numVertices; }
+
+    /// Returns the number of coarse faces
+    int GetNumCoarseFaces() const { return _coarse.GetNumFaces(); }
+
+    /// Returns the number of coarse edges
+    int GetNumCoarseEdges() const { return _coarse.GetNumEdges(); }
+
+    /// Sets the boundary interpolation rule (default : none)
+    void SetInterpolateBoundary( InterpolateBoundary method ) { _interpolateBoundary = method; }
+
+    /// Sets the edge rule next to triangles (default : Catmark)
+    void SetTriangleSubdivision( TriangleSubdivision method ) { _triangleSubdivision = method; }
+
+    /// Sets the sharpness of the edge between two coarse vertices. Returns
+    /// false if there is no such edge.
+    bool SetCreaseSharpness( int v0, int v1, float sharpness );
+
+    /// Sets the sharpness of a coarse vertex. Returns false if the index is
+    /// out of range.
+    bool SetCornerSharpness( int vertex, float sharpness );
+
+    /// Creates a FarMesh, or returns 0 if the topology is not valid or the
+    /// maximum level is lower than 1.
+    ///
+    /// @param coarseVertices  if not null, the data of the coarse vertices
+    ///                        copied to the vertex buffer of the mesh
+    ///
+    FarMesh<U> * Create( U const * coarseVertices=0 );
+
+private:
+
+    // Compact topology of a level of subdivision : the refined faces are
+    // numbered after the face-vertex of their parent face ("corner") they
+    // come from, so that a level is entirely described by integer arrays.
+    struct Level {
+
+        Level() : numVertices(0) { }
+
+        int GetNumFaces() const { return (int)faceOffsets.size()-1; }
+
+        int GetNumEdges() const { return (int)edgeVerts.size()/2; }
+
+        int GetFaceSize(int face) const { return faceOffsets[face+1]-faceOffsets[face]; }
+
+        // Returns the face of a corner
+        int GetCornerFace(int corner) const {
+            return (int)(std::upper_bound(faceOffsets.begin(), faceOffsets.end(), corner) - faceOffsets.begin()) - 1;
+        }
+
+        void swap(Level & other);
+
+        int numVertices;
+
+        std::vector<int> faceOffsets,       // first corner of each face (+ total)
+                         faceVerts,         // vertex of each corner
+                         faceEdges,         // edge from each corner to the next one
+                         edgeVerts,         // 2 vertices per edge
+                         edgeFaces,         // 2 faces per edge (-1 on boundaries)
+                         vertEdgeOffsets,   // first incident edge of each vertex (+ total)
+                         vertEdges,         // incident edges
+                         vertCornerOffsets, // first incident corner of each vertex (+ total)
+                         vertCorners;       // incident corners
+
+        std::vector<float> edgeSharpness,
+                           vertSharpness;
+
+        // ptex face, coordinates and non-quad parent of the faces
+        std::vector<int> facePtex;
+        std::vector<unsigned short> faceU,
+                                    faceV;
+        std::vector<unsigned char> faceNonQuad;
+    };
+
+    // Builds the edges of the coarse level from its faces
+    static bool buildEdges( Level & level );
+
+    // Builds the edge-face and vertex adjacency of a level from its faces
+    // and edges
+    static bool buildAdjacency( Level & level );
+
+    // Returns the corner of 'vertex' that a walk around it starts from : the
+    // one with an outgoing boundary edge if there is one (see
+    // HbrVertex::AddIncidentEdge)
+    static int getRingStart( Level const & level, int vertex );
+
+    // Returns the next corner around the vertex of 'corner' (see
+    // HbrVertex::GetNextEdge), or -1 after the last face of a boundary
+    static int getRingNext( Level const & level, int corner );
+
+    // Computes the masks of a vertex (see HbrVertex::GetMask)
+    static void computeMasks( Level const & level, int vertex, unsigned char masks[2] );
+
+    // Returns the fractional mask of a vertex (see HbrVertex::GetFractionalMask)
+    static float computeFractionalMask( Level const & level, int vertex );
+
+    // Returns the sharpness of a child edge or vertex (see
+    // HbrSubdivision::SubdivideCreaseWeight)
+    static float subdivideSharpness( float sharpness );
+
+    // Returns the rank of a vertex from its masks (see
+    // FarSubdivisionTablesFactory::GetMaskRanking)
+    static int getMaskRanking( unsigned char mask0, unsigned char mask1 );
+
+    // Applies the boundary interpolation rule to the coarse sharpness
+    void interpolateBoundary( Level & level ) const;
+
+    // Refines 'parent' into 'child' and appends the subdivision tables and
+    // the kernel batches computing the vertices of 'child'
+    void refine( Level const & parent, int parentOffset, int childOffset, int level,
+                 FarCatmarkSubdivisionTables<U> * tables, FarKernelBatchVector * batches,
+                 Level & child ) const;
+
+    Level _coarse;
+
+    int _maxlevel,
+        _numPtexFaces;
+
+    bool _valid;
+
+    InterpolateBoundary _interpolateBoundary;
+
+    TriangleSubdivision _triangleSubdivision;
+};
+
+template <class U> void
+FarTopologyRefiner<U>::Level::swap( Level & other ) {
+    std::swap(numVertices, other.numVertices);
+    faceOffsets.swap(other.faceOffsets);
+    faceVerts.swap(other.faceVerts);
+    faceEdges.swap(other.faceEdges);
+    edgeVerts.swap(other.edgeVerts);
+    edgeFaces.swap(other.edgeFaces);
+    vertEdgeOffsets.swap(other.vertEdgeOffsets);
+    vertEdges.swap(other.vertEdges);
+    vertCornerOffsets.swap(other.vertCornerOffsets);
+    vertCorners.swap(other.vertCorners);
+    edgeSharpness.swap(other.edgeSharpness);
+    vertSharpness.swap(other.vertSharpness);
+    facePtex.swap(other.facePtex);
+    faceU.swap(other.faceU);
+    faceV.swap(other.faceV);
+    faceNonQuad.swap(other.faceNonQuad);
+}
+
+template <class U>
+FarTopologyRefiner<U>::FarTopologyRefiner( int numVertices, int numFaces, int const * numVertsPerFace,
+                                           int const * faceVerts, int maxlevel ) :
+    _maxlevel(maxlevel),
+    _numPtexFaces(0),
+    _valid(false),
+    _interpolateBoundary(INTERPOLATE_BOUNDARY_NONE),
+    _triangleSubdivision(TRIANGLE_SUBDIVISION_CATMARK)
+{
+    FAR_TRACE_SCOPE("FarTopologyRefiner::FarTopologyRefiner", "far");
+
+    if (numVertices<=0 or numFaces<=0 or (not numVertsPerFace) or (not faceVerts))
+        return;
+
+    Level & level = _coarse;
+
+    level.numVertices = numVertices;
+
+    level.faceOffsets.resize(numFaces+1);
+    level.faceOffsets[0] = 0;
+    for (int i=0; i<numFaces; ++i) {
+        if (numVertsPerFace[i]<3)
+            return;
+        level.faceOffsets[i+1] = level.faceOffsets[i] + numVertsPerFace[i];
+    }
+
+    int ncorners = level.faceOffsets[numFaces];
+    level.faceVerts.assign(faceVerts, faceVerts+ncorners);
+    for (int i=0; i<ncorners; ++i)
+        if (faceVerts[i]<0 or faceVerts[i]>=numVertices)
+            return;
+
+    // the coarse faces are ptex faces, except for the non-quads which have a
+    // ptex face per vertex
+    level.facePtex.resize(numFaces);
+    level.faceU.assign(numFaces, 0);
+    level.faceV.assign(numFaces, 0);
+    level.faceNonQuad.assign(numFaces, 0);
+    for (int i=0; i<numFaces; ++i) {
+        level.facePtex[i] = _numPtexFaces;
+        _numPtexFaces += numVertsPerFace[i]==4 ? 1 : numVertsPerFace[i];
+    }
+
+    if (not buildEdges(level) or not buildAdjacency(level))
+        return;
+
+    // each vertex must have a single fan of faces
+    for (int v=0; v<numVertices; ++v) {
+        int nfaces=0;
+        for (int c=getRingStart(level, v), start=c; c!=-1; ) {
+            ++nfaces;
+            c = getRingNext(level, c);
+            if (c==start)
+                break;
+        }
+        if (nfaces != level.vertCornerOffsets[v+1]-level.vertCornerOffsets[v])
+            return;
+    }
+
+    level.edgeSharpness.assign(level.GetNumEdges(), 0.0f);
+    level.vertSharpness.assign(numVertices, 0.0f);
+
+    _valid = true;
+}
+
+template <class U> bool
+FarTopologyRefiner<U>::SetCreaseSharpness( int v0, int v1, float sharpness ) {
+
+    if (not _valid or v0<0 or v0>=_coarse.numVertices)
+        return false;
+
+    for (int i=_coarse.vertEdgeOffsets[v0]; i<_coarse.vertEdgeOffsets[v0+1]; ++i) {
+        int e = _coarse.vertEdges[i];
+        if (_coarse.edgeVerts[2*e]==v1 or _coarse.edgeVerts[2*e+1]==v1) {
+            _coarse.edgeSharpness[e] = std::max(0.0f, sharpness);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class U> bool
+FarTopologyRefiner<U>::SetCornerSharpness( int vertex, float sharpness ) {
+
+    if (not _valid or vertex<0 or vertex>=_coarse.numVertices)
+        return false;
+
+    _coarse.vertSharpness[vertex] = std::max(0.0f, sharpness);
+    return true;
+}
+
+template <class U> bool
+FarTopologyRefiner<U>::buildEdges( Level & level ) {
+
+    // sort the corners by the vertices of their outgoing edge
+    typedef std::pair<std::pair<int,int>, int> CornerKey;
+
+    int ncorners = (int)level.faceVerts.size();
+
+    std::vector<CornerKey> keys(ncorners);
+    for (int f=0; f<level.GetNumFaces(); ++f) {
+        int n = level.GetFaceSize(f),
+            ofs = level.faceOffsets[f];
+        for (int k=0; k<n; ++k) {
+            int a = level.faceVerts[ofs+k],
+                b = level.faceVerts[ofs+(k+1)%n];
+            if (a==b)
+                return false;
+            keys[ofs+k] = CornerKey(std::make_pair(std::min(a,b), std::max(a,b)), ofs+k);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    level.faceEdges.resize(ncorners);
+    level.edgeVerts.clear();
+    level.edgeVerts.reserve(ncorners);
+
+    for (int i=0; i<ncorners; ) {
+
+        int e = level.GetNumEdges(),
+            c = keys[i].second,
+            f = level.GetCornerFace(c),
+            n = level.GetFaceSize(f),
+            org = level.faceVerts[c];
+
+        level.edgeVerts.push_back(org);
+        level.edgeVerts.push_back(level.faceVerts[level.faceOffsets[f]+(c-level.faceOffsets[f]+1)%n]);
+
+        int j=i;
+        for ( ; j<ncorners and keys[j].first==keys[i].first; ++j) {
+            // non-manifold edge, or faces with opposite orientations
+            if (j-i>1 or (j>i and level.faceVerts[keys[j].second]==org))
+                return false;
+            level.faceEdges[keys[j].second] = e;
+        }
+        i=j;
+    }
+    return true;
+}
+
+template <class U> bool
+FarTopologyRefiner<U>::buildAdjacency( Level & level ) {
+
+    int nverts = level.numVertices,
+        nedges = level.GetNumEdges();
+
+    // edge faces
+    level.edgeFaces.assign(nedges*2, -1);
+    for (int f=0; f<level.GetNumFaces(); ++f) {
+        for (int c=level.faceOffsets[f]; c<level.faceOffsets[f+1]; ++c) {
+            int e = level.faceEdges[c];
+            if (level.edgeFaces[2*e]==-1)
+                level.edgeFaces[2*e]=f;
+            else if (level.edgeFaces[2*e+1]==-1 and level.edgeFaces[2*e]!=f)
+                level.edgeFaces[2*e+1]=f;
+            else
+                return false;
+        }
+    }
+
+    // vertex edges
+    level.vertEdgeOffsets.assign(nverts+1, 0);
+    for (int i=0; i<nedges*2; ++i)
+        ++level.vertEdgeOffsets[level.edgeVerts[i]+1];
+    for (int v=0; v<nverts; ++v)
+        level.vertEdgeOffsets[v+1] += level.vertEdgeOffsets[v];
+
+    level.vertEdges.resize(nedges*2);
+    std::vector<int> counts(level.vertEdgeOffsets.begin(), level.vertEdgeOffsets.end()-1);
+    for (int i=0; i<nedges*2; ++i)
+        level.vertEdges[counts[level.edgeVerts[i]]++] = i/2;
+
+    // vertex corners
+    int ncorners = (int)level.faceVerts.size();
+    level.vertCornerOffsets.assign(nverts+1, 0);
+    for (int c=0; c<ncorners; ++c)
+        ++level.vertCornerOffsets[level.faceVerts[c]+1];
+    for (int v=0; v<nverts; ++v) {
+        if (level.vertCornerOffsets[v+1]==0)
+            return false; // isolated vertex
+        level.vertCornerOffsets[v+1] += level.vertCornerOffsets[v];
+    }
+
+    level.vertCorners.resize(ncorners);
+    counts.assign(level.vertCornerOffsets.begin(), level.vertCornerOffsets.end()-1);
+    for (int c=0; c<ncorners; ++c)
+        level.vertCorners[counts[level.faceVerts[c]]++] = c;
+
+    return true;
+}
+
+template <class U> int
+FarTopologyRefiner<U>::getRingStart( Level const & level, int vertex ) {
+
+    int first = level.vertCornerOffsets[vertex],
+        last = level.vertCornerOffsets[vertex+1];
+
+    for (int i=first; i<last; ++i) {
+        int c = level.vertCorners[i];
+        if (level.edgeFaces[2*level.faceEdges[c]+1]==-1)
+            return c;
+    }
+    return level.vertCorners[first];
+}
+
+template <class U> int
+FarTopologyRefiner<U>::getRingNext( Level const & level, int corner ) {
+
+    int f = level.GetCornerFace(corner),
+        n = level.GetFaceSize(f),
+        ofs = level.faceOffsets[f],
+        vertex = level.faceVerts[corner];
+
+    // the next face is across the edge coming into the vertex
+    int e = level.faceEdges[ofs+(corner-ofs+n-1)%n],
+        next = level.edgeFaces[2*e]==f ? level.edgeFaces[2*e+1] : level.edgeFaces[2*e];
+
+    if (next==-1)
+        return -1;
+
+    for (int c=level.faceOffsets[next]; c<level.faceOffsets[next+1]; ++c)
+        if (level.faceVerts[c]==vertex)
+            return c;
+
+    assert(0);
+    return -1;
+}
+
+template <class U> void
+FarTopologyRefiner<U>::computeMasks( Level const & level, int vertex, unsigned char masks[2] ) {
+
+    // sharp vertices are promoted to corners, then each sharp edge counts
+    float sharpness = level.vertSharpness[vertex];
+    masks[0] = sharpness>=1.0f ? 3 : 0;
+    masks[1] = sharpness>0.0f ? 3 : 0;
+
+    for (int i=level.vertEdgeOffsets[vertex]; i<level.vertEdgeOffsets[vertex+1]; ++i) {
+        float esharp = level.edgeSharpness[level.vertEdges[i]];
+        if (esharp>=1.0f and masks[0]<3)
+            ++masks[0];
+        if (esharp>0.0f and masks[1]<3)
+            ++masks[1];
+    }
+}
+
+template <class U> float
+FarTopologyRefiner<U>::computeFractionalMask( Level const & level, int vertex ) {
+
+    float mask=0.0f, n=0.0f;
+
+    float sharpness = level.vertSharpness[vertex];
+    if (sharpness>0.0f and sharpness<1.0f) {
+        mask += sharpness; ++n;
+    }
+
+    for (int i=level.vertEdgeOffsets[vertex]; i<level.vertEdgeOffsets[vertex+1]; ++i) {
+        float esharp = level.edgeSharpness[level.vertEdges[i]];
+        if (esharp>0.0f and esharp<1.0f) {
+            mask += esharp; ++n;
+        }
+    }
+    assert(n>0.0f and mask<n);
+    return mask/n;
+}
+
+template <class U> float
+FarTopologyRefiner<U>::subdivideSharpness( float sharpness ) {
+
+    if (sharpness>=10.0f)
+        return 10.0f;
+    return std::max(0.0f, sharpness-1.0f);
+}
+
+template <class U> int
+FarTopologyRefiner<U>::getMaskRanking( unsigned char mask0, unsigned char mask1 ) {
+    static short masks[4][4] = { {    0,    1,    6,    4 },
+                                 { 0xFF,    2,    5,    3 },
+                                 { 0xFF, 0xFF,    9,    7 },
+                                 { 0xFF, 0xFF, 0xFF,    8 } };
+    return masks[mask0][mask1];
+}
+
+template <class U> void
+FarTopologyRefiner<U>::interpolateBoundary( Level & level ) const {
+
+    if (_interpolateBoundary==INTERPOLATE_BOUNDARY_NONE)
+        return;
+
+    // boundary edges are infinitely sharp
+    for (int e=0; e<level.GetNumEdges(); ++e)
+        if (level.edgeFaces[2*e+1]==-1)
+            level.edgeSharpness[e] = 10.0f;
+
+    // so are the boundary vertices with 2 edges
+    if (_interpolateBoundary==INTERPOLATE_BOUNDARY_EDGE_AND_CORNER) {
+        for (int v=0; v<level.numVertices; ++v) {
+            int first = level.vertEdgeOffsets[v];
+            if (level.vertEdgeOffsets[v+1]-first==2 and
+                (level.edgeFaces[2*level.vertEdges[first]+1]==-1 or
+                 level.edgeFaces[2*level.vertEdges[first+1]+1]==-1))
+                level.vertSharpness[v] = 10.0f;
+        }
+    }
+}
+
+template <class U> FarMesh<U> *
+FarTopologyRefiner<U>::Create( U const * coarseVertices ) {
+
+    if (not _valid or _maxlevel<1)
+        return 0;
+
+    FAR_TRACE_SCOPE("FarTopologyRefiner::Create", "far");
+
+    FarMesh<U> * result = new FarMesh<U>();
+
+    FarCatmarkSubdivisionTables<U> * tables = new FarCatmarkSubdivisionTables<U>(result, _maxlevel);
+    result->_subdivisionTables = tables;
+    result->_batches.reserve(_maxlevel*5);
+
+    Level parent(_coarse), child;
+    interpolateBoundary(parent);
+
+    int parentOffset = 0,
+        childOffset = parent.numVertices;
+
+    for (int level=1; level<=_maxlevel; ++level) {
+
+        tables->_vertsOffsets[level] = childOffset;
+
+        refine(parent, parentOffset, childOffset, level, tables, &result->_batches, child);
+
+        parent.swap(child);
+        parentOffset = childOffset;
+        childOffset += parent.numVertices;
+    }
+    tables->_vertsOffsets[_maxlevel+1] = childOffset;
+
+    // If the vertex classes aren't place-holders, copy the data of the coarse
+    // vertices into the vertex buffer.
+    if (sizeof(U)>1) {
+        result->_vertices.resize(childOffset);
+        if (coarseVertices)
+            std::copy(coarseVertices, coarseVertices+_coarse.numVertices, result->_vertices.begin());
+    }
+
+    // Uniform patch tables : the quads of the last level
+    {
+    FAR_TRACE_SCOPE("FarTopologyRefiner::createPatchTables", "far");
+
+    int nfaces = parent.GetNumFaces();
+
+    FarPatchTables::PatchArrayVector patchArrays;
+    patchArrays.push_back(FarPatchTables::PatchArray(
+        FarPatchTables::Descriptor(FarPatchTables::QUADS, FarPatchTables::NON_TRANSITION, 0), 0, 0, nfaces, 0));
+
+    FarPatchTables::PTable patches(nfaces*4);
+    for (int i=0; i<nfaces*4; ++i)
+        patches[i] = parentOffset + parent.faceVerts[i];
+
+    FarPatchTables::PatchParamTable params(nfaces);
+    for (int f=0; f<nfaces; ++f) {
+        bool nonquad = parent.faceNonQuad[f]!=0;
+        params[f].Set(parent.facePtex[f], parent.faceU[f], parent.faceV[f], 0,
+                      (unsigned char)(nonquad ? _maxlevel-1 : _maxlevel), nonquad);
+    }
+
+    result->_patchTables = new FarPatchTables(patchArrays, patches, 0, 0, &params, 0, 0);
+    }
+
+    result->_numPtexFaces = _numPtexFaces;
+    result->_totalFVarWidth = 0;
+
+    return result;
+}
+
+template <class U> void
+FarTopologyRefiner<U>::refine( Level const & parent, int parentOffset, int childOffset, int level,
+                               FarCatmarkSubdivisionTables<U> * tables, FarKernelBatchVector * batches,
+                               Level & child ) const {
+
+    FAR_TRACE_SCOPE("FarTopologyRefiner::refine", "far");
+
+    int nfaces = parent.GetNumFaces(),
+        nedges = parent.GetNumEdges(),
+        nverts = parent.numVertices,
+        ncorners = (int)parent.faceVerts.size();
+
+    // Order the vertex vertices by the rank of their parent : the children of
+    // the faces come first, then the children of the edges, then those of
+    // the vertices.
+    std::vector<unsigned char> masks(nverts*2);
+    std::vector<int> ranks(nverts),
+                     vertOrder,
+                     vertChild(nverts);
+
+    for (int v=0; v<nverts; ++v) {
+        computeMasks(parent, v, &masks[2*v]);
+        ranks[v] = getMaskRanking(masks[2*v], masks[2*v+1]);
+        assert(ranks[v]!=0xFF);
+    }
+
+    vertOrder.reserve(nverts);
+    for (int rank=0; rank<10; ++rank)
+        for (int v=0; v<nverts; ++v)
+            if (ranks[v]==rank) {
+                vertChild[v] = nfaces + nedges + (int)vertOrder.size();
+                vertOrder.push_back(v);
+            }
+
+    // Face vertices
+    int faceTableOffset = (int)tables->_F_ITa.size()/2;
+
+    if (nfaces>0)
+        batches->push_back(FarKernelBatch( FarKernelBatch::CATMARK_FACE_VERTEX,
+                                           level,
+                                           0,
+                                           0,
+                                           nfaces,
+                                           faceTableOffset,
+                                           childOffset) );
+
+    for (int f=0; f<nfaces; ++f) {
+        tables->_F_ITa.push_back((int)tables->_F_IT.size());
+        tables->_F_ITa.push_back(parent.GetFaceSize(f));
+        for (int c=parent.faceOffsets[f]; c<parent.faceOffsets[f+1]; ++c)
+            tables->_F_IT.push_back(parentOffset + parent.faceVerts[c]);
+    }
+
+    // Edge vertices
+    int edgeTableOffset = (int)tables->_E_W.size()/2;
+
+    if (nedges>0)
+        batches->push_back(FarKernelBatch( FarKernelBatch::CATMARK_EDGE_VERTEX,
+                                           level,
+                                           0,
+                                           0,
+                                           nedges,
+                                           edgeTableOffset,
+                                           childOffset + nfaces) );
+
+    for (int e=0; e<nedges; ++e) {
+
+        float esharp = parent.edgeSharpness[e];
+
+        tables->_E_IT.push_back(parentOffset + parent.edgeVerts[2*e]);
+        tables->_E_IT.push_back(parentOffset + parent.edgeVerts[2*e+1]);
+
+        float faceWeight=0.5f, vertWeight=0.5f;
+
+        int lf = parent.edgeFaces[2*e],
+            rf = parent.edgeFaces[2*e+1];
+
+        // in the case of a fractional sharpness, set the adjacent faces vertices
+        if (rf!=-1 and esharp<=1.0f) {
+
+            // 0.470 is HBR_SMOOTH_TRI_EDGE_WEIGHT
+            float leftWeight = (_triangleSubdivision==TRIANGLE_SUBDIVISION_SMOOTH and parent.GetFaceSize(lf)==3) ? 0.470f : 0.25f,
+                  rightWeight = (_triangleSubdivision==TRIANGLE_SUBDIVISION_SMOOTH and parent.GetFaceSize(rf)==3) ? 0.470f : 0.25f;
+
+            faceWeight = 0.5f * (leftWeight + rightWeight);
+            vertWeight = 0.5f * (1.0f - 2.0f * faceWeight);
+
+            faceWeight *= (1.0f - esharp);
+
+            vertWeight = 0.5f * esharp + (1.0f - esharp) * vertWeight;
+
+            tables->_E_IT.push_back(childOffset + lf);
+            tables->_E_IT.push_back(childOffset + rf);
+        } else {
+            tables->_E_IT.push_back(-1);
+            tables->_E_IT.push_back(-1);
+        }
+        tables->_E_W.push_back(vertWeight);
+        tables->_E_W.push_back(faceWeight);
+    }
+
+    // Vertex vertices (see FarCatmarkSubdivisionTablesFactory::Create for the
+    // multi-pass interpolation)
+    int vertTableOffset = (int)tables->_V_W.size();
+
+    FarVertexKernelBatchFactory batchFactory(nverts, 0);
+
+    for (int i=0; i<nverts; ++i) {
+
+        int v = vertOrder[i];
+
+        unsigned char const * vmasks = &masks[2*v];
+        int npasses;
+        float weights[2];
+
+        if (vmasks[0]!=vmasks[1] and (not (vmasks[0]==0 and vmasks[1]==1))) {
+            weights[1] = computeFractionalMask(parent, v);
+            weights[0] = 1.0f - weights[1];
+            npasses = 2;
+        } else {
+            weights[0] = 1.0f;
+            weights[1] = 0.0f;
+            npasses = 1;
+        }
+
+        tables->_V_ITa.resize(tables->_V_ITa.size()+5, -1);
+
+        int * V_ITa = &tables->_V_ITa[tables->_V_ITa.size()-5];
+        V_ITa[0] = (int)tables->_V_IT.size();
+        V_ITa[1] = 0;
+        V_ITa[2] = parentOffset + v;
+
+        for (int p=0; p<npasses; ++p)
+            switch (vmasks[p]) {
+                case 0 :    // smooth
+                case 1 : {  // dart
+                    for (int c=getRingStart(parent, v), start=c; c!=-1; ) {
+                        int f = parent.GetCornerFace(c),
+                            n = parent.GetFaceSize(f),
+                            ofs = parent.faceOffsets[f];
+
+                        V_ITa[1]++;
+                        tables->_V_IT.push_back(parentOffset + parent.faceVerts[ofs+(c-ofs+1)%n]);
+                        tables->_V_IT.push_back(childOffset + f);
+
+                        c = getRingNext(parent, c);
+                        if (c==start)
+                            break;
+                    }
+                    break;
+                }
+                case 2 : {  // crease
+                    int count=0;
+                    for (int j=parent.vertEdgeOffsets[v]; j<parent.vertEdgeOffsets[v+1] and count<2; ++j) {
+                        int e = parent.vertEdges[j];
+                        float esharp = parent.edgeSharpness[e];
+                        if (p==1 ? esharp>0.0f : esharp>=1.0f) {
+                            int w = parent.edgeVerts[2*e]==v ? parent.edgeVerts[2*e+1] : parent.edgeVerts[2*e];
+                            V_ITa[3+count++] = parentOffset + w;
+                        }
+                    }
+                    assert(count==2);
+                    break;
+                }
+                case 3 :    // corner
+                    // in the case of a k_Crease / k_Corner pass combination, we
+                    // need to set the valence to -1 to tell the "B" Kernel to
+                    // switch to k_Corner rule (as edge indices won't be -1)
+                    if (V_ITa[1]==0)
+                        V_ITa[1] = -1;
+
+                default : break;
+            }
+
+        // the k_Corner and k_Crease single-pass cases apply a weight of 1.0
+        // but this value is inverted in the kernel
+        tables->_V_W.push_back(ranks[v]>7 ? 0.0f : weights[0]);
+
+        batchFactory.AddVertex(i, ranks[v]);
+    }
+
+    if (nverts>0)
+        batchFactory.AppendCatmarkBatches(level, vertTableOffset, childOffset + nfaces + nedges, batches);
+
+    // Child topology : a quad per corner, 2 child edges per edge and an edge
+    // per corner between the child of its outgoing edge and the child of its
+    // face. The vertices of the children of quads are rotated so as to
+    // preserve their parameterization (see HbrCatmarkSubdivision::RefineFaceAtVertex).
+    child.numVertices = nfaces + nedges + nverts;
+
+    child.faceOffsets.resize(ncorners+1);
+    for (int c=0; c<=ncorners; ++c)
+        child.faceOffsets[c] = 4*c;
+
+    child.faceVerts.resize(ncorners*4);
+    child.faceEdges.resize(ncorners*4);
+
+    child.facePtex.resize(ncorners);
+    child.faceU.resize(ncorners);
+    child.faceV.resize(ncorners);
+    child.faceNonQuad.resize(ncorners);
+
+    for (int f=0; f<nfaces; ++f) {
+
+        int n = parent.GetFaceSize(f),
+            ofs = parent.faceOffsets[f];
+
+        for (int i=0; i<n; ++i) {
+
+            int c = ofs+i,
+                v = parent.faceVerts[c],
+                enext = parent.faceEdges[c],
+                eprev = parent.faceEdges[ofs+(i+n-1)%n];
+
+            int verts[4] = { vertChild[v], nfaces + enext, f, nfaces + eprev },
+                edges[4] = { 2*enext + (parent.edgeVerts[2*enext]==v ? 0 : 1),
+                             2*nedges + c,
+                             2*nedges + ofs + (i+n-1)%n,
+                             2*eprev + (parent.edgeVerts[2*eprev]==v ? 0 : 1) };
+
+            int rot = n==4 ? i : 0;
+            for (int j=0; j<4; ++j) {
+                child.faceVerts[4*c+(j+rot)%4] = verts[j];
+                child.faceEdges[4*c+(j+rot)%4] = edges[j];
+            }
+
+            if (n==4) {
+                child.facePtex[c] = parent.facePtex[f];
+                child.faceU[c] = (unsigned short)(parent.faceU[f]*2 + ((i==1 or i==2) ? 1 : 0));
+                child.faceV[c] = (unsigned short)(parent.faceV[f]*2 + ((i==2 or i==3) ? 1 : 0));
+                child.faceNonQuad[c] = parent.faceNonQuad[f];
+            } else {
+                child.facePtex[c] = parent.facePtex[f] + i;
+                child.faceU[c] = child.faceV[c] = 0;
+                child.faceNonQuad[c] = 1;
+            }
+        }
+    }
+
+    int nchildEdges = 2*nedges + ncorners;
+
+    child.edgeVerts.resize(nchildEdges*2);
+    child.edgeSharpness.assign(nchildEdges, 0.0f);
+
+    for (int e=0; e<nedges; ++e) {
+        child.edgeVerts[4*e+0] = vertChild[parent.edgeVerts[2*e]];
+        child.edgeVerts[4*e+1] = nfaces + e;
+        child.edgeVerts[4*e+2] = nfaces + e;
+        child.edgeVerts[4*e+3] = vertChild[parent.edgeVerts[2*e+1]];
+
+        if (parent.edgeSharpness[e]>0.0f)
+            child.edgeSharpness[2*e] = child.edgeSharpness[2*e+1] =
+                subdivideSharpness(parent.edgeSharpness[e]);
+    }
+
+    for (int f=0; f<nfaces; ++f)
+        for (int c=parent.faceOffsets[f]; c<parent.faceOffsets[f+1]; ++c) {
+            child.edgeVerts[2*(2*nedges+c)+0] = nfaces + parent.faceEdges[c];
+            child.edgeVerts[2*(2*nedges+c)+1] = f;
+        }
+
+    child.vertSharpness.assign(child.numVertices, 0.0f);
+    for (int v=0; v<nverts; ++v)
+        if (parent.vertSharpness[v]>0.0f)
+            child.vertSharpness[vertChild[v]] = subdivideSharpness(parent.vertSharpness[v]);
+
+    bool valid = buildAdjacency(child);
+    assert(valid);
+    (void)valid;
+}
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif /* FAR_TOPOLOGY_REFINER_H */
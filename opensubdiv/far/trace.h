@@ -0,0 +1,322 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef FAR_TRACE_H
+#define FAR_TRACE_H
+
+#include "../version.h"
+
+#ifdef OPENSUBDIV_TRACE
+
+#include "../far/kernelStats.h"
+
+#include <cstdio>
+#include <ostream>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #if defined(__linux__)
+        #include <sys/syscall.h>
+    #endif
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Timeline of the mesh construction and refinement.
+///
+/// When OpenSubdiv is built with OPENSUBDIV_TRACE defined (cmake -DTRACE=1),
+/// the factories, compute contexts, dispatcher and CPU controllers open
+/// FAR_TRACE_SCOPE spans, recorded with their thread into the current
+/// FarTrace. Without the define, the spans compile to nothing and FarTrace
+/// is not declared.
+///
+/// The events can be written as Chrome trace-event JSON, to be loaded in a
+/// timeline viewer (chrome://tracing, Perfetto).
+///
+/// Spans can be recorded from several threads at once (parallel kernels,
+/// refine schedulers) : the events are appended under a lock.
+///
+/// Example :
+///
+///     FarTrace trace;
+///     FarTrace::SetCurrent(&trace);
+///     FarMeshFactory<OsdVertex> factory(hmesh, level);
+///     FarMesh<OsdVertex> * mesh = factory.Create();
+///     ...
+///     FarTrace::SetCurrent(0);
+///     std::ofstream file("refine.json");
+///     trace.WriteJSON(file);
+///
+class FarTrace {
+
+public:
+
+    /// \brief A completed span
+    struct Event {
+        char const * name,      ///< name of the span (static string)
+                   * category;  ///< category of the span (static string)
+        double begin,           ///< start in seconds since the trace creation
+               end;             ///< end in seconds since the trace creation
+        long threadId;          ///< system identifier of the recording thread
+    };
+
+    /// Constructor
+    FarTrace() : _origin(FarKernelStats::GetTime()) {
+#if defined(_WIN32)
+        InitializeCriticalSection(&_lock);
+#else
+        pthread_mutex_init(&_lock, 0);
+#endif
+    }
+
+    /// Destructor
+    ~FarTrace() {
+#if defined(_WIN32)
+        DeleteCriticalSection(&_lock);
+#else
+        pthread_mutex_destroy(&_lock);
+#endif
+    }
+
+    /// Returns the trace the spans are recorded into (null by default)
+    static FarTrace * GetCurrent() {
+        return *getCurrent();
+    }
+
+    /// Sets the trace the spans are recorded into (null stops the recording)
+    static void SetCurrent(FarTrace * trace) {
+        *getCurrent() = trace;
+    }
+
+    /// Returns the system identifier of the calling thread
+    static long GetThreadId() {
+#if defined(_WIN32)
+        return (long)GetCurrentThreadId();
+#elif defined(__linux__)
+        return (long)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+        return (long)pthread_mach_thread_np(pthread_self());
+#else
+        return (long)(size_t)pthread_self();
+#endif
+    }
+
+    /// Returns the time in seconds since the creation of the trace
+    double GetTime() const {
+        return FarKernelStats::GetTime() - _origin;
+    }
+
+    /// Records a span of the calling thread
+    ///
+    /// @param name      name of the span (must outlive the trace)
+    ///
+    /// @param category  category of the span (must outlive the trace)
+    ///
+    /// @param begin     start of the span (see GetTime())
+    ///
+    /// @param end       end of the span (see GetTime())
+    ///
+    void AddEvent(char const * name, char const * category, double begin, double end) {
+
+        Event event;
+        event.name = name;
+        event.category = category;
+        event.begin = begin;
+        event.end = end;
+        event.threadId = GetThreadId();
+
+        lock();
+        _events.push_back(event);
+        unlock();
+    }
+
+    /// Returns the number of recorded spans
+    int GetNumEvents() const {
+        return (int)_events.size();
+    }
+
+    /// Returns a recorded span
+    Event const & GetEvent(int index) const {
+        return _events[index];
+    }
+
+    /// Removes all the recorded spans
+    void Clear() {
+        lock();
+        _events.clear();
+        unlock();
+    }
+
+    /// Writes the spans as Chrome trace-event JSON ('complete' events, in
+    /// microseconds)
+    void WriteJSON(std::ostream & out) const {
+
+#if defined(_WIN32)
+        long processId = (long)GetCurrentProcessId();
+#else
+        long processId = (long)getpid();
+#endif
+
+        out << "{\"traceEvents\":[";
+        for (int i = 0; i < (int)_events.size(); ++i) {
+            Event const & event = _events[i];
+            char line[512];
+            snprintf(line, sizeof(line),
+                     "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,"
+                     "\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld}",
+                     i ? "," : "", event.name, event.category, event.begin * 1e6,
+                     (event.end - event.begin) * 1e6, processId, event.threadId);
+            out << line;
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+private:
+
+    FarTrace(FarTrace const &);
+    FarTrace & operator = (FarTrace const &);
+
+    static FarTrace ** getCurrent() {
+        static FarTrace * current = 0;
+        return &current;
+    }
+
+    void lock() {
+#if defined(_WIN32)
+        EnterCriticalSection(&_lock);
+#else
+        pthread_mutex_lock(&_lock);
+#endif
+    }
+
+    void unlock() {
+#if defined(_WIN32)
+        LeaveCriticalSection(&_lock);
+#else
+        pthread_mutex_unlock(&_lock);
+#endif
+    }
+
+    std::vector<Event> _events;
+
+    double _origin;
+
+#if defined(_WIN32)
+    CRITICAL_SECTION _lock;
+#else
+    pthread_mutex_t _lock;
+#endif
+};
+
+/// \brief Records a span from its construction to its destruction into the
+/// current FarTrace (see FAR_TRACE_SCOPE).
+class FarTraceScope {
+
+public:
+
+    /// Constructor
+    ///
+    /// @param name      name of the span (static string)
+    ///
+    /// @param category  category of the span (static string)
+    ///
+    explicit FarTraceScope(char const * name, char const * category="far") :
+        _trace(FarTrace::GetCurrent()), _name(name), _category(category),
+        _begin(_trace ? _trace->GetTime() : 0.0) { }
+
+    /// Destructor
+    ~FarTraceScope() {
+        if (_trace)
+            _trace->AddEvent(_name, _category, _begin, _trace->GetTime());
+    }
+
+private:
+
+    FarTraceScope(FarTraceScope const &);
+    FarTraceScope & operator = (FarTraceScope const &);
+
+    FarTrace * _trace;
+
+    char const * _name,
+               * _category;
+
+    double _begin;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#define FAR_TRACE_CONCAT_(a, b) a##b
+#define FAR_TRACE_CONCAT(a, b) FAR_TRACE_CONCAT_(a, b)
+
+// Opens a span until the end of the enclosing scope
+#define FAR_TRACE_SCOPE(name, category) \
+    OpenSubdiv::FarTraceScope FAR_TRACE_CONCAT(farTraceScope, __LINE__)(name, category)
+
+#else
+
+#define FAR_TRACE_SCOPE(name, category)
+
+#endif  // OPENSUBDIV_TRACE
+
+#endif  // FAR_TRACE_H
@@ -60,6 +60,8 @@
 
 #include "../version.h"
 
+#include "../far/memoryReport.h"
+
 #include <assert.h>
 #include <utility>
 #include <vector>
@@ -151,6 +153,7 @@ public:
     private:
         template <class X, class Y> friend class FarVertexEditTablesFactory;
         template <class X, class Y> friend class FarMultiMeshFactory;
+        template <class X> friend class FarMeshSerializer;
 
         std::vector<unsigned int> _vertIndices;  // absolute vertex index array for edits
         std::vector<float>        _edits;        // edit values array
@@ -164,9 +167,18 @@ public:
         return _batches[index];
     }
 
+    /// Adds the memory allocated by the edit batches to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the tables in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report, std::string const & prefix=std::string()) const;
+
 private:
     template <class X, class Y> friend class FarVertexEditTablesFactory;
     template <class X, class Y> friend class FarMultiMeshFactory;
+    template <class X> friend class FarMeshSerializer;
     template <class CONTROLLER> friend class FarComputeController;
 
     // Compute-kernel that applies the edits
@@ -213,6 +225,16 @@ FarVertexEditTables<U>::FarVertexEditTables( FarMesh<U> * mesh ) :
     _mesh(mesh) {
 }
 
+template <class U> void
+FarVertexEditTables<U>::ReportMemoryUsage(FarMemoryReport & report, std::string const & prefix) const {
+
+    report.Add(prefix + "batches", _batches);
+    for (int i=0; i<(int)_batches.size(); ++i) {
+        report.Add(prefix + "vertexIndices", _batches[i].GetVertexIndices());
+        report.Add(prefix + "values", _batches[i].GetValues());
+    }
+}
+
 template <class U> void
 FarVertexEditTables<U>::computeVertexEdits(int tableIndex, int offset, int tableOffset, int start, int end, void *clientdata) const {
 
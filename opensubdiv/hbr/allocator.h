@@ -91,6 +91,11 @@ public:
 
     void SetMemStatsDecrement(void (*decrement)(size_t bytes)) { m_decrement = decrement; }
 
+    /// Returns the memory used by the blocks and the block array
+    size_t GetMemStats() const {
+        return (size_t)m_nblocks * m_blocksize * m_elemsize + m_blockCapacity * sizeof(T*);
+    }
+
 private:
     size_t *m_memorystat;
     const int m_blocksize;
@@ -230,6 +230,14 @@ public:
     // Returns memory statistics
     size_t GetMemStats() const { return m_memory; }
 
+    // Returns the memory used by the face, vertex and face children blocks
+    size_t GetFaceMemStats() const { return m_faceAllocator.GetMemStats(); }
+    size_t GetVertexMemStats() const { return m_vertexAllocator.GetMemStats(); }
+    size_t GetFaceChildrenMemStats() const { return m_faceChildrenAllocator.GetMemStats(); }
+
+    // Returns the memory used by the arrays of the mesh
+    size_t GetArrayMemStats() const;
+
     // Interpolate boundary management
     enum InterpolateBoundaryMethod {
         k_InterpolateBoundaryNone,
@@ -844,6 +852,19 @@ HbrMesh<T>::GetNumFaces() const {
     return count;
 }
 
+template <class T>
+size_t
+HbrMesh<T>::GetArrayMemStats() const {
+    return vertices.capacity() * sizeof(HbrVertex<T>*) +
+        vertexClientData.capacity() * sizeof(void*) +
+        faces.capacity() * sizeof(HbrFace<T>*) +
+        faceClientData.capacity() * sizeof(void*) +
+        gcVertices.capacity() * sizeof(HbrVertex<T>*) +
+        hierarchicalEdits.capacity() * sizeof(HbrHierarchicalEdit<T>*) +
+        m_transientVertices.capacity() * sizeof(HbrVertex<T>*) +
+        m_transientFaces.capacity() * sizeof(HbrFace<T>*);
+}
+
 template <class T>
 int
 HbrMesh<T>::GetNumCoarseFaces() const {
@@ -0,0 +1,316 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_ASYNC_COMPUTE_CONTROLLER_H
+#define OSD_ASYNC_COMPUTE_CONTROLLER_H
+
+#include "../version.h"
+
+#include "../far/kernelBatch.h"
+#include "../far/stencilTables.h"
+#include "../osd/asyncQueue.h"
+#include "../osd/vertexDescriptor.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Compute controller running the refinement of a CPU compute
+/// controller on a background thread.
+///
+/// OsdAsyncComputeController wraps an OsdCpuComputeController,
+/// OsdOmpComputeController or OsdThreadPoolComputeController : its Refine
+/// functions queue the refinement and return immediately with a handle, which
+/// lets the application deform the coarse vertices of a mesh while another
+/// one is being refined. The refinements run in the order they were queued.
+///
+/// The kernel batches are copied, but the context, the buffers and the
+/// stencil tables must be kept alive and left untouched until the refinement
+/// completes : wait for its handle, or call Synchronize, before updating the
+/// coarse vertices of a buffer or reading its refined vertices back. The
+/// wrapped controller must not be used directly while refinements are
+/// pending.
+///
+/// The controller can be used in place of the wrapped one with OsdMesh and
+/// OsdUtilMeshBatch, whose Synchronize then waits for the refinement.
+///
+template <class CONTROLLER>
+class OsdAsyncComputeController {
+public:
+    typedef CONTROLLER Controller;
+    typedef typename CONTROLLER::ComputeContext ComputeContext;
+    typedef OsdAsyncQueue::Handle Handle;
+
+    /// Constructor.
+    ///
+    /// @param controller  the controller running the kernels, which is not
+    ///                    owned by the async controller
+    ///
+    explicit OsdAsyncComputeController(CONTROLLER * controller) :
+        _controller(controller) { }
+
+    /// Destructor : waits for the pending refinements.
+    ~OsdAsyncComputeController() {
+        Synchronize();
+    }
+
+    /// Queues the subdivision kernels and returns immediately.
+    ///
+    /// @param  context       the context to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    /// @return the handle of the refinement
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    Handle Refine(ComputeContext *context,
+                  FarKernelBatchVector const & batches,
+                  VERTEX_BUFFER *vertexBuffer,
+                  VARYING_BUFFER *varyingBuffer) {
+
+        return _queue.Push(new BatchJob<VERTEX_BUFFER, VARYING_BUFFER>(
+            _controller, context, batches, vertexBuffer, varyingBuffer));
+    }
+
+    /// Queues the subdivision kernels and returns immediately.
+    ///
+    /// @param  context       the context to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @return the handle of the refinement
+    ///
+    template<class VERTEX_BUFFER>
+    Handle Refine(ComputeContext *context,
+                  FarKernelBatchVector const & batches,
+                  VERTEX_BUFFER *vertexBuffer) {
+
+        return Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Queues the subdivision kernels applied to the elements of given vertex
+    /// buffers described by buffer descriptors, and returns immediately.
+    ///
+    /// @param  context       the context to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the primvar elements of the vertex buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    /// @param  varyingDesc   the primvar elements of the varying buffer
+    ///
+    /// @return the handle of the refinement
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    Handle Refine(ComputeContext *context,
+                  FarKernelBatchVector const & batches,
+                  VERTEX_BUFFER * vertexBuffer,
+                  OsdVertexBufferDescriptor const & vertexDesc,
+                  VARYING_BUFFER * varyingBuffer,
+                  OsdVertexBufferDescriptor const & varyingDesc) {
+
+        return _queue.Push(new BatchJob<VERTEX_BUFFER, VARYING_BUFFER>(
+            _controller, context, batches, vertexBuffer, varyingBuffer,
+            &vertexDesc, &varyingDesc));
+    }
+
+    /// Queues the application of stencil tables and returns immediately.
+    ///
+    /// @param  context         the context to apply refinement operations to
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer
+    ///
+    /// @return the handle of the refinement
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    Handle Refine(ComputeContext *context,
+                  FarStencilTables const * vertexStencils,
+                  FarStencilTables const * varyingStencils,
+                  VERTEX_BUFFER * vertexBuffer,
+                  VARYING_BUFFER * varyingBuffer) {
+
+        return _queue.Push(new StencilJob<VERTEX_BUFFER, VARYING_BUFFER>(
+            _controller, context, vertexStencils, varyingStencils,
+            vertexBuffer, varyingBuffer));
+    }
+
+    /// Returns true if the refinement 'handle' and the ones queued before it
+    /// are complete
+    bool IsComplete(Handle handle) const {
+        return _queue.IsComplete(handle);
+    }
+
+    /// Waits until the refinement 'handle' and the ones queued before it
+    /// are complete.
+    void Wait(Handle handle) const {
+        _queue.Wait(handle);
+    }
+
+    /// Waits until all the queued refinements are complete.
+    void Synchronize() {
+        _queue.WaitAll();
+        _controller->Synchronize();
+    }
+
+    /// Returns the number of refinements queued or running
+    int GetNumPending() const {
+        return _queue.GetNumPending();
+    }
+
+    /// Returns the controller running the kernels
+    CONTROLLER * GetController() const {
+        return _controller;
+    }
+
+private:
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    class BatchJob : public OsdAsyncQueue::Job {
+    public:
+        BatchJob(CONTROLLER * controller,
+                 ComputeContext * context,
+                 FarKernelBatchVector const & batches,
+                 VERTEX_BUFFER * vertexBuffer,
+                 VARYING_BUFFER * varyingBuffer,
+                 OsdVertexBufferDescriptor const * vertexDesc=0,
+                 OsdVertexBufferDescriptor const * varyingDesc=0) :
+            _controller(controller), _context(context), _batches(batches),
+            _vertexBuffer(vertexBuffer), _varyingBuffer(varyingBuffer),
+            _hasDescriptors(vertexDesc != 0) {
+
+            if (_hasDescriptors) {
+                _vertexDesc = *vertexDesc;
+                _varyingDesc = *varyingDesc;
+            }
+        }
+
+        virtual void Run() {
+            if (_hasDescriptors) {
+                _controller->Refine(_context, _batches,
+                                    _vertexBuffer, _vertexDesc,
+                                    _varyingBuffer, _varyingDesc);
+            } else {
+                _controller->Refine(_context, _batches,
+                                    _vertexBuffer, _varyingBuffer);
+            }
+        }
+
+    private:
+        CONTROLLER * _controller;
+        ComputeContext * _context;
+        FarKernelBatchVector _batches;
+        VERTEX_BUFFER * _vertexBuffer;
+        VARYING_BUFFER * _varyingBuffer;
+        OsdVertexBufferDescriptor _vertexDesc,
+                                  _varyingDesc;
+        bool _hasDescriptors;
+    };
+
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    class StencilJob : public OsdAsyncQueue::Job {
+    public:
+        StencilJob(CONTROLLER * controller,
+                   ComputeContext * context,
+                   FarStencilTables const * vertexStencils,
+                   FarStencilTables const * varyingStencils,
+                   VERTEX_BUFFER * vertexBuffer,
+                   VARYING_BUFFER * varyingBuffer) :
+            _controller(controller), _context(context),
+            _vertexStencils(vertexStencils), _varyingStencils(varyingStencils),
+            _vertexBuffer(vertexBuffer), _varyingBuffer(varyingBuffer) { }
+
+        virtual void Run() {
+            _controller->Refine(_context, _vertexStencils, _varyingStencils,
+                                _vertexBuffer, _varyingBuffer);
+        }
+
+    private:
+        CONTROLLER * _controller;
+        ComputeContext * _context;
+        FarStencilTables const * _vertexStencils,
+                               * _varyingStencils;
+        VERTEX_BUFFER * _vertexBuffer;
+        VARYING_BUFFER * _varyingBuffer;
+    };
+
+    CONTROLLER * _controller;
+
+    OsdAsyncQueue _queue;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_ASYNC_COMPUTE_CONTROLLER_H
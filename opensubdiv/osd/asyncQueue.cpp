@@ -0,0 +1,171 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/asyncQueue.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+OsdAsyncQueue::OsdAsyncQueue() :
+    _pushed(0), _completed(0), _quit(false) {
+
+    pthread_mutex_init(&_lock, 0);
+    pthread_cond_init(&_wake, 0);
+    pthread_cond_init(&_done, 0);
+
+    pthread_create(&_thread, 0, threadMain, this);
+}
+
+OsdAsyncQueue::~OsdAsyncQueue() {
+
+    pthread_mutex_lock(&_lock);
+    _quit = true;
+    pthread_cond_signal(&_wake);
+    pthread_mutex_unlock(&_lock);
+
+    pthread_join(_thread, 0);
+
+    pthread_cond_destroy(&_done);
+    pthread_cond_destroy(&_wake);
+    pthread_mutex_destroy(&_lock);
+}
+
+OsdAsyncQueue::Handle
+OsdAsyncQueue::Push(Job * job) {
+
+    pthread_mutex_lock(&_lock);
+    _jobs.push_back(job);
+    Handle handle = ++_pushed;
+    pthread_cond_signal(&_wake);
+    pthread_mutex_unlock(&_lock);
+
+    return handle;
+}
+
+bool
+OsdAsyncQueue::IsComplete(Handle handle) const {
+
+    pthread_mutex_lock(&_lock);
+    bool complete = _completed >= handle;
+    pthread_mutex_unlock(&_lock);
+
+    return complete;
+}
+
+void
+OsdAsyncQueue::Wait(Handle handle) const {
+
+    pthread_mutex_lock(&_lock);
+    while (_completed < handle)
+        pthread_cond_wait(&_done, &_lock);
+    pthread_mutex_unlock(&_lock);
+}
+
+void
+OsdAsyncQueue::WaitAll() const {
+
+    pthread_mutex_lock(&_lock);
+    while (_completed < _pushed)
+        pthread_cond_wait(&_done, &_lock);
+    pthread_mutex_unlock(&_lock);
+}
+
+int
+OsdAsyncQueue::GetNumPending() const {
+
+    pthread_mutex_lock(&_lock);
+    int numPending = (int)(_pushed - _completed);
+    pthread_mutex_unlock(&_lock);
+
+    return numPending;
+}
+
+void *
+OsdAsyncQueue::threadMain(void * data) {
+
+    static_cast<OsdAsyncQueue *>(data)->threadLoop();
+    return 0;
+}
+
+void
+OsdAsyncQueue::threadLoop() {
+
+    pthread_mutex_lock(&_lock);
+    for (;;) {
+        // the pending jobs are run before quitting
+        while (not _quit and _jobs.empty())
+            pthread_cond_wait(&_wake, &_lock);
+
+        if (_jobs.empty())
+            break;
+
+        Job * job = _jobs.front();
+        _jobs.pop_front();
+        pthread_mutex_unlock(&_lock);
+
+        job->Run();
+        delete job;
+
+        pthread_mutex_lock(&_lock);
+        ++_completed;
+        pthread_cond_broadcast(&_done);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
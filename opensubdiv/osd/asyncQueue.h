@@ -0,0 +1,135 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_ASYNC_QUEUE_H
+#define OSD_ASYNC_QUEUE_H
+
+#include "../version.h"
+
+#include <pthread.h>
+#include <deque>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Runs jobs in order on a background thread.
+///
+/// OsdAsyncQueue hands out a handle for each job it is given. Jobs are run
+/// one after the other in the order they were pushed, so that a job can rely
+/// on the results of the jobs pushed before it, and waiting for a handle
+/// also waits for all the jobs that precede it.
+///
+class OsdAsyncQueue {
+public:
+    /// \brief A unit of work run on the background thread.
+    class Job {
+    public:
+        virtual ~Job() { }
+
+        virtual void Run() = 0;
+    };
+
+    /// Identifies a job pushed to the queue. Handles increase with each job.
+    typedef long long Handle;
+
+    /// Constructor : starts the background thread.
+    OsdAsyncQueue();
+
+    /// Destructor : runs the pending jobs and joins the background thread.
+    ~OsdAsyncQueue();
+
+    /// Queues 'job', which is deleted once it has run, and returns its handle
+    Handle Push(Job * job);
+
+    /// Returns true if the job 'handle' and the jobs before it have run
+    bool IsComplete(Handle handle) const;
+
+    /// Blocks until the job 'handle' and the jobs before it have run
+    void Wait(Handle handle) const;
+
+    /// Blocks until all the jobs pushed so far have run
+    void WaitAll() const;
+
+    /// Returns the number of jobs waiting or running
+    int GetNumPending() const;
+
+private:
+    static void * threadMain(void * data);
+
+    // runs the queued jobs until the queue is destroyed
+    void threadLoop();
+
+    pthread_t _thread;
+
+    mutable pthread_mutex_t _lock;  // guards the state below
+
+    mutable pthread_cond_t _wake,   // signals a new job (or destruction)
+                           _done;   // signals the completion of a job
+
+    std::deque<Job *> _jobs;
+
+    Handle _pushed,                 // handle of the last job pushed
+           _completed;              // handle of the last job run
+
+    bool _quit;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_ASYNC_QUEUE_H
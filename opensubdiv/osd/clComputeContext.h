@@ -79,9 +79,9 @@ class OsdCLKernelBundle;
 
 class OsdCLTable : OsdNonCopyable<OsdCLTable> {
 public:
-    template<typename T>
-        OsdCLTable(const std::vector<T> &table, cl_context clContext) {
-        createCLBuffer(table.size() * sizeof(T), &table[0], clContext);
+    template<class TABLE>
+        OsdCLTable(const TABLE &table, cl_context clContext) {
+        createCLBuffer(table.size() * sizeof(typename TABLE::value_type), &table[0], clContext);
     }
 
     virtual ~OsdCLTable();
@@ -59,12 +59,15 @@
 #include "../far/dispatcher.h"
 #include "../far/catmarkSubdivisionTables.h"
 #include "../far/bilinearSubdivisionTables.h"
+#include "../far/trace.h"
 
 #include "../osd/cpuComputeContext.h"
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/vertexDescriptor.h"
 #include "../osd/error.h"
 
+#include <cassert>
 #include <cstring>
 
 namespace OpenSubdiv {
@@ -75,26 +78,22 @@ OsdCpuTable::createCpuBuffer(size_t size, const void *ptr) {
 
     _devicePtr = new unsigned char[size];
     memcpy(_devicePtr, ptr, size);
+    _size = size;
+    _owned = true;
 }
 
 OsdCpuTable::~OsdCpuTable() {
 
-    if (_devicePtr) 
+    if (_devicePtr and _owned)
         delete [] (unsigned char *)_devicePtr;
 }
 
-void *
-OsdCpuTable::GetBuffer() const {
-
-    return _devicePtr;
-}
-
 // ----------------------------------------------------------------------------
 
 OsdCpuHEditTable::OsdCpuHEditTable(
-    const FarVertexEditTables<OsdVertex>::VertexEditBatch &batch)
-    : _primvarIndicesTable(new OsdCpuTable(batch.GetVertexIndices())),
-      _editValuesTable(new OsdCpuTable(batch.GetValues())) {
+    const FarVertexEditTables<OsdVertex>::VertexEditBatch &batch, bool copy)
+    : _primvarIndicesTable(new OsdCpuTable(batch.GetVertexIndices(), copy)),
+      _editValuesTable(new OsdCpuTable(batch.GetValues(), copy)) {
 
     _operation = batch.GetOperation();
     _primvarOffset = batch.GetPrimvarIndex();
@@ -137,23 +136,27 @@ OsdCpuHEditTable::GetPrimvarWidth() const {
     return _primvarWidth;
 }
 
-OsdCpuComputeContext::OsdCpuComputeContext(FarMesh<OsdVertex> const *farMesh) {
+OsdCpuComputeContext::OsdCpuComputeContext(FarMesh<OsdVertex> const *farMesh,
+                                           TableStorage storage) :
+    _tableStorage(storage) {
 
     FarSubdivisionTables<OsdVertex> const * farTables =
         farMesh->GetSubdivisionTables();
 
+    bool copy = (storage == TABLES_COPY);
+
     // allocate 5 or 7 tables
     _tables.resize(farTables->GetNumTables(), 0);
 
-    _tables[FarSubdivisionTables<OsdVertex>::E_IT]  = new OsdCpuTable(farTables->Get_E_IT());
-    _tables[FarSubdivisionTables<OsdVertex>::V_IT]  = new OsdCpuTable(farTables->Get_V_IT());
-    _tables[FarSubdivisionTables<OsdVertex>::V_ITa] = new OsdCpuTable(farTables->Get_V_ITa());
-    _tables[FarSubdivisionTables<OsdVertex>::E_W]   = new OsdCpuTable(farTables->Get_E_W());
-    _tables[FarSubdivisionTables<OsdVertex>::V_W]   = new OsdCpuTable(farTables->Get_V_W());
+    _tables[FarSubdivisionTables<OsdVertex>::E_IT]  = new OsdCpuTable(farTables->Get_E_IT(), copy);
+    _tables[FarSubdivisionTables<OsdVertex>::V_IT]  = new OsdCpuTable(farTables->Get_V_IT(), copy);
+    _tables[FarSubdivisionTables<OsdVertex>::V_ITa] = new OsdCpuTable(farTables->Get_V_ITa(), copy);
+    _tables[FarSubdivisionTables<OsdVertex>::E_W]   = new OsdCpuTable(farTables->Get_E_W(), copy);
+    _tables[FarSubdivisionTables<OsdVertex>::V_W]   = new OsdCpuTable(farTables->Get_V_W(), copy);
 
     if (farTables->GetNumTables() > 5) {
-        _tables[FarSubdivisionTables<OsdVertex>::F_IT]  = new OsdCpuTable(farTables->Get_F_IT());
-        _tables[FarSubdivisionTables<OsdVertex>::F_ITa] = new OsdCpuTable(farTables->Get_F_ITa());
+        _tables[FarSubdivisionTables<OsdVertex>::F_IT]  = new OsdCpuTable(farTables->Get_F_IT(), copy);
+        _tables[FarSubdivisionTables<OsdVertex>::F_ITa] = new OsdCpuTable(farTables->Get_F_ITa(), copy);
     }
 
     // create hedit tables
@@ -165,11 +168,17 @@ OsdCpuComputeContext::OsdCpuComputeContext(FarMesh<OsdVertex> const *farMesh) {
             const FarVertexEditTables<OsdVertex>::VertexEditBatch & edit =
                 editTables->GetBatch(i);
 
-            _editTables.push_back(new OsdCpuHEditTable(edit));
+            _editTables.push_back(new OsdCpuHEditTable(edit, copy));
         }
     }
     _currentVertexBuffer = 0;
     _currentVaryingBuffer = 0;
+    _vertexPrecision = OSD_PRECISION_FLOAT;
+    _varyingPrecision = OSD_PRECISION_FLOAT;
+    _numVertexSamples = 1;
+    _kernelBundle = 0;
+    _kernelISA = OsdCpuSimd::ISA_NONE;
+    _streamingLevel = -1;
 }
 
 OsdCpuComputeContext::~OsdCpuComputeContext() {
@@ -182,10 +191,25 @@ OsdCpuComputeContext::~OsdCpuComputeContext() {
     }
 }
 
-const OsdCpuTable *
-OsdCpuComputeContext::GetTable(int tableIndex) const {
+void
+OsdCpuComputeContext::ReportMemoryUsage(FarMemoryReport & report,
+                                        std::string const & prefix) const {
 
-    return _tables[tableIndex];
+    static char const * tableNames[FarSubdivisionTables<OsdVertex>::TABLE_TYPES_COUNT] =
+        { "E_IT", "E_W", "V_ITa", "V_IT", "V_W", "F_ITa", "F_IT" };
+
+    for (size_t i = 0; i < _tables.size(); ++i) {
+        if (_tables[i] and _tables[i]->IsOwned())
+            report.Add(prefix + "tables." + tableNames[i], _tables[i]->GetSize());
+    }
+    for (size_t i = 0; i < _editTables.size(); ++i) {
+        OsdCpuTable const * indices = _editTables[i]->GetPrimvarIndices(),
+                          * values = _editTables[i]->GetEditValues();
+        if (indices->IsOwned())
+            report.Add(prefix + "editTables.vertexIndices", indices->GetSize());
+        if (values->IsOwned())
+            report.Add(prefix + "editTables.values", values->GetSize());
+    }
 }
 
 int
@@ -203,19 +227,34 @@ OsdCpuComputeContext::GetEditTable(int tableIndex) const {
 float *
 OsdCpuComputeContext::GetCurrentVertexBuffer() const {
 
-    return _currentVertexBuffer;
+    assert(_vertexPrecision == OSD_PRECISION_FLOAT);
+    return static_cast<float *>(_currentVertexBuffer);
 }
 
 float *
 OsdCpuComputeContext::GetCurrentVaryingBuffer() const {
 
-    return _currentVaryingBuffer;
+    assert(_varyingPrecision == OSD_PRECISION_FLOAT);
+    return static_cast<float *>(_currentVaryingBuffer);
+}
+
+void
+OsdCpuComputeContext::bindKernelBundle() {
+
+    _kernelBundle = OsdCpuGetKernelBundle(_kernelISA,
+                                          _vdesc.numVertexElements,
+                                          _vdesc.numVaryingElements,
+                                          _vertexPrecision,
+                                          _varyingPrecision);
 }
 
 OsdCpuComputeContext *
-OsdCpuComputeContext::Create(FarMesh<OsdVertex> const *farmesh) {
+OsdCpuComputeContext::Create(FarMesh<OsdVertex> const *farmesh,
+                             TableStorage storage) {
+
+    FAR_TRACE_SCOPE("OsdCpuComputeContext::Create", "osd");
 
-    return new OsdCpuComputeContext(farmesh);
+    return new OsdCpuComputeContext(farmesh, storage);
 }
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -61,38 +61,78 @@
 
 #include "../far/subdivisionTables.h"
 #include "../far/vertexEditTables.h"
+#include "../far/memoryReport.h"
 #include "../osd/vertex.h"
 #include "../osd/vertexDescriptor.h"
+#include "../osd/half.h"
+#include "../osd/cpuSimd.h"
 #include "../osd/nonCopyable.h"
 
+#ifdef OPENSUBDIV_KERNEL_STATS
+    #include "../far/kernelStats.h"
+#endif
+
+#include <cassert>
 #include <stdlib.h>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 struct OsdVertexDescriptor;
+struct OsdCpuKernelBundle;
 
 class OsdCpuTable : OsdNonCopyable<OsdCpuTable> {
 public:
-    template<typename T>
-    explicit OsdCpuTable(const std::vector<T> &table) {
-        createCpuBuffer(table.size() * sizeof(T), &table[0]);
+    /// Constructor
+    ///
+    /// @param table  the Far table
+    ///
+    /// @param copy   copies the table. Otherwise the Osd table references the
+    ///               data of 'table', which must neither be modified nor
+    ///               destroyed during the lifetime of the Osd table.
+    ///
+    template<class TABLE>
+    explicit OsdCpuTable(const TABLE &table, bool copy=true) {
+        typedef typename TABLE::value_type T;
+        if (copy) {
+            createCpuBuffer(table.size() * sizeof(T), &table[0]);
+        } else {
+            _devicePtr = table.empty() ? 0 : const_cast<T *>(&table[0]);
+            _size = table.size() * sizeof(T);
+            _owned = false;
+        }
     }
 
     virtual ~OsdCpuTable();
 
-    void * GetBuffer() const;
+    void * GetBuffer() const {
+        return _devicePtr;
+    }
+
+    /// Returns true if the table owns a copy of its data
+    bool IsOwned() const {
+        return _owned;
+    }
+
+    /// Returns the size of the table in bytes
+    size_t GetSize() const {
+        return _size;
+    }
 
 private:
     void createCpuBuffer(size_t size, const void *ptr);
 
     void *_devicePtr;
+
+    size_t _size;
+
+    bool _owned;
 };
 
 class OsdCpuHEditTable : OsdNonCopyable<OsdCpuHEditTable> {
 public:
     OsdCpuHEditTable(const FarVertexEditTables<OsdVertex>::
-                      VertexEditBatch &batch);
+                      VertexEditBatch &batch, bool copy=true);
 
     virtual ~OsdCpuHEditTable();
 
@@ -124,14 +164,28 @@ private:
 /// geometric primitives with the capabilities of the selected discrete 
 /// compute device.
 ///
+/// By default the context copies the subdivision and hierarchical edit tables
+/// of the FarMesh. With TABLES_SHARED, it references the tables of the
+/// FarMesh instead : the mesh must then outlive the context and its tables
+/// must not change, but any number of contexts can share a single copy of
+/// the tables.
+///
 class OsdCpuComputeContext : OsdNonCopyable<OsdCpuComputeContext> {
 
 public:
+    enum TableStorage {
+        TABLES_COPY,    ///< the context owns a copy of the tables
+        TABLES_SHARED   ///< the context references the tables of the FarMesh
+    };
+
     /// Creates an OsdCpuComputeContext instance
     ///
     /// @param farmesh the FarMesh used for this Context.
     ///
-    static OsdCpuComputeContext * Create(FarMesh<OsdVertex> const *farmesh);
+    /// @param storage copies the tables of the FarMesh, or references them
+    ///
+    static OsdCpuComputeContext * Create(FarMesh<OsdVertex> const *farmesh,
+                                         TableStorage storage=TABLES_COPY);
 
     /// Destructor
     virtual ~OsdCpuComputeContext();
@@ -140,6 +194,9 @@ public:
     /// that data buffers are properly inter-operated between Contexts and 
     /// Controllers operating across multiple devices.
     ///
+    /// The buffers may hold single (float) or half precision (OsdHalf) data,
+    /// as returned by their BindCpuBuffer() method.
+    ///
     /// @param vertex   a buffer containing vertex-interpolated primvar data
     ///
     /// @param varying  a buffer containing varying-interpolated primvar data
@@ -147,26 +204,116 @@ public:
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
     void Bind(VERTEX_BUFFER *vertex, VARYING_BUFFER *varying) {
 
-        _currentVertexBuffer = vertex ? vertex->BindCpuBuffer() : 0;
-        _currentVaryingBuffer = varying ? varying->BindCpuBuffer() : 0;
-
         int numVertexElements = vertex ? vertex->GetNumElements() : 0;
         int numVaryingElements = varying ? varying->GetNumElements() : 0;
-        _vdesc.Set(numVertexElements, numVaryingElements);
+
+        Bind(vertex, OsdVertexBufferDescriptor(0, numVertexElements,
+                                               numVertexElements),
+             varying, OsdVertexBufferDescriptor(0, numVaryingElements,
+                                                numVaryingElements));
+    }
+
+    /// Binds a subset of the elements of vertex and varying data buffers to
+    /// the context : the primvars can be interleaved with other data, which
+    /// is left untouched. Both descriptors may refer to the same buffer.
+    ///
+    /// @param vertex      a buffer containing vertex-interpolated primvar data
+    ///
+    /// @param vertexDesc  offset, number and stride of the vertex-interpolated
+    ///                    elements in the vertex buffer
+    ///
+    /// @param varying     a buffer containing varying-interpolated primvar data
+    ///
+    /// @param varyingDesc offset, number and stride of the varying-interpolated
+    ///                    elements in the varying buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Bind(VERTEX_BUFFER *vertex,
+              OsdVertexBufferDescriptor const & vertexDesc,
+              VARYING_BUFFER *varying,
+              OsdVertexBufferDescriptor const & varyingDesc) {
+
+        _currentVertexBuffer = vertex ?
+            bindData(vertex->BindCpuBuffer(), vertexDesc,
+                     vertex->GetNumElements(), &_vertexPrecision) : 0;
+        _currentVaryingBuffer = varying ?
+            bindData(varying->BindCpuBuffer(), varyingDesc,
+                     varying->GetNumElements(), &_varyingPrecision) : 0;
+
+        _vdesc.Set(vertex ? vertexDesc.length : 0,
+                   varying ? varyingDesc.length : 0,
+                   vertex ? vertexDesc.stride : 0,
+                   varying ? varyingDesc.stride : 0);
+
+        _numVertexSamples = 1;
+
+        _kernelISA = OsdCpuSimd::GetISA();
+        bindKernelBundle();
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+        // the traffic of the kernels scales with the size of the bound vertices
+        if (FarKernelStats * stats = FarKernelStats::GetCurrent())
+            stats->SetVertexSize(
+                _vdesc.numVertexElements * (_vertexPrecision == OSD_PRECISION_HALF ? sizeof(OsdHalf) : sizeof(float)) +
+                _vdesc.numVaryingElements * (_varyingPrecision == OSD_PRECISION_HALF ? sizeof(OsdHalf) : sizeof(float)));
+#endif
+    }
+
+    /// Binds a vertex buffer holding several samples of the vertex-interpolated
+    /// primvars (instances or time samples of the mesh), interleaved in each
+    /// vertex : sample 's' starts at element vertexDesc.offset +
+    /// s * vertexDesc.length. The kernels refine all the samples at once, as a
+    /// single primvar of numSamples * vertexDesc.length elements.
+    ///
+    /// @param vertex      a buffer containing vertex-interpolated primvar data
+    ///
+    /// @param vertexDesc  offset, number and stride of the elements of the
+    ///                    first sample in the vertex buffer
+    ///
+    /// @param numSamples  number of consecutive samples in each vertex
+    ///
+    /// @param varying     a buffer containing varying-interpolated primvar data
+    ///
+    /// @param varyingDesc offset, number and stride of the varying-interpolated
+    ///                    elements in the varying buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void BindSamples(VERTEX_BUFFER *vertex,
+                     OsdVertexBufferDescriptor const & vertexDesc,
+                     int numSamples,
+                     VARYING_BUFFER *varying,
+                     OsdVertexBufferDescriptor const & varyingDesc) {
+
+        assert(numSamples > 0);
+
+        Bind(vertex, OsdVertexBufferDescriptor(vertexDesc.offset,
+                                               vertexDesc.length * numSamples,
+                                               vertexDesc.stride),
+             varying, varyingDesc);
+
+        _numVertexSamples = numSamples;
     }
 
     /// Unbinds any previously bound vertex and varying data buffers.
     void Unbind() {
         _currentVertexBuffer = 0;
         _currentVaryingBuffer = 0;
+        _numVertexSamples = 1;
+        _vertexPrecision = OSD_PRECISION_FLOAT;
+        _varyingPrecision = OSD_PRECISION_FLOAT;
         _vdesc.Reset();
+        _kernelBundle = 0;
+        _kernelISA = OsdCpuSimd::ISA_NONE;
+        _streamingLevel = -1;
     }
 
     /// Returns one of the vertex refinement tables.
     ///
     /// @param tableIndex the type of table
     ///
-    const OsdCpuTable * GetTable(int tableIndex) const;
+    const OsdCpuTable * GetTable(int tableIndex) const {
+        return _tables[tableIndex];
+    }
 
     /// Returns an OsdVertexDescriptor if vertex buffers have been bound.
     ///
@@ -176,6 +323,62 @@ public:
         return _vdesc;
     }
 
+    /// Returns the CPU kernels selected for the currently bound buffers
+    /// (specialized for the primvar widths when possible).
+    OsdCpuKernelBundle const * GetKernelBundle() const {
+        return _kernelBundle;
+    }
+
+    /// Selects the kernels of another instruction set for the currently bound
+    /// buffers (Bind() selects the kernels of OsdCpuSimd::GetISA()). The
+    /// variants produce identical results : this only trades the SIMD setup
+    /// cost against its throughput. Reset by Unbind().
+    ///
+    /// @param isa  the instruction set (the portable scalar kernels are
+    ///             selected if it is not supported)
+    ///
+    void SetKernelISA(OsdCpuSimd::ISA isa) {
+        if (not OsdCpuSimd::IsSupported(isa))
+            isa = OsdCpuSimd::ISA_NONE;
+        if (isa != _kernelISA) {
+            _kernelISA = isa;
+            bindKernelBundle();
+        }
+    }
+
+    /// Returns the instruction set of the kernels selected for the currently
+    /// bound buffers
+    OsdCpuSimd::ISA GetKernelISA() const {
+        return _kernelISA;
+    }
+
+    /// Sets the subdivision level whose vertices are written with non-temporal
+    /// stores (-1 disables streaming stores). Reset by Unbind().
+    void SetStreamingLevel(int level) {
+        _streamingLevel = level;
+    }
+
+    /// Returns the subdivision level written with non-temporal stores
+    int GetStreamingLevel() const {
+        return _streamingLevel;
+    }
+
+    /// Returns the storage of the tables
+    TableStorage GetTableStorage() const {
+        return _tableStorage;
+    }
+
+    /// Adds the memory allocated by the tables owned by the context to a
+    /// report. The tables referenced with TABLES_SHARED are reported by the
+    /// FarMesh.
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the components in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report,
+                           std::string const & prefix=std::string()) const;
+
     /// Returns the number of hierarchical edit tables
     int GetNumEditTables() const;
 
@@ -185,23 +388,83 @@ public:
     ///
     const OsdCpuHEditTable * GetEditTable(int tableIndex) const;
 
-    /// Returns a pointer to the vertex-interpolated data
+    /// Returns a pointer to the vertex-interpolated data (single precision
+    /// buffers only)
     float * GetCurrentVertexBuffer() const;
 
-    /// Returns a pointer to the varying-interpolated data
+    /// Returns a pointer to the varying-interpolated data (single precision
+    /// buffers only)
     float * GetCurrentVaryingBuffer() const;
 
+    /// Returns a pointer to the vertex-interpolated data, of any precision
+    void * GetCurrentVertexData() const {
+        return _currentVertexBuffer;
+    }
+
+    /// Returns a pointer to the varying-interpolated data, of any precision
+    void * GetCurrentVaryingData() const {
+        return _currentVaryingBuffer;
+    }
+
+    /// Returns the number of samples interleaved in the vertex buffer (see
+    /// BindSamples())
+    int GetNumVertexSamples() const {
+        return _numVertexSamples;
+    }
+
+    /// Returns the storage precision of the vertex-interpolated data
+    OsdPrecision GetVertexPrecision() const {
+        return _vertexPrecision;
+    }
+
+    /// Returns the storage precision of the varying-interpolated data
+    OsdPrecision GetVaryingPrecision() const {
+        return _varyingPrecision;
+    }
+
 protected:
-    explicit OsdCpuComputeContext(FarMesh<OsdVertex> const *farMesh);
+    OsdCpuComputeContext(FarMesh<OsdVertex> const *farMesh,
+                         TableStorage storage);
+
+    // records the precision of the data of a bound buffer and returns the
+    // address of the first element described by 'desc'
+    template <class T>
+    static void * bindData(T *data, OsdVertexBufferDescriptor const & desc,
+                           int numElements, OsdPrecision *precision) {
+        assert(desc.offset >= 0 and desc.length >= 0 and
+               desc.offset + desc.length <= desc.stride and
+               desc.stride <= numElements);
+        (void)numElements;
+
+        *precision = OsdGetPrecision(data);
+        return data + desc.offset;
+    }
+
+    // selects the kernels of the current instruction set matching the bound
+    // vertex descriptor
+    void bindKernelBundle();
 
 private:
     std::vector<OsdCpuTable*> _tables;
     std::vector<OsdCpuHEditTable*> _editTables;
 
-    float *_currentVertexBuffer, 
-          *_currentVaryingBuffer;
+    TableStorage _tableStorage;
+
+    void *_currentVertexBuffer,
+         *_currentVaryingBuffer;
+
+    int _numVertexSamples;
+
+    OsdPrecision _vertexPrecision,
+                 _varyingPrecision;
 
     OsdVertexDescriptor _vdesc;
+
+    OsdCpuKernelBundle const * _kernelBundle;
+
+    OsdCpuSimd::ISA _kernelISA;
+
+    int _streamingLevel;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -58,17 +58,100 @@
 #include "../osd/cpuComputeContext.h"
 #include "../osd/cpuComputeController.h"
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 
-OsdCpuComputeController::OsdCpuComputeController() {
+OsdCpuComputeController::OsdCpuComputeController() :
+    _streamingStores(false) {
 }
 
 OsdCpuComputeController::~OsdCpuComputeController() {
 }
 
+int
+OsdCpuComputeController::getFinestLevel(FarKernelBatchVector const & batches) {
+
+    int level = -1;
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        // vertex edits are applied in place and do not stream
+        if (batches[i].GetKernelType() != FarKernelBatch::HIERARCHICAL_EDIT and
+            batches[i].GetLevel() > level)
+            level = batches[i].GetLevel();
+    }
+    return level;
+}
+
+int
+OsdCpuComputeController::getFinestLevel(FarStencilBatchVector const & batches) {
+
+    int level = -1;
+    for (int i = 0; i < (int)batches.size(); ++i) {
+        if (batches[i].GetBatchType() == FarStencilBatch::STENCILS and
+            batches[i].GetLevel() > level)
+            level = batches[i].GetLevel();
+    }
+    return level;
+}
+
+void
+OsdCpuComputeController::applyStencils(
+    OsdCpuComputeContext *context,
+    FarStencilTables const * vertexStencils,
+    FarStencilTables const * varyingStencils) const {
+
+    assert(context and vertexStencils);
+
+    FAR_TRACE_SCOPE("OsdCpuComputeController::applyStencils", "refine");
+
+    FarStencilBatchVector const & batches = vertexStencils->GetBatches();
+
+    // both tables are generated from the same mesh : their batches match
+    void * varying = varyingStencils ? context->GetCurrentVaryingData() : 0;
+    assert(not varyingStencils or
+           varyingStencils->GetBatches().size() == batches.size());
+
+    for (int i = 0; i < (int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType() == FarStencilBatch::HIERARCHICAL_EDIT) {
+            ApplyVertexEdits(batch.GetEditBatch(), context);
+            continue;
+        }
+
+        if (batch.GetStart() == batch.GetEnd())
+            continue;
+
+        bool streaming = batch.GetLevel() == context->GetStreamingLevel();
+
+        context->GetKernelBundle()->computeVertexStencils(
+            context->GetVertexDescriptor(),
+            context->GetCurrentVertexData(),
+            &vertexStencils->GetSizes()[0],
+            &vertexStencils->GetOffsets()[0],
+            &vertexStencils->GetIndices()[0],
+            &vertexStencils->GetWeights()[0],
+            batch.GetVertexOffset(), batch.GetTableOffset(),
+            batch.GetStart(), batch.GetEnd(), streaming);
+
+        if (varying) {
+            FarStencilBatch const & ybatch = varyingStencils->GetBatches()[i];
+            context->GetKernelBundle()->computeVaryingStencils(
+                context->GetVertexDescriptor(),
+                varying,
+                &varyingStencils->GetSizes()[0],
+                &varyingStencils->GetOffsets()[0],
+                &varyingStencils->GetIndices()[0],
+                &varyingStencils->GetWeights()[0],
+                ybatch.GetVertexOffset(), ybatch.GetTableOffset(),
+                ybatch.GetStart(), ybatch.GetEnd(), streaming);
+        }
+    }
+}
+
 void
 OsdCpuComputeController::ApplyBilinearFaceVerticesKernel(
     FarKernelBatch const &batch, void * clientdata) const {
@@ -77,10 +160,10 @@ OsdCpuComputeController::ApplyBilinearFaceVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeFace(
+    context->GetKernelBundle()->computeFace(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::F_IT)->GetBuffer(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::F_ITa)->GetBuffer(),
         batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
@@ -94,12 +177,13 @@ OsdCpuComputeController::ApplyBilinearEdgeVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeBilinearEdge(
+    context->GetKernelBundle()->computeBilinearEdge(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::E_IT)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -110,12 +194,13 @@ OsdCpuComputeController::ApplyBilinearVertexVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeBilinearVertex(
+    context->GetKernelBundle()->computeBilinearVertex(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -126,10 +211,10 @@ OsdCpuComputeController::ApplyCatmarkFaceVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeFace(
+    context->GetKernelBundle()->computeFace(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::F_IT)->GetBuffer(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::F_ITa)->GetBuffer(),
         batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
@@ -143,13 +228,14 @@ OsdCpuComputeController::ApplyCatmarkEdgeVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeEdge(
+    context->GetKernelBundle()->computeEdge(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::E_IT)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::E_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -160,14 +246,15 @@ OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelB(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexB(
+    context->GetKernelBundle()->computeVertexB(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_IT)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -178,13 +265,14 @@ OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelA1(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexA(
+    context->GetKernelBundle()->computeVertexA(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), false);
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), false,
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -195,13 +283,14 @@ OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelA2(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexA(
+    context->GetKernelBundle()->computeVertexA(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), true);
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), true,
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -212,13 +301,14 @@ OsdCpuComputeController::ApplyLoopEdgeVerticesKernel(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeEdge(
+    context->GetKernelBundle()->computeEdge(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::E_IT)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::E_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -229,14 +319,15 @@ OsdCpuComputeController::ApplyLoopVertexVerticesKernelB(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeLoopVertexB(
+    context->GetKernelBundle()->computeLoopVertexB(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_IT)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd());
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(),
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -247,13 +338,14 @@ OsdCpuComputeController::ApplyLoopVertexVerticesKernelA1(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexA(
+    context->GetKernelBundle()->computeVertexA(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), false);
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), false,
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -264,13 +356,14 @@ OsdCpuComputeController::ApplyLoopVertexVerticesKernelA2(
         static_cast<OsdCpuComputeContext*>(clientdata);
     assert(context);
 
-    OsdCpuComputeVertexA(
+    context->GetKernelBundle()->computeVertexA(
         context->GetVertexDescriptor(),
-        context->GetCurrentVertexBuffer(),
-        context->GetCurrentVaryingBuffer(),
+        context->GetCurrentVertexData(),
+        context->GetCurrentVaryingData(),
         (const int*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_ITa)->GetBuffer(),
         (const float*)context->GetTable(FarSubdivisionTables<OsdVertex>::V_W)->GetBuffer(),
-        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), true);
+        batch.GetVertexOffset(), batch.GetTableOffset(), batch.GetStart(), batch.GetEnd(), true,
+        batch.GetLevel() == context->GetStreamingLevel());
 }
 
 void
@@ -287,28 +380,60 @@ OsdCpuComputeController::ApplyVertexEdits(
     const OsdCpuTable * primvarIndices = edit->GetPrimvarIndices();
     const OsdCpuTable * editValues = edit->GetEditValues();
 
-    if (edit->GetOperation() == FarVertexEdit::Add) {
-        OsdCpuEditVertexAdd(context->GetVertexDescriptor(),
-                            context->GetCurrentVertexBuffer(),
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(), 
-                            batch.GetTableOffset(), 
-                            batch.GetStart(), 
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
-    } else if (edit->GetOperation() == FarVertexEdit::Set) {
-        OsdCpuEditVertexSet(context->GetVertexDescriptor(),
-                            context->GetCurrentVertexBuffer(),
-                            edit->GetPrimvarOffset(),
-                            edit->GetPrimvarWidth(),
-                            batch.GetVertexOffset(), 
-                            batch.GetTableOffset(), 
-                            batch.GetStart(), 
-                            batch.GetEnd(),
-                            static_cast<unsigned int*>(primvarIndices->GetBuffer()),
-                            static_cast<float*>(editValues->GetBuffer()));
+    // the edits apply to each sample interleaved in the vertex buffer
+    int numSamples = context->GetNumVertexSamples(),
+        sampleWidth = context->GetVertexDescriptor().numVertexElements / numSamples;
+
+    for (int sample = 0; sample < numSamples; ++sample) {
+
+        int primvarOffset = edit->GetPrimvarOffset() + sample * sampleWidth;
+
+        if (context->GetVertexPrecision() == OSD_PRECISION_HALF) {
+            OsdHalf * vertex = static_cast<OsdHalf*>(context->GetCurrentVertexData());
+            if (edit->GetOperation() == FarVertexEdit::Add) {
+                OsdCpuEditHalfVertexAdd(context->GetVertexDescriptor(), vertex,
+                                        primvarOffset,
+                                        edit->GetPrimvarWidth(),
+                                        batch.GetVertexOffset(),
+                                        batch.GetTableOffset(),
+                                        batch.GetStart(),
+                                        batch.GetEnd(),
+                                        static_cast<unsigned int*>(primvarIndices->GetBuffer()),
+                                        static_cast<float*>(editValues->GetBuffer()));
+            } else if (edit->GetOperation() == FarVertexEdit::Set) {
+                OsdCpuEditHalfVertexSet(context->GetVertexDescriptor(), vertex,
+                                        primvarOffset,
+                                        edit->GetPrimvarWidth(),
+                                        batch.GetVertexOffset(),
+                                        batch.GetTableOffset(),
+                                        batch.GetStart(),
+                                        batch.GetEnd(),
+                                        static_cast<unsigned int*>(primvarIndices->GetBuffer()),
+                                        static_cast<float*>(editValues->GetBuffer()));
+            }
+        } else if (edit->GetOperation() == FarVertexEdit::Add) {
+            OsdCpuEditVertexAdd(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                primvarOffset,
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(), 
+                                batch.GetTableOffset(), 
+                                batch.GetStart(), 
+                                batch.GetEnd(),
+                                static_cast<unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<float*>(editValues->GetBuffer()));
+        } else if (edit->GetOperation() == FarVertexEdit::Set) {
+            OsdCpuEditVertexSet(context->GetVertexDescriptor(),
+                                context->GetCurrentVertexBuffer(),
+                                primvarOffset,
+                                edit->GetPrimvarWidth(),
+                                batch.GetVertexOffset(), 
+                                batch.GetTableOffset(), 
+                                batch.GetStart(), 
+                                batch.GetEnd(),
+                                static_cast<unsigned int*>(primvarIndices->GetBuffer()),
+                                static_cast<float*>(editValues->GetBuffer()));
+        }
     }
 }
 
@@ -60,6 +60,7 @@
 #include "../version.h"
 
 #include "../far/dispatcher.h"
+#include "../far/stencilTables.h"
 #include "../osd/cpuComputeContext.h"
 
 namespace OpenSubdiv {
@@ -103,6 +104,8 @@ public:
                 VARYING_BUFFER *varyingBuffer) {
 
         context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(getFinestLevel(batches));
         FarDispatcher::Refine(this,
                               batches,
                               -1,
@@ -126,11 +129,252 @@ public:
         Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers. The plan is compiled once from the kernel batches of
+    /// the mesh, which saves the per-batch dispatch of repeated refinements.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(plan.GetFinestLevel());
+        FarDispatcher::Refine(this, plan, context);
+        context->Unbind();
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, plan, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels and apply to the elements of given vertex
+    /// buffers described by buffer descriptors : the primvars can be
+    /// interleaved with other data, which is left untouched.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer (can be the same
+    ///                       as vertexBuffer)
+    ///
+    /// @param  varyingDesc   the varying-interpolated elements in varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER *varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        if (_streamingStores)
+            context->SetStreamingLevel(getFinestLevel(batches));
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to the elements of a given vertex
+    /// buffer described by a buffer descriptor.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc) {
+        Refine(context, batches, vertexBuffer, vertexDesc,
+               (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+    }
+
+    /// Launch subdivision kernels on several samples of the vertex-interpolated
+    /// primvars (instances or time samples of the mesh) interleaved in a
+    /// vertex buffer : sample 's' starts at element vertexDesc.offset +
+    /// s * vertexDesc.length of each vertex. The tables are read once for all
+    /// the samples, which map onto the SIMD lanes of the kernels.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the elements of the first sample in vertexBuffer
+    ///
+    /// @param  numSamples    the number of samples in each vertex
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                int numSamples) {
+
+        context->BindSamples(vertexBuffer, vertexDesc, numSamples,
+                             (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+        if (_streamingStores)
+            context->SetStreamingLevel(getFinestLevel(batches));
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data (see
+    ///                         FarStencilTablesFactory)
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                VARYING_BUFFER * varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(getFinestLevel(vertexStencils->GetBatches()));
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, vertexStencils, (FarStencilTables const *)0,
+               vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Apply refinement stencils to the elements of given vertex buffers
+    /// described by buffer descriptors.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc      the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer (can be the
+    ///                         same as vertexBuffer)
+    ///
+    /// @param  varyingDesc     the varying-interpolated elements in
+    ///                         varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER * varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        if (_streamingStores)
+            context->SetStreamingLevel(getFinestLevel(vertexStencils->GetBatches()));
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
+    /// Enables non-temporal stores for the vertices of the finest level.
+    /// Streaming stores bypass the caches : they only pay off when the finest
+    /// level does not fit in the caches and is not read back by the CPU before
+    /// being drawn. Disabled by default.
+    void SetStreamingStores(bool enable) {
+        _streamingStores = enable;
+    }
+
+    /// Returns true if the finest level is written with non-temporal stores
+    bool GetStreamingStores() const {
+        return _streamingStores;
+    }
+
 protected:
+    // returns the highest subdivision level refined by 'batches'
+    static int getFinestLevel(FarKernelBatchVector const & batches);
+
+    // returns the highest subdivision level refined by stencil batches
+    static int getFinestLevel(FarStencilBatchVector const & batches);
+
+    // applies the stencil batches and hierarchical edits in sequence
+    void applyStencils(OsdCpuComputeContext *context,
+                       FarStencilTables const * vertexStencils,
+                       FarStencilTables const * varyingStencils) const;
+
     friend class FarDispatcher;
+    friend class OsdThreadPoolComputeController; // runs the kernels on chunks
     void ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
 
     void ApplyBilinearEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
@@ -160,6 +404,8 @@ protected:
 
     void ApplyVertexEdits(FarKernelBatch const &batch, void * clientdata) const;
 
+private:
+    bool _streamingStores;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
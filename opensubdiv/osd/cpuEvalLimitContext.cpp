@@ -123,5 +123,19 @@ OsdCpuEvalLimitContext::~OsdCpuEvalLimitContext() {
     delete _patchMap;
 }
 
+void
+OsdCpuEvalLimitContext::ReportMemoryUsage(FarMemoryReport & report,
+                                          std::string const & prefix) const {
+
+    report.Add(prefix + "patchArrays", _patchArrays);
+    report.Add(prefix + "patches", _patches);
+    report.Add(prefix + "patchBitFields", _patchBitFields);
+    report.Add(prefix + "vertexValences", _vertexValenceBuffer);
+    report.Add(prefix + "quadOffsets", _quadOffsetBuffer);
+
+    if (_patchMap)
+        _patchMap->ReportMemoryUsage(report, prefix + "patchMap.");
+}
+
 } // end namespace OPENSUBDIV_VERSION
 } // end namespace OpenSubdiv
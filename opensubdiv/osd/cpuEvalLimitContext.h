@@ -62,6 +62,7 @@
 #include "../osd/evalLimitContext.h"
 #include "../osd/vertexDescriptor.h"
 #include "../far/patchTables.h"
+#include "../far/memoryReport.h"
 
 #include <map>
 #include <stdio.h>
@@ -176,6 +177,16 @@ public:
         return _patchMap;
     }
 
+    /// Adds the memory allocated by the patch tables and the patch map of the
+    /// context to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the components in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report,
+                           std::string const & prefix=std::string()) const;
+
 protected:
     explicit OsdCpuEvalLimitContext(FarMesh<OsdVertex> const * farmesh);
 
@@ -117,6 +117,18 @@ OsdCpuGLVertexBuffer::GetNumVertices() const {
     return _numVertices;
 }
 
+void
+OsdCpuGLVertexBuffer::ReportMemoryUsage(FarMemoryReport & report,
+                                       std::string const & prefix) const {
+
+    size_t size = _numElements * _numVertices * sizeof(float);
+
+    if (_cpuBuffer)
+        report.Add(prefix + "data", size);
+    if (_vbo)
+        report.Add(prefix + "vbo", size);
+}
+
 float*
 OsdCpuGLVertexBuffer::BindCpuBuffer() {
     _dataDirty = true; // caller might modify data
@@ -59,6 +59,8 @@
 
 #include "../version.h"
 
+#include "../far/memoryReport.h"
+
 #if defined(__APPLE__)
     #include "TargetConditionals.h"
     #if TARGET_OS_IPHONE or TARGET_IPHONE_SIMULATOR
@@ -105,6 +107,15 @@ public:
     /// Returns how many vertices allocated in this vertex buffer.
     int GetNumVertices() const;
 
+    /// Adds the memory allocated by the vertex data to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the components in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report,
+                           std::string const & prefix=std::string()) const;
+
     /// Returns cpu memory. GL buffer will be mapped to cpu address
     /// if necessary.
     float * BindCpuBuffer();
@@ -56,6 +56,7 @@
 //
 
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/vertexDescriptor.h"
 
 #include <math.h>
@@ -63,186 +64,218 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-void OsdCpuComputeFace(
-    OsdVertexDescriptor const &vdesc, float * vertex, float * varying,
-    const int *F_IT, const int *F_ITa, int vertexOffset, int tableOffset,
-    int start, int end) {
-
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = F_ITa[2*i];
-        int n = F_ITa[2*i+1];
+namespace {
 
-        float weight = 1.0f/n;
+// Portable scalar primvar arithmetic. The copies are unrolled by hand :
+// compilers turn plain copy loops into memset / memcpy calls, which are much
+// slower than a few moves for short primvars.
+struct ScalarOps {
 
-        // XXX: should use local vertex struct variable instead of
-        // accumulating directly into global memory.
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+    static OSD_CPU_INLINE void Clear(float *acc, int n) {
+        int i = 0;
+        for (; i+4 <= n; i+=4) {
+            acc[i] = 0.0f; acc[i+1] = 0.0f; acc[i+2] = 0.0f; acc[i+3] = 0.0f;
+        }
+        switch (n-i) {
+            case 3: acc[i+2] = 0.0f;  // fall through
+            case 2: acc[i+1] = 0.0f;  // fall through
+            case 1: acc[i] = 0.0f;
+        }
+    }
 
-        for (int j = 0; j < n; ++j) {
-            int index = F_IT[h+j];
-            vdesc.AddWithWeight(vertex, dstIndex, index, weight);
-            vdesc.AddVaryingWithWeight(varying, dstIndex, index, weight);
+    static OSD_CPU_INLINE void Load(float *acc, const float *src, int n) {
+        int i = 0;
+        for (; i+4 <= n; i+=4) {
+            acc[i] = src[i]; acc[i+1] = src[i+1]; acc[i+2] = src[i+2]; acc[i+3] = src[i+3];
+        }
+        switch (n-i) {
+            case 3: acc[i+2] = src[i+2];  // fall through
+            case 2: acc[i+1] = src[i+1];  // fall through
+            case 1: acc[i] = src[i];
         }
     }
 
-}
+    static OSD_CPU_INLINE void AddWithWeight(float *acc, const float *src, float weight, int n) {
+        for (int i = 0; i < n; ++i)
+            acc[i] += src[i] * weight;
+    }
 
-void OsdCpuComputeEdge(
-    OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *E_IT, const float *E_W, int vertexOffset, int tableOffset,
-    int start, int end) {
+    static OSD_CPU_INLINE void Store(float *dst, const float *acc, int n) {
+        Load(dst, acc, n);
+    }
 
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int eidx0 = E_IT[4*i+0];
-        int eidx1 = E_IT[4*i+1];
-        int eidx2 = E_IT[4*i+2];
-        int eidx3 = E_IT[4*i+3];
+    // no portable non-temporal stores
+    static OSD_CPU_INLINE void StoreStream(float *dst, const float *acc, int n) {
+        Store(dst, acc, n);
+    }
 
-        float vertWeight = E_W[i*2+0];
+    // half precision data, converted one element at a time
+    static OSD_CPU_INLINE void Load(float *acc, const OsdHalf *src, int n) {
+        for (int i = 0; i < n; ++i)
+            acc[i] = OsdHalfConversion<ScalarOps>::ToFloat(src[i]);
+    }
 
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+    static OSD_CPU_INLINE void AddWithWeight(float *acc, const OsdHalf *src, float weight, int n) {
+        for (int i = 0; i < n; ++i)
+            acc[i] += OsdHalfConversion<ScalarOps>::ToFloat(src[i]) * weight;
+    }
 
-        vdesc.AddWithWeight(vertex, dstIndex, eidx0, vertWeight);
-        vdesc.AddWithWeight(vertex, dstIndex, eidx1, vertWeight);
+    static OSD_CPU_INLINE void Store(OsdHalf *dst, const float *acc, int n) {
+        for (int i = 0; i < n; ++i)
+            dst[i] = OsdHalfConversion<ScalarOps>::FromFloat(acc[i]);
+    }
 
-        if (eidx2 != -1) {
-            float faceWeight = E_W[i*2+1];
+    static OSD_CPU_INLINE void StoreStream(OsdHalf *dst, const float *acc, int n) {
+        Store(dst, acc, n);
+    }
 
-            vdesc.AddWithWeight(vertex, dstIndex, eidx2, faceWeight);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx3, faceWeight);
-        }
+    static OSD_CPU_INLINE void Fence() { }
+};
 
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+OsdCpuKernelBundle const g_scalarKernels[] = OSD_CPU_KERNEL_BUNDLES(ScalarOps);
+
+} // end anonymous namespace
+
+static OsdCpuKernelBundle const *
+getKernelBundles(OsdCpuSimd::ISA isa) {
+
+    switch (isa) {
+#ifdef OPENSUBDIV_HAS_SSE4
+        case OsdCpuSimd::ISA_SSE4   : return OsdCpuGetSSE4KernelBundles();
+#endif
+#ifdef OPENSUBDIV_HAS_AVX2
+        case OsdCpuSimd::ISA_AVX2   : return OsdCpuGetAVX2KernelBundles();
+#endif
+#ifdef OPENSUBDIV_HAS_AVX512
+        case OsdCpuSimd::ISA_AVX512 : return OsdCpuGetAVX512KernelBundles();
+#endif
+        default : return g_scalarKernels;
     }
 }
 
-void OsdCpuComputeVertexA(
-    OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, const float *V_W, int vertexOffset, int tableOffset,
-    int start, int end, int pass) {
+static inline bool
+matchWidth(int bundleWidth, int width) {
 
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int n     = V_ITa[5*i+1];
-        int p     = V_ITa[5*i+2];
-        int eidx0 = V_ITa[5*i+3];
-        int eidx1 = V_ITa[5*i+4];
+    return bundleWidth == OsdCpuKernelBundle::ANY_WIDTH or bundleWidth == width;
+}
 
-        float weight = (pass == 1) ? V_W[i] : 1.0f - V_W[i];
+static inline bool
+matchPrecision(OsdPrecision bundlePrecision, OsdPrecision precision, int width) {
 
-        // In the case of fractional weight, the weight must be inverted since
-        // the value is shared with the k_Smooth kernel (statistically the
-        // k_Smooth kernel runs much more often than this one)
-        if (weight > 0.0f && weight < 1.0f && n > 0)
-            weight = 1.0f - weight;
+    return width == 0 or bundlePrecision == precision;
+}
 
-        int dstIndex = i + vertexOffset - tableOffset;
+OsdCpuKernelBundle const *
+OsdCpuGetKernelBundle(OsdCpuSimd::ISA isa,
+                      int numVertexElements, int numVaryingElements,
+                      OsdPrecision vertexPrecision,
+                      OsdPrecision varyingPrecision) {
+
+    // the registry ends with the generic kernels of each precision, which
+    // match any width
+    OsdCpuKernelBundle const * bundle = getKernelBundles(isa);
+    while (not (matchWidth(bundle->numVertexElements, numVertexElements) and
+                matchWidth(bundle->numVaryingElements, numVaryingElements) and
+                matchPrecision(bundle->vertexPrecision, vertexPrecision,
+                               numVertexElements) and
+                matchPrecision(bundle->varyingPrecision, varyingPrecision,
+                               numVaryingElements)))
+        ++bundle;
+    return bundle;
+}
 
-        if (not pass)
-            vdesc.Clear(vertex, varying, dstIndex);
+static inline OsdCpuKernelBundle const *
+getKernels(OsdVertexDescriptor const &vdesc) {
 
-        if (eidx0 == -1 || (pass == 0 && (n == -1))) {
-            vdesc.AddWithWeight(vertex, dstIndex, p, weight);
-        } else {
-            vdesc.AddWithWeight(vertex, dstIndex, p, weight * 0.75f);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx0, weight * 0.125f);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx1, weight * 0.125f);
-        }
+    return OsdCpuGetKernelBundle(OsdCpuSimd::GetISA(),
+                                 vdesc.numVertexElements,
+                                 vdesc.numVaryingElements);
+}
 
-        if (not pass)
-            vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+void OsdCpuComputeFace(
+    OsdVertexDescriptor const &vdesc, float * vertex, float * varying,
+    const int *F_IT, const int *F_ITa, int vertexOffset, int tableOffset,
+    int start, int end) {
+
+    getKernels(vdesc)->computeFace(vdesc, vertex, varying, F_IT, F_ITa,
+                              vertexOffset, tableOffset, start, end);
 }
 
-void OsdCpuComputeVertexB(
+void OsdCpuComputeEdge(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, const int *V_IT, const float *V_W,
-    int vertexOffset, int tableOffset, int start, int end) {
+    const int *E_IT, const float *E_W, int vertexOffset, int tableOffset,
+    int start, int end, bool streaming) {
 
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
+    getKernels(vdesc)->computeEdge(vdesc, vertex, varying, E_IT, E_W,
+                              vertexOffset, tableOffset, start, end, streaming);
+}
 
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n*n);
-        float wv = (n-2.0f) * n * wp;
+void OsdCpuComputeVertexA(
+    OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
+    const int *V_ITa, const float *V_W, int vertexOffset, int tableOffset,
+    int start, int end, int pass, bool streaming) {
 
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+    getKernels(vdesc)->computeVertexA(vdesc, vertex, varying, V_ITa, V_W,
+                                 vertexOffset, tableOffset, start, end, pass,
+                                 streaming);
+}
 
-        vdesc.AddWithWeight(vertex, dstIndex, p, weight * wv);
+void OsdCpuComputeVertexB(
+    OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
+    const int *V_ITa, const int *V_IT, const float *V_W,
+    int vertexOffset, int tableOffset, int start, int end, bool streaming) {
 
-        for (int j = 0; j < n; ++j) {
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j*2], weight * wp);
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j*2+1], weight * wp);
-        }
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+    getKernels(vdesc)->computeVertexB(vdesc, vertex, varying, V_ITa, V_IT, V_W,
+                                 vertexOffset, tableOffset, start, end, streaming);
 }
 
 void OsdCpuComputeLoopVertexB(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
     const int *V_ITa, const int *V_IT, const float *V_W,
-    int vertexOffset, int tableOffset, int start, int end) {
-
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
+    int vertexOffset, int tableOffset, int start, int end, bool streaming) {
 
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n);
-        float beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
-        beta = beta * beta;
-        beta = (0.625f - beta) * wp;
-
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, p, weight * (1.0f - (beta * n)));
-
-        for (int j = 0; j < n; ++j)
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j], weight * beta);
-
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+    getKernels(vdesc)->computeLoopVertexB(vdesc, vertex, varying, V_ITa, V_IT, V_W,
+                                     vertexOffset, tableOffset, start, end, streaming);
 }
 
 void OsdCpuComputeBilinearEdge(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *E_IT, int vertexOffset, int tableOffset, int start, int end) {
+    const int *E_IT, int vertexOffset, int tableOffset, int start, int end,
+    bool streaming) {
 
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int eidx0 = E_IT[2*i+0];
-        int eidx1 = E_IT[2*i+1];
-
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, eidx0, 0.5f);
-        vdesc.AddWithWeight(vertex, dstIndex, eidx1, 0.5f);
-
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
-    }
+    getKernels(vdesc)->computeBilinearEdge(vdesc, vertex, varying, E_IT,
+                                      vertexOffset, tableOffset, start, end, streaming);
 }
 
 void OsdCpuComputeBilinearVertex(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, int vertexOffset, int tableOffset, int start, int end) {
+    const int *V_ITa, int vertexOffset, int tableOffset, int start, int end,
+    bool streaming) {
+
+    getKernels(vdesc)->computeBilinearVertex(vdesc, vertex, varying, V_ITa,
+                                        vertexOffset, tableOffset, start, end, streaming);
+}
+
+void OsdCpuComputeVertexStencils(
+    OsdVertexDescriptor const &vdesc, float *vertex,
+    const int *sizes, const int *offsets, const int *indices,
+    const float *weights, int vertexOffset, int tableOffset,
+    int start, int end, bool streaming) {
 
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int p = V_ITa[i];
+    getKernels(vdesc)->computeVertexStencils(vdesc, vertex, sizes, offsets,
+                                        indices, weights, vertexOffset,
+                                        tableOffset, start, end, streaming);
+}
 
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+void OsdCpuComputeVaryingStencils(
+    OsdVertexDescriptor const &vdesc, float *varying,
+    const int *sizes, const int *offsets, const int *indices,
+    const float *weights, int vertexOffset, int tableOffset,
+    int start, int end, bool streaming) {
 
-        vdesc.AddWithWeight(vertex, dstIndex, p, 1.0f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
-    }
+    getKernels(vdesc)->computeVaryingStencils(vdesc, varying, sizes, offsets,
+                                         indices, weights, vertexOffset,
+                                         tableOffset, start, end, streaming);
 }
 
 void OsdCpuEditVertexAdd(
@@ -275,5 +308,35 @@ void OsdCpuEditVertexSet(
     }
 }
 
+void OsdCpuEditHalfVertexAdd(
+    OsdVertexDescriptor const &vdesc, OsdHalf *vertex,
+    int primVarOffset, int primVarWidth, int vertexOffset, int tableOffset,
+    int start, int end,
+    const unsigned int *editIndices, const float *editValues) {
+
+    for (int i = start+tableOffset; i < end+tableOffset; i++) {
+        OsdHalf *dst = vertex + (editIndices[i] + vertexOffset) *
+                       vdesc.vertexStride + primVarOffset;
+        const float *src = &editValues[i*primVarWidth];
+        for (int j = 0; j < primVarWidth; ++j)
+            dst[j] = OsdFloatToHalf(OsdHalfToFloat(dst[j]) + src[j]);
+    }
+}
+
+void OsdCpuEditHalfVertexSet(
+    OsdVertexDescriptor const &vdesc, OsdHalf *vertex,
+    int primVarOffset, int primVarWidth, int vertexOffset, int tableOffset,
+    int start, int end,
+    const unsigned int *editIndices, const float *editValues) {
+
+    for (int i = start+tableOffset; i < end+tableOffset; i++) {
+        OsdHalf *dst = vertex + (editIndices[i] + vertexOffset) *
+                       vdesc.vertexStride + primVarOffset;
+        const float *src = &editValues[i*primVarWidth];
+        for (int j = 0; j < primVarWidth; ++j)
+            dst[j] = OsdFloatToHalf(src[j]);
+    }
+}
+
 }  // end namespace OPENSUBDIV_VERSION
 }  // end namespace OpenSubdiv
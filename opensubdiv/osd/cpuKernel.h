@@ -59,6 +59,7 @@
 
 #include "../version.h"
 #include "../osd/vertexDescriptor.h"
+#include "../osd/half.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -75,38 +76,60 @@ void OsdCpuComputeEdge(OsdVertexDescriptor const &vdesc,
                        float *vertex, float * varying,
                        const int *E_IT, const float *E_ITa,
                        int vertexOffset, int tableOffset,
-                       int start, int end);
+                       int start, int end,
+                       bool streaming = false);
 
 void OsdCpuComputeVertexA(OsdVertexDescriptor const &vdesc,
                           float *vertex, float * varying,
                           const int *V_ITa, const float *V_IT,
                           int vertexOffset, int tableOffset,
-                          int start, int end, int pass);
+                          int start, int end, int pass,
+                          bool streaming = false);
 
 void OsdCpuComputeVertexB(OsdVertexDescriptor const &vdesc,
                           float *vertex, float * varying,
                           const int *V_ITa, const int *V_IT, const float *V_W,
                           int vertexOffset, int tableOffset,
-                          int start, int end);
+                          int start, int end,
+                          bool streaming = false);
 
 void OsdCpuComputeLoopVertexB(OsdVertexDescriptor const &vdesc,
                               float *vertex, float * varying,
                               const int *V_ITa, const int *V_IT,
                               const float *V_W,
                               int vertexOffset, int tableOffset,
-                              int start, int end);
+                              int start, int end,
+                              bool streaming = false);
 
 void OsdCpuComputeBilinearEdge(OsdVertexDescriptor const &vdesc,
                                float *vertex, float * varying,
                                const int *E_IT,
                                int vertexOffset, int tableOffset,
-                               int start, int end);
+                               int start, int end,
+                               bool streaming = false);
 
 void OsdCpuComputeBilinearVertex(OsdVertexDescriptor const &vdesc,
                                  float *vertex, float * varying,
                                  const int *V_ITa,
                                  int vertexOffset, int tableOffset,
-                                 int start, int end);
+                                 int start, int end,
+                                 bool streaming = false);
+
+void OsdCpuComputeVertexStencils(OsdVertexDescriptor const &vdesc,
+                                 float *vertex,
+                                 const int *sizes, const int *offsets,
+                                 const int *indices, const float *weights,
+                                 int vertexOffset, int tableOffset,
+                                 int start, int end,
+                                 bool streaming = false);
+
+void OsdCpuComputeVaryingStencils(OsdVertexDescriptor const &vdesc,
+                                  float *varying,
+                                  const int *sizes, const int *offsets,
+                                  const int *indices, const float *weights,
+                                  int vertexOffset, int tableOffset,
+                                  int start, int end,
+                                  bool streaming = false);
 
 void OsdCpuEditVertexAdd(OsdVertexDescriptor const &vdesc, float *vertex,
                          int primVarOffset, int primVarWidth,
@@ -122,6 +145,21 @@ void OsdCpuEditVertexSet(OsdVertexDescriptor const &vdesc, float *vertex,
                          const unsigned int *editIndices,
                          const float *editValues);
 
+// vertex edits of half precision vertex data
+void OsdCpuEditHalfVertexAdd(OsdVertexDescriptor const &vdesc, OsdHalf *vertex,
+                             int primVarOffset, int primVarWidth,
+                             int vertexOffset, int tableOffset,
+                             int start, int end,
+                             const unsigned int *editIndices,
+                             const float *editValues);
+
+void OsdCpuEditHalfVertexSet(OsdVertexDescriptor const &vdesc, OsdHalf *vertex,
+                             int primVarOffset, int primVarWidth,
+                             int vertexOffset, int tableOffset,
+                             int start, int end,
+                             const unsigned int *editIndices,
+                             const float *editValues);
+
 }  // end namespace OPENSUBDIV_VERSION
 using namespace OPENSUBDIV_VERSION;
 
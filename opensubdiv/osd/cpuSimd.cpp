@@ -0,0 +1,223 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/cpuSimd.h"
+
+#if defined(_MSC_VER) and (defined(_M_X64) or defined(_M_IX86))
+    #include <intrin.h>
+    #define OSD_CPU_X86
+#elif (defined(__GNUC__) or defined(__clang__)) and \
+      (defined(__x86_64__) or defined(__i386__))
+    #include <cpuid.h>
+    #define OSD_CPU_X86
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+#ifdef OSD_CPU_X86
+
+static void
+cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i=0; i<4; ++i)
+        regs[i] = (unsigned int)r[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Returns the state components enabled by the OS in XCR0 (requires OSXSAVE)
+static unsigned int
+xgetbv0() {
+
+#if defined(_MSC_VER)
+    return (unsigned int)_xgetbv(0);
+#else
+    unsigned int eax, edx;
+    // xgetbv opcode : older assemblers do not know the mnemonic
+    __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+
+static OsdCpuSimd::ISA
+detectISA() {
+
+    unsigned int regs[4];
+
+    cpuid(0, 0, regs);
+    int maxLeaf = (int)regs[0];
+    if (maxLeaf < 1)
+        return OsdCpuSimd::ISA_NONE;
+
+    cpuid(1, 0, regs);
+    bool sse41   = (regs[2] & (1u << 19)) != 0,
+         osxsave = (regs[2] & (1u << 27)) != 0,
+         avx     = (regs[2] & (1u << 28)) != 0,
+         f16c    = (regs[2] & (1u << 29)) != 0;
+
+    if (not sse41)
+        return OsdCpuSimd::ISA_NONE;
+
+    // the OS must save the ymm (and zmm / opmask) registers on context switch
+    unsigned int xcr0 = (osxsave and avx) ? xgetbv0() : 0;
+    bool ymmState = (xcr0 & 0x06) == 0x06,
+         zmmState = (xcr0 & 0xe6) == 0xe6;
+
+    bool avx2 = false, avx512f = false;
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        avx2    = (regs[1] & (1u << 5)) != 0;
+        avx512f = (regs[1] & (1u << 16)) != 0;
+    }
+
+    // the AVX variants also convert half precision data with F16C
+    if (avx512f and f16c and zmmState)
+        return OsdCpuSimd::ISA_AVX512;
+    if (avx2 and f16c and ymmState)
+        return OsdCpuSimd::ISA_AVX2;
+    return OsdCpuSimd::ISA_SSE4;
+}
+
+#else
+
+static OsdCpuSimd::ISA
+detectISA() {
+    return OsdCpuSimd::ISA_NONE;
+}
+
+#endif
+
+// Instruction sets compiled in the library
+static bool
+isCompiled(OsdCpuSimd::ISA isa) {
+
+    switch (isa) {
+        case OsdCpuSimd::ISA_NONE   : return true;
+#ifdef OPENSUBDIV_HAS_SSE4
+        case OsdCpuSimd::ISA_SSE4   : return true;
+#endif
+#ifdef OPENSUBDIV_HAS_AVX2
+        case OsdCpuSimd::ISA_AVX2   : return true;
+#endif
+#ifdef OPENSUBDIV_HAS_AVX512
+        case OsdCpuSimd::ISA_AVX512 : return true;
+#endif
+        default : return false;
+    }
+}
+
+static OsdCpuSimd::ISA
+getHostISA() {
+
+    // CPUID is only queried once ; concurrent first calls are benign since
+    // they all compute the same value.
+    static int hostISA = -1;
+    if (hostISA < 0)
+        hostISA = detectISA();
+    return (OsdCpuSimd::ISA)hostISA;
+}
+
+static int g_currentISA = -1;
+
+OsdCpuSimd::ISA
+OsdCpuSimd::GetSupportedISA() {
+
+    for (int isa = getHostISA(); isa > ISA_NONE; --isa) {
+        if (isCompiled((ISA)isa))
+            return (ISA)isa;
+    }
+    return ISA_NONE;
+}
+
+bool
+OsdCpuSimd::IsSupported(ISA isa) {
+
+    return isa >= ISA_NONE and isa < ISA_COUNT and
+           isa <= getHostISA() and isCompiled(isa);
+}
+
+OsdCpuSimd::ISA
+OsdCpuSimd::GetISA() {
+
+    if (g_currentISA < 0)
+        g_currentISA = GetSupportedISA();
+    return (ISA)g_currentISA;
+}
+
+bool
+OsdCpuSimd::SetISA(ISA isa) {
+
+    if (not IsSupported(isa))
+        return false;
+    g_currentISA = isa;
+    return true;
+}
+
+char const *
+OsdCpuSimd::GetISAName(ISA isa) {
+
+    static char const * names[ISA_COUNT] = { "scalar", "SSE4", "AVX2", "AVX512" };
+    return (isa >= ISA_NONE and isa < ISA_COUNT) ? names[isa] : "unknown";
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
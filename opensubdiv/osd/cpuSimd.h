@@ -0,0 +1,115 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_CPU_SIMD_H
+#define OSD_CPU_SIMD_H
+
+#include "../version.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Runtime selection of the instruction set used by the CPU kernels.
+///
+/// The CPU subdivision kernels are compiled once for each of the x86 SIMD
+/// instruction sets listed below (when the compiler supports them). The best
+/// variant supported by the host processor is selected on first use, from
+/// the CPUID feature bits.
+///
+/// All variants apply exactly the same sequence of single precision multiply
+/// and add operations as the portable scalar kernels, so refined results are
+/// bitwise identical regardless of the instruction set selected.
+///
+class OsdCpuSimd {
+public:
+    enum ISA {
+        ISA_NONE = 0,  ///< portable scalar kernels
+        ISA_SSE4,      ///< SSE 4.1 (4-wide)
+        ISA_AVX2,      ///< AVX2 and F16C (8-wide, masked tails)
+        ISA_AVX512,    ///< AVX-512F and F16C (16-wide, masked tails)
+        ISA_COUNT
+    };
+
+    /// Returns the most capable instruction set that was both compiled in
+    /// the library and is supported by the host processor.
+    static ISA GetSupportedISA();
+
+    /// Returns true if kernels for 'isa' can run on the host processor.
+    static bool IsSupported(ISA isa);
+
+    /// Returns the instruction set currently used by the CPU kernels.
+    static ISA GetISA();
+
+    /// Forces the CPU kernels to use a specific instruction set. This is
+    /// mostly useful for testing the kernel variants against each other.
+    ///
+    /// @param isa  the instruction set to use
+    ///
+    /// @return     false if 'isa' is not supported (the selection is left
+    ///             unchanged)
+    ///
+    static bool SetISA(ISA isa);
+
+    /// Returns a printable name for 'isa'
+    static char const * GetISAName(ISA isa);
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_CPU_SIMD_H
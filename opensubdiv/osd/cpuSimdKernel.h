@@ -0,0 +1,701 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_CPU_SIMD_KERNEL_H
+#define OSD_CPU_SIMD_KERNEL_H
+
+#include "../version.h"
+#include "../osd/cpuSimd.h"
+#include "../osd/half.h"
+#include "../osd/vertexDescriptor.h"
+
+#include <math.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// Bundle of CPU subdivision kernels compiled for a given instruction set and
+// specialized for a given number of vertex and varying primvar elements. The
+// signatures match the dispatching functions declared in cpuKernel.h
+//
+// 'streaming' requests non-temporal stores for the refined vertices : it is
+// meant for the finest level of large meshes, whose vertices are not read
+// back by the other kernels of the level (the face-vertex kernel, which
+// produces vertices used by the edge and vertex kernels, does not stream).
+struct OsdCpuKernelBundle {
+
+    enum { ANY_WIDTH = -1 };
+
+    // widths handled by the kernels (ANY_WIDTH for the generic kernels, which
+    // read them from the vertex descriptor)
+    int numVertexElements,
+        numVaryingElements;
+
+    // storage precision of the vertex and varying data
+    OsdPrecision vertexPrecision,
+                 varyingPrecision;
+
+    void (*computeFace)(OsdVertexDescriptor const &vdesc,
+                        void *vertex, void *varying,
+                        const int *F_IT, const int *F_ITa,
+                        int vertexOffset, int tableOffset,
+                        int start, int end);
+
+    void (*computeEdge)(OsdVertexDescriptor const &vdesc,
+                        void *vertex, void *varying,
+                        const int *E_IT, const float *E_W,
+                        int vertexOffset, int tableOffset,
+                        int start, int end, bool streaming);
+
+    void (*computeVertexA)(OsdVertexDescriptor const &vdesc,
+                           void *vertex, void *varying,
+                           const int *V_ITa, const float *V_W,
+                           int vertexOffset, int tableOffset,
+                           int start, int end, int pass, bool streaming);
+
+    void (*computeVertexB)(OsdVertexDescriptor const &vdesc,
+                           void *vertex, void *varying,
+                           const int *V_ITa, const int *V_IT, const float *V_W,
+                           int vertexOffset, int tableOffset,
+                           int start, int end, bool streaming);
+
+    void (*computeLoopVertexB)(OsdVertexDescriptor const &vdesc,
+                               void *vertex, void *varying,
+                               const int *V_ITa, const int *V_IT,
+                               const float *V_W,
+                               int vertexOffset, int tableOffset,
+                               int start, int end, bool streaming);
+
+    void (*computeBilinearEdge)(OsdVertexDescriptor const &vdesc,
+                                void *vertex, void *varying,
+                                const int *E_IT,
+                                int vertexOffset, int tableOffset,
+                                int start, int end, bool streaming);
+
+    void (*computeBilinearVertex)(OsdVertexDescriptor const &vdesc,
+                                  void *vertex, void *varying,
+                                  const int *V_ITa,
+                                  int vertexOffset, int tableOffset,
+                                  int start, int end, bool streaming);
+
+    // stencil kernels (see FarStencilTables) : the vertex and varying stencils
+    // are applied to their buffer separately, with the matching width
+    void (*computeVertexStencils)(OsdVertexDescriptor const &vdesc,
+                                  void *vertex,
+                                  const int *sizes, const int *offsets,
+                                  const int *indices, const float *weights,
+                                  int vertexOffset, int tableOffset,
+                                  int start, int end, bool streaming);
+
+    void (*computeVaryingStencils)(OsdVertexDescriptor const &vdesc,
+                                   void *varying,
+                                   const int *sizes, const int *offsets,
+                                   const int *indices, const float *weights,
+                                   int vertexOffset, int tableOffset,
+                                   int start, int end, bool streaming);
+};
+
+// Returns the kernel bundle matching the primvar widths and storage precisions
+// for 'isa' (the scalar kernels are used if 'isa' was not compiled in the
+// library). The precision of empty primvars is not relevant.
+OsdCpuKernelBundle const * OsdCpuGetKernelBundle(
+    OsdCpuSimd::ISA isa, int numVertexElements, int numVaryingElements,
+    OsdPrecision vertexPrecision=OSD_PRECISION_FLOAT,
+    OsdPrecision varyingPrecision=OSD_PRECISION_FLOAT);
+
+// Kernel bundle registries for each instruction set : each registry ends with
+// the generic bundles (ANY_WIDTH) of every supported storage precision.
+#ifdef OPENSUBDIV_HAS_SSE4
+OsdCpuKernelBundle const * OsdCpuGetSSE4KernelBundles();
+#endif
+
+#ifdef OPENSUBDIV_HAS_AVX2
+OsdCpuKernelBundle const * OsdCpuGetAVX2KernelBundles();
+#endif
+
+#ifdef OPENSUBDIV_HAS_AVX512
+OsdCpuKernelBundle const * OsdCpuGetAVX512KernelBundles();
+#endif
+
+// Kernel bodies, shared by all the instruction sets and primvar widths. VW
+// and YW are the number of vertex and varying elements : when they are known
+// at compile time, the primvar loops are fully unrolled. Vertices are
+// addressed with the strides of the vertex descriptor, so that the primvars
+// can be interleaved with other data.
+//
+// Each refined vertex is gathered in a local accumulator and written to the
+// buffer once. The generic kernels accumulate the primvar data in chunks of
+// OSD_CPU_ACCUMULATOR_SIZE elements, so that the accumulator always fits in
+// registers.
+//
+// OPS implements the primvar arithmetic on accumulators of 'n' elements :
+//
+//     static void Clear(float *acc, int n);
+//     static void Load(float *acc, const float *src, int n);
+//     static void AddWithWeight(float *acc, const float *src, float weight, int n);
+//     static void Store(float *dst, const float *acc, int n);
+//     static void StoreStream(float *dst, const float *acc, int n);
+//     static void Fence();
+//
+// along with the Load, AddWithWeight, Store and StoreStream overloads for
+// half precision data (OsdHalf), which is converted to and from single
+// precision : the accumulation is always done in single precision.
+//
+// Each translation unit instantiates these templates with its own OPS type
+// declared in an anonymous namespace, so that code compiled with a given
+// instruction set never leaks into the other variants. For the same reason,
+// the bodies must not call any non-template inline function.
+//
+#define OSD_CPU_ACCUMULATOR_SIZE 16
+
+// The OPS functions must be inlined in the kernel bodies for the accumulators
+// to be kept in registers.
+#if defined(_MSC_VER)
+    #define OSD_CPU_INLINE __forceinline
+#elif defined(__GNUC__)
+    #define OSD_CPU_INLINE inline __attribute__((always_inline))
+#else
+    #define OSD_CPU_INLINE inline
+#endif
+
+// Accumulator size and number of elements in a chunk (compile time constants
+// for the specialized kernels)
+#define OSD_CPU_CHUNK_SIZE(W) \
+    ((W) > 0 ? (W) : OSD_CPU_ACCUMULATOR_SIZE)
+
+#define OSD_CPU_CHUNK_ELEMENTS(W, n, c) \
+    ((n) - (c) < OSD_CPU_CHUNK_SIZE(W) ? (n) - (c) : OSD_CPU_CHUNK_SIZE(W))
+
+template <class OPS, class T> inline void
+osdCpuStore(T *dst, const float *acc, int n, bool streaming) {
+
+    if (streaming)
+        OPS::StoreStream(dst, acc, n);
+    else
+        OPS::Store(dst, acc, n);
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeFaceKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *F_IT, const int *F_ITa, int vertexOffset, int tableOffset,
+    int start, int end) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int h = F_ITa[2*i];
+        int n = F_ITa[2*i+1];
+
+        float weight = 1.0f/n;
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            for (int j = 0; j < n; ++j)
+                OPS::AddWithWeight(acc, vertex + F_IT[h+j]*vs + c, weight, m);
+            OPS::Store(vertex + dstIndex*vs + c, acc, m);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            for (int j = 0; j < n; ++j)
+                OPS::AddWithWeight(acc, varying + F_IT[h+j]*ys + c, weight, m);
+            OPS::Store(varying + dstIndex*ys + c, acc, m);
+        }
+    }
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeEdgeKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *E_IT, const float *E_W, int vertexOffset, int tableOffset,
+    int start, int end, bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int eidx0 = E_IT[4*i+0];
+        int eidx1 = E_IT[4*i+1];
+        int eidx2 = E_IT[4*i+2];
+        int eidx3 = E_IT[4*i+3];
+
+        float vertWeight = E_W[i*2+0];
+        float faceWeight = eidx2 != -1 ? E_W[i*2+1] : 0.0f;
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, vertex + eidx0*vs + c, vertWeight, m);
+            OPS::AddWithWeight(acc, vertex + eidx1*vs + c, vertWeight, m);
+
+            if (eidx2 != -1) {
+                OPS::AddWithWeight(acc, vertex + eidx2*vs + c, faceWeight, m);
+                OPS::AddWithWeight(acc, vertex + eidx3*vs + c, faceWeight, m);
+            }
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, varying + eidx0*ys + c, 0.5f, m);
+            OPS::AddWithWeight(acc, varying + eidx1*ys + c, 0.5f, m);
+            osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeVertexAKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *V_ITa, const float *V_W, int vertexOffset, int tableOffset,
+    int start, int end, int pass, bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int n     = V_ITa[5*i+1];
+        int p     = V_ITa[5*i+2];
+        int eidx0 = V_ITa[5*i+3];
+        int eidx1 = V_ITa[5*i+4];
+
+        float weight = (pass == 1) ? V_W[i] : 1.0f - V_W[i];
+
+        // In the case of fractional weight, the weight must be inverted since
+        // the value is shared with the k_Smooth kernel (statistically the
+        // k_Smooth kernel runs much more often than this one)
+        if (weight > 0.0f && weight < 1.0f && n > 0)
+            weight = 1.0f - weight;
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            // the second pass blends with the result of the previous kernel
+            if (pass)
+                OPS::Load(acc, vertex + dstIndex*vs + c, m);
+            else
+                OPS::Clear(acc, m);
+
+            if (eidx0 == -1 || (pass == 0 && (n == -1))) {
+                OPS::AddWithWeight(acc, vertex + p*vs + c, weight, m);
+            } else {
+                OPS::AddWithWeight(acc, vertex + p*vs + c, weight * 0.75f, m);
+                OPS::AddWithWeight(acc, vertex + eidx0*vs + c, weight * 0.125f, m);
+                OPS::AddWithWeight(acc, vertex + eidx1*vs + c, weight * 0.125f, m);
+            }
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        if (not pass) {
+            for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+                int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+                float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+                OPS::Clear(acc, m);
+                OPS::AddWithWeight(acc, varying + p*ys + c, 1.0f, m);
+                osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+            }
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeVertexBKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *V_ITa, const int *V_IT, const float *V_W,
+    int vertexOffset, int tableOffset, int start, int end, bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int h = V_ITa[5*i];
+        int n = V_ITa[5*i+1];
+        int p = V_ITa[5*i+2];
+
+        float weight = V_W[i];
+        float wp = 1.0f/static_cast<float>(n*n);
+        float wv = (n-2.0f) * n * wp;
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, vertex + p*vs + c, weight * wv, m);
+
+            for (int j = 0; j < n; ++j) {
+                OPS::AddWithWeight(acc, vertex + V_IT[h+j*2]*vs + c, weight * wp, m);
+                OPS::AddWithWeight(acc, vertex + V_IT[h+j*2+1]*vs + c, weight * wp, m);
+            }
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, varying + p*ys + c, 1.0f, m);
+            osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeLoopVertexBKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *V_ITa, const int *V_IT, const float *V_W,
+    int vertexOffset, int tableOffset, int start, int end, bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int h = V_ITa[5*i];
+        int n = V_ITa[5*i+1];
+        int p = V_ITa[5*i+2];
+
+        float weight = V_W[i];
+        float wp = 1.0f/static_cast<float>(n);
+        float beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
+        beta = beta * beta;
+        beta = (0.625f - beta) * wp;
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, vertex + p*vs + c, weight * (1.0f - (beta * n)), m);
+
+            for (int j = 0; j < n; ++j)
+                OPS::AddWithWeight(acc, vertex + V_IT[h+j]*vs + c, weight * beta, m);
+
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, varying + p*ys + c, 1.0f, m);
+            osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeBilinearEdgeKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *E_IT, int vertexOffset, int tableOffset, int start, int end,
+    bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int eidx0 = E_IT[2*i+0];
+        int eidx1 = E_IT[2*i+1];
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, vertex + eidx0*vs + c, 0.5f, m);
+            OPS::AddWithWeight(acc, vertex + eidx1*vs + c, 0.5f, m);
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, varying + eidx0*ys + c, 0.5f, m);
+            OPS::AddWithWeight(acc, varying + eidx1*ys + c, 0.5f, m);
+            osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+template <class OPS, int VW, int YW, class VT, class YT> void
+OsdCpuComputeBilinearVertexKernel(
+    OsdVertexDescriptor const &vdesc, void *vertexData, void *varyingData,
+    const int *V_ITa, int vertexOffset, int tableOffset, int start, int end,
+    bool streaming) {
+
+    int nv = VW < 0 ? vdesc.numVertexElements : VW,
+        ny = YW < 0 ? vdesc.numVaryingElements : YW,
+        vs = vdesc.vertexStride,
+        ys = vdesc.varyingStride;
+
+    VT *vertex = static_cast<VT *>(vertexData);
+    YT *varying = static_cast<YT *>(varyingData);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        int p = V_ITa[i];
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nv; c += OSD_CPU_CHUNK_SIZE(VW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(VW, nv, c);
+            float acc[OSD_CPU_CHUNK_SIZE(VW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, vertex + p*vs + c, 1.0f, m);
+            osdCpuStore<OPS>(vertex + dstIndex*vs + c, acc, m, streaming);
+        }
+
+        for (int c = 0; c < ny; c += OSD_CPU_CHUNK_SIZE(YW)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(YW, ny, c);
+            float acc[OSD_CPU_CHUNK_SIZE(YW)];
+
+            OPS::Clear(acc, m);
+            OPS::AddWithWeight(acc, varying + p*ys + c, 1.0f, m);
+            osdCpuStore<OPS>(varying + dstIndex*ys + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+// Applies stencils [start, end) of a stencil batch to a buffer of W elements
+// per vertex (VARYING selects the varying width of the descriptor when W is
+// not known).
+template <class OPS, int W, bool VARYING, class T> void
+OsdCpuComputeStencilsKernel(
+    OsdVertexDescriptor const &vdesc, void *data,
+    const int *sizes, const int *offsets, const int *indices,
+    const float *weights, int vertexOffset, int tableOffset,
+    int start, int end, bool streaming) {
+
+    int nw = W >= 0 ? W :
+        (VARYING ? vdesc.numVaryingElements : vdesc.numVertexElements),
+        sw = VARYING ? vdesc.varyingStride : vdesc.vertexStride;
+
+    T *buffer = static_cast<T *>(data);
+
+    for (int i = start + tableOffset; i < end + tableOffset; i++) {
+        const int *index = indices + offsets[i];
+        const float *weight = weights + offsets[i];
+        int n = sizes[i];
+
+        int dstIndex = i + vertexOffset - tableOffset;
+
+        for (int c = 0; c < nw; c += OSD_CPU_CHUNK_SIZE(W)) {
+            int m = OSD_CPU_CHUNK_ELEMENTS(W, nw, c);
+            float acc[OSD_CPU_CHUNK_SIZE(W)];
+
+            OPS::Clear(acc, m);
+            for (int j = 0; j < n; ++j)
+                OPS::AddWithWeight(acc, buffer + index[j]*sw + c, weight[j], m);
+            osdCpuStore<OPS>(buffer + dstIndex*sw + c, acc, m, streaming);
+        }
+    }
+
+    if (streaming)
+        OPS::Fence();
+}
+
+// Storage precision of the primvar data types
+template <class T> struct OsdCpuStorage;
+
+template <> struct OsdCpuStorage<float> {
+    enum { PRECISION = OSD_PRECISION_FLOAT };
+};
+
+template <> struct OsdCpuStorage<OsdHalf> {
+    enum { PRECISION = OSD_PRECISION_HALF };
+};
+
+// Declares a kernel bundle instantiated with the arithmetic of OPS, for
+// vertex and varying data stored as VT and YT
+#define OSD_CPU_KERNEL_BUNDLE(OPS, VW, YW, VT, YT)                  \
+    {                                                               \
+        VW, YW,                                                     \
+        (OsdPrecision)OsdCpuStorage<VT>::PRECISION,                 \
+        (OsdPrecision)OsdCpuStorage<YT>::PRECISION,                 \
+        OsdCpuComputeFaceKernel<OPS, VW, YW, VT, YT>,               \
+        OsdCpuComputeEdgeKernel<OPS, VW, YW, VT, YT>,               \
+        OsdCpuComputeVertexAKernel<OPS, VW, YW, VT, YT>,            \
+        OsdCpuComputeVertexBKernel<OPS, VW, YW, VT, YT>,            \
+        OsdCpuComputeLoopVertexBKernel<OPS, VW, YW, VT, YT>,        \
+        OsdCpuComputeBilinearEdgeKernel<OPS, VW, YW, VT, YT>,       \
+        OsdCpuComputeBilinearVertexKernel<OPS, VW, YW, VT, YT>,     \
+        OsdCpuComputeStencilsKernel<OPS, VW, false, VT>,            \
+        OsdCpuComputeStencilsKernel<OPS, YW, true, YT>              \
+    }
+
+// Declares the registry of kernel bundles for OPS : specializations for the
+// common primvar layouts (P, P+w, P+N, 8 floats, 4 and 8 interleaved samples
+// of P), with or without varying data, followed by the generic kernels. The
+// half precision bundles come last : positions are usually kept in single
+// precision, with the varying data in half precision.
+#define OSD_CPU_KERNEL_BUNDLES(OPS)                                         \
+    {                                                                       \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 3, 0, float, float),                     \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 4, 0, float, float),                     \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 6, 0, float, float),                     \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 8, 0, float, float),                     \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 12, 0, float, float),                    \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 24, 0, float, float),                    \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 3, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, float),                                \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 4, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, float),                                \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 6, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, float),                                \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 8, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, float),                                \
+        OSD_CPU_KERNEL_BUNDLE(OPS, OsdCpuKernelBundle::ANY_WIDTH,           \
+                                   OsdCpuKernelBundle::ANY_WIDTH,           \
+                              float, float),                                \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 3, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, OsdHalf),                              \
+        OSD_CPU_KERNEL_BUNDLE(OPS, 4, OsdCpuKernelBundle::ANY_WIDTH,        \
+                              float, OsdHalf),                              \
+        OSD_CPU_KERNEL_BUNDLE(OPS, OsdCpuKernelBundle::ANY_WIDTH,           \
+                                   OsdCpuKernelBundle::ANY_WIDTH,           \
+                              float, OsdHalf),                              \
+        OSD_CPU_KERNEL_BUNDLE(OPS, OsdCpuKernelBundle::ANY_WIDTH,           \
+                                   OsdCpuKernelBundle::ANY_WIDTH,           \
+                              OsdHalf, float),                              \
+        OSD_CPU_KERNEL_BUNDLE(OPS, OsdCpuKernelBundle::ANY_WIDTH,           \
+                                   OsdCpuKernelBundle::ANY_WIDTH,           \
+                              OsdHalf, OsdHalf)                             \
+    }
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_CPU_SIMD_KERNEL_H
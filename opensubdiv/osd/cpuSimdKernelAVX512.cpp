@@ -0,0 +1,233 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+// This file is compiled with AVX-512F code generation enabled (see
+// CMakeLists.txt) : it must only be executed on processors where
+// OsdCpuSimd::IsSupported(OsdCpuSimd::ISA_AVX512) is true.
+
+#include "../osd/cpuSimdKernel.h"
+
+#include <immintrin.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace {
+
+// Trailing elements are processed with narrower vectors and then one at a
+// time, which lets the compiler keep small accumulators in registers.
+// The scalar copies are unrolled so that they are not turned into memset /
+// memcpy calls.
+struct AVX512Ops {
+
+    static OSD_CPU_INLINE void Clear(float *acc, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16)
+            _mm512_storeu_ps(acc+i, _mm512_setzero_ps());
+        if (i+8 <= n) {
+            _mm256_storeu_ps(acc+i, _mm256_setzero_ps());
+            i+=8;
+        }
+        if (i+4 <= n) {
+            _mm_storeu_ps(acc+i, _mm_setzero_ps());
+            i+=4;
+        }
+        switch (n-i) {
+            case 3: acc[i+2] = 0.0f;  // fall through
+            case 2: acc[i+1] = 0.0f;  // fall through
+            case 1: acc[i] = 0.0f;
+        }
+    }
+
+    static OSD_CPU_INLINE void Load(float *acc, const float *src, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16)
+            _mm512_storeu_ps(acc+i, _mm512_loadu_ps(src+i));
+        if (i+8 <= n) {
+            _mm256_storeu_ps(acc+i, _mm256_loadu_ps(src+i));
+            i+=8;
+        }
+        if (i+4 <= n) {
+            _mm_storeu_ps(acc+i, _mm_loadu_ps(src+i));
+            i+=4;
+        }
+        switch (n-i) {
+            case 3: acc[i+2] = src[i+2];  // fall through
+            case 2: acc[i+1] = src[i+1];  // fall through
+            case 1: acc[i] = src[i];
+        }
+    }
+
+    static OSD_CPU_INLINE void AddWithWeight(float *acc, const float *src, float weight, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16) {
+            __m512 d = _mm512_add_ps(_mm512_loadu_ps(acc+i),
+                                     _mm512_mul_ps(_mm512_loadu_ps(src+i), _mm512_set1_ps(weight)));
+            _mm512_storeu_ps(acc+i, d);
+        }
+        if (i+8 <= n) {
+            __m256 d = _mm256_add_ps(_mm256_loadu_ps(acc+i),
+                                     _mm256_mul_ps(_mm256_loadu_ps(src+i), _mm256_set1_ps(weight)));
+            _mm256_storeu_ps(acc+i, d);
+            i+=8;
+        }
+        if (i+4 <= n) {
+            __m128 d = _mm_add_ps(_mm_loadu_ps(acc+i),
+                                  _mm_mul_ps(_mm_loadu_ps(src+i), _mm_set1_ps(weight)));
+            _mm_storeu_ps(acc+i, d);
+            i+=4;
+        }
+        for (; i < n; ++i)
+            acc[i] += src[i] * weight;
+    }
+
+    static OSD_CPU_INLINE void Store(float *dst, const float *acc, int n) {
+        Load(dst, acc, n);
+    }
+
+    static OSD_CPU_INLINE void StoreStream(float *dst, const float *acc, int n) {
+        for (int i = 0; i < n; ++i)
+            _mm_stream_si32((int *)(dst+i),
+                _mm_cvtsi128_si32(_mm_castps_si128(_mm_load_ss(acc+i))));
+    }
+
+    // half precision data, converted with F16C / AVX-512F
+    static OSD_CPU_INLINE void Load(float *acc, const OsdHalf *src, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16)
+            _mm512_storeu_ps(acc+i, _mm512_cvtph_ps(
+                _mm256_loadu_si256((const __m256i *)(src+i))));
+        if (i+8 <= n) {
+            _mm256_storeu_ps(acc+i, _mm256_cvtph_ps(
+                _mm_loadu_si128((const __m128i *)(src+i))));
+            i+=8;
+        }
+        if (i+4 <= n) {
+            _mm_storeu_ps(acc+i, _mm_cvtph_ps(
+                _mm_loadl_epi64((const __m128i *)(src+i))));
+            i+=4;
+        }
+        for (; i < n; ++i)
+            acc[i] = _cvtsh_ss(src[i]);
+    }
+
+    static OSD_CPU_INLINE void AddWithWeight(float *acc, const OsdHalf *src, float weight, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16) {
+            __m512 s = _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)(src+i)));
+            __m512 d = _mm512_add_ps(_mm512_loadu_ps(acc+i),
+                                     _mm512_mul_ps(s, _mm512_set1_ps(weight)));
+            _mm512_storeu_ps(acc+i, d);
+        }
+        if (i+8 <= n) {
+            __m256 s = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(src+i)));
+            __m256 d = _mm256_add_ps(_mm256_loadu_ps(acc+i),
+                                     _mm256_mul_ps(s, _mm256_set1_ps(weight)));
+            _mm256_storeu_ps(acc+i, d);
+            i+=8;
+        }
+        if (i+4 <= n) {
+            __m128 s = _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)(src+i)));
+            __m128 d = _mm_add_ps(_mm_loadu_ps(acc+i),
+                                  _mm_mul_ps(s, _mm_set1_ps(weight)));
+            _mm_storeu_ps(acc+i, d);
+            i+=4;
+        }
+        for (; i < n; ++i)
+            acc[i] += _cvtsh_ss(src[i]) * weight;
+    }
+
+    static OSD_CPU_INLINE void Store(OsdHalf *dst, const float *acc, int n) {
+        int i = 0;
+        for (; i+16 <= n; i+=16)
+            _mm256_storeu_si256((__m256i *)(dst+i), _mm512_cvtps_ph(
+                _mm512_loadu_ps(acc+i), _MM_FROUND_TO_NEAREST_INT));
+        if (i+8 <= n) {
+            _mm_storeu_si128((__m128i *)(dst+i), _mm256_cvtps_ph(
+                _mm256_loadu_ps(acc+i), _MM_FROUND_TO_NEAREST_INT));
+            i+=8;
+        }
+        if (i+4 <= n) {
+            _mm_storel_epi64((__m128i *)(dst+i), _mm_cvtps_ph(
+                _mm_loadu_ps(acc+i), _MM_FROUND_TO_NEAREST_INT));
+            i+=4;
+        }
+        for (; i < n; ++i)
+            dst[i] = _cvtss_sh(acc[i], _MM_FROUND_TO_NEAREST_INT);
+    }
+
+    static OSD_CPU_INLINE void StoreStream(OsdHalf *dst, const float *acc, int n) {
+        Store(dst, acc, n);
+    }
+
+    static OSD_CPU_INLINE void Fence() {
+        _mm_sfence();
+    }
+};
+
+OsdCpuKernelBundle const g_avx512Kernels[] = OSD_CPU_KERNEL_BUNDLES(AVX512Ops);
+
+} // end anonymous namespace
+
+OsdCpuKernelBundle const *
+OsdCpuGetAVX512KernelBundles() {
+
+    return g_avx512Kernels;
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
@@ -59,19 +59,48 @@
 
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #define OSD_HAS_MMAP
+#endif
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-OsdCpuVertexBuffer::OsdCpuVertexBuffer(int numElements, int numVertices)
+OsdCpuVertexBuffer::OsdCpuVertexBuffer(int numElements, int numVertices,
+                                       Allocation allocation)
     : _numElements(numElements),
       _numVertices(numVertices),
-      _cpuBuffer(NULL) {
+      _cpuBuffer(NULL),
+      _allocation(ALLOCATE_DEFAULT) {
+
+#ifdef OSD_HAS_MMAP
+    size_t size = numElements * numVertices * sizeof(float);
+    if (allocation == ALLOCATE_PAGES and size > 0) {
+        // anonymous mappings are not backed by physical pages until written
+        void * pages = mmap(0, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (pages != MAP_FAILED) {
+            _cpuBuffer = static_cast<float *>(pages);
+            _allocation = ALLOCATE_PAGES;
+            return;
+        }
+    }
+#else
+    (void)allocation;
+#endif
 
     _cpuBuffer = new float[numElements * numVertices];
 }
 
 OsdCpuVertexBuffer::~OsdCpuVertexBuffer() {
 
+#ifdef OSD_HAS_MMAP
+    if (_allocation == ALLOCATE_PAGES) {
+        munmap(_cpuBuffer, _numElements * _numVertices * sizeof(float));
+        return;
+    }
+#endif
     delete[] _cpuBuffer;
 }
 
@@ -81,6 +110,13 @@ OsdCpuVertexBuffer::Create(int numElements, int numVertices) {
     return new OsdCpuVertexBuffer(numElements, numVertices);
 }
 
+OsdCpuVertexBuffer *
+OsdCpuVertexBuffer::Create(int numElements, int numVertices,
+                           Allocation allocation) {
+
+    return new OsdCpuVertexBuffer(numElements, numVertices, allocation);
+}
+
 void
 OsdCpuVertexBuffer::UpdateData(const float *src, int startVertex, int numVertices) {
 
@@ -100,6 +136,13 @@ OsdCpuVertexBuffer::GetNumVertices() const {
     return _numVertices;
 }
 
+void
+OsdCpuVertexBuffer::ReportMemoryUsage(FarMemoryReport & report,
+                                     std::string const & prefix) const {
+
+    report.Add(prefix + "data", _numElements * _numVertices * sizeof(float));
+}
+
 float*
 OsdCpuVertexBuffer::BindCpuBuffer() {
 
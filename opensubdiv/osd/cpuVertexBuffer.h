@@ -59,6 +59,8 @@
 
 #include "../version.h"
 
+#include "../far/memoryReport.h"
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -69,9 +71,31 @@ namespace OPENSUBDIV_VERSION {
 ///
 class OsdCpuVertexBuffer {
 public:
+    /// Memory allocation of the vertex data
+    enum Allocation {
+        ALLOCATE_DEFAULT = 0, ///< allocated from the heap
+        ALLOCATE_PAGES        ///< page aligned memory mapped from the system
+                              ///  and left untouched : each page is placed on
+                              ///  the NUMA node of the first thread writing to
+                              ///  it (see OsdThreadPoolComputeController::
+                              ///  DistributeVertexBuffer)
+    };
+
     /// Creator. Returns NULL if error.
     static OsdCpuVertexBuffer * Create(int numElements, int numVertices);
 
+    /// Creator. Returns NULL if error.
+    ///
+    /// @param numElements  the number of elements of each vertex
+    ///
+    /// @param numVertices  the number of vertices
+    ///
+    /// @param allocation   the memory allocation (ALLOCATE_PAGES reverts to
+    ///                     ALLOCATE_DEFAULT on systems without mmap)
+    ///
+    static OsdCpuVertexBuffer * Create(int numElements, int numVertices,
+                                       Allocation allocation);
+
     /// Destructor.
     ~OsdCpuVertexBuffer();
 
@@ -85,17 +109,33 @@ public:
     /// Returns how many vertices allocated in this vertex buffer.
     int GetNumVertices() const;
 
+    /// Adds the memory allocated by the vertex data to a report
+    ///
+    /// @param report  the report
+    ///
+    /// @param prefix  prefix of the names of the components in the report
+    ///
+    void ReportMemoryUsage(FarMemoryReport & report,
+                           std::string const & prefix=std::string()) const;
+
     /// Returns the address of CPU buffer
     float * BindCpuBuffer();
 
+    /// Returns the memory allocation of the vertex data
+    Allocation GetAllocation() const {
+        return _allocation;
+    }
+
 protected:
     /// Constructor.
-    OsdCpuVertexBuffer(int numElements, int numVertices);
+    OsdCpuVertexBuffer(int numElements, int numVertices,
+                       Allocation allocation=ALLOCATE_DEFAULT);
 
 private:
     int _numElements;
     int _numVertices;
     float *_cpuBuffer;
+    Allocation _allocation;
 };
 
 
@@ -72,10 +72,10 @@ namespace OPENSUBDIV_VERSION {
 
 class OsdCudaTable : OsdNonCopyable<OsdCudaTable> {
 public:
-    template<typename T>
-    static OsdCudaTable * Create(const std::vector<T> &table) {
+    template<class TABLE>
+    static OsdCudaTable * Create(const TABLE &table) {
         OsdCudaTable *result = new OsdCudaTable();
-        if (not result->createCudaBuffer(table.size() * sizeof(T), &table[0])) {
+        if (not result->createCudaBuffer(table.size() * sizeof(typename TABLE::value_type), &table[0])) {
             delete result;
             return NULL;
         }
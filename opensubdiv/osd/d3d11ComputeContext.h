@@ -80,9 +80,9 @@ class OsdD3D11ComputeKernelBundle;
 
 class OsdD3D11ComputeTable : OsdNonCopyable<OsdD3D11ComputeTable> {
 public:
-    template<typename T>
-        OsdD3D11ComputeTable(const std::vector<T> &table, ID3D11DeviceContext *deviceContext, DXGI_FORMAT format) {
-        createBuffer((int)table.size() * sizeof(T), &table[0], format, (int)table.size(), deviceContext);
+    template<class TABLE>
+        OsdD3D11ComputeTable(const TABLE &table, ID3D11DeviceContext *deviceContext, DXGI_FORMAT format) {
+        createBuffer((int)table.size() * sizeof(typename TABLE::value_type), &table[0], format, (int)table.size(), deviceContext);
     }
 
     virtual ~OsdD3D11ComputeTable();
@@ -95,7 +95,8 @@ public:
             _vertexBuffer(0),
             _computeContext(0),
             _computeController(computeController),
-            _drawContext(0)
+            _drawContext(0),
+            _topologyCache(0)
     {
         FarMeshFactory<OsdVertex> meshFactory(hmesh, level, bits.test(MeshAdaptive));
         _farMesh = meshFactory.Create(bits.test(MeshFVarData));
@@ -107,10 +108,42 @@ public:
         _drawContext->UpdateVertexTexture(_vertexBuffer);
     }
 
+    /// Constructor sharing the FarMesh and compute context of the instances
+    /// of the same topology through 'topologyCache' (see OsdTopologyCache).
+    /// Face-varying data is not supported.
+    OsdMesh(ComputeController * computeController,
+            OsdTopologyCache<ComputeContext> * topologyCache,
+            HbrMesh<OsdVertex> * hmesh,
+            int numElements,
+            int level,
+            OsdMeshBitset bits) :
+
+            _farMesh(0),
+            _vertexBuffer(0),
+            _computeContext(0),
+            _computeController(computeController),
+            _drawContext(0),
+            _topologyCache(topologyCache)
+    {
+        assert(not bits.test(MeshFVarData));
+
+        _farMesh = _topologyCache->AcquireMesh(hmesh, level, bits.test(MeshAdaptive));
+
+        int numVertices = _farMesh->GetNumVertices();
+        _vertexBuffer = VertexBuffer::Create(numElements, numVertices);
+        _computeContext = _topologyCache->GetComputeContext(_farMesh);
+        _drawContext = DrawContext::Create(_farMesh->GetPatchTables(), bits.test(MeshFVarData));
+        _drawContext->UpdateVertexTexture(_vertexBuffer);
+    }
+
     virtual ~OsdMesh() {
-        delete _farMesh;
+        if (_topologyCache) {
+            _topologyCache->Release(_farMesh);
+        } else {
+            delete _farMesh;
+            delete _computeContext;
+        }
         delete _vertexBuffer;
-        delete _computeContext;
         delete _drawContext;
     }
 
@@ -133,11 +166,12 @@ public:
     }
 
 private:
-    FarMesh<OsdVertex> *_farMesh;
+    FarMesh<OsdVertex> const *_farMesh;
     VertexBuffer *_vertexBuffer;
     ComputeContext *_computeContext;
     ComputeController *_computeController;
     DrawContext *_drawContext;
+    OsdTopologyCache<ComputeContext> *_topologyCache;
 };
 
 #ifdef OPENSUBDIV_HAS_OPENCL
@@ -90,8 +90,8 @@ class OsdGLSLComputeKernelBundle;
 
 class OsdGLSLComputeTable : OsdNonCopyable<OsdGLSLComputeTable> {
 public:
-    template<typename T>
-    explicit OsdGLSLComputeTable(const std::vector<T> &table) {
+    template<class TABLE>
+    explicit OsdGLSLComputeTable(const TABLE &table) {
         createBuffer(table.size() * sizeof(unsigned int), &table[0]);
     }
 
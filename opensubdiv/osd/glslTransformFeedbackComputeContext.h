@@ -89,8 +89,8 @@ class OsdGLSLTransformFeedbackKernelBundle;
 
 class OsdGLSLTransformFeedbackTable : OsdNonCopyable<OsdGLSLTransformFeedbackTable> {
 public:
-    template<typename T>
-    OsdGLSLTransformFeedbackTable(const std::vector<T> &table, GLenum type) {
+    template<class TABLE>
+    OsdGLSLTransformFeedbackTable(const TABLE &table, GLenum type) {
         createTextureBuffer(table.size() * sizeof(unsigned int), &table[0], type);
     }
 
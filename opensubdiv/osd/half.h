@@ -0,0 +1,167 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_HALF_H
+#define OSD_HALF_H
+
+#include "../version.h"
+
+#include <string.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Half precision (IEEE 754 binary16) primvar data.
+///
+/// Buffers of half precision primvar data (see OsdCpuHalfVertexBuffer) halve
+/// the memory traffic of the refinement : the CPU kernels convert the data to
+/// single precision and accumulate in single precision.
+///
+typedef unsigned short OsdHalf;
+
+/// \brief Storage precision of the primvar data in a vertex buffer
+enum OsdPrecision {
+    OSD_PRECISION_FLOAT,  ///< single precision (float)
+    OSD_PRECISION_HALF    ///< half precision (OsdHalf)
+};
+
+/// Returns the precision of a buffer of primvar data
+inline OsdPrecision OsdGetPrecision(float const *) { return OSD_PRECISION_FLOAT; }
+
+/// Returns the precision of a buffer of primvar data
+inline OsdPrecision OsdGetPrecision(OsdHalf const *) { return OSD_PRECISION_HALF; }
+
+/// \brief Portable conversions between single and half precision.
+///
+/// Conversions are exact (round to nearest even), which matches the F16C
+/// instructions for all the values but NaNs.
+///
+/// The conversions are instantiated separately by the CPU kernels compiled
+/// for each instruction set (see cpuSimdKernel.h) : use OsdHalfToFloat() and
+/// OsdFloatToHalf() otherwise.
+///
+template <class T> struct OsdHalfConversion {
+
+    static float ToFloat(OsdHalf h) {
+        unsigned int bits = (unsigned int)(h & 0x7fff) << 13,
+                     exponent = bits & (0x7c00 << 13);
+
+        bits += (127 - 15) << 23;                 // rebias the exponent
+        if (exponent == (0x7c00 << 13)) {
+            bits += (128 - 16) << 23;             // infinity / NaN
+        } else if (exponent == 0) {
+            bits += 1 << 23;                      // zero / denormal :
+            float f, magic;                       // renormalize
+            unsigned int magicBits = 113 << 23;
+            memcpy(&f, &bits, 4);
+            memcpy(&magic, &magicBits, 4);
+            f -= magic;
+            memcpy(&bits, &f, 4);
+        }
+        bits |= (unsigned int)(h & 0x8000) << 16;
+
+        float result;
+        memcpy(&result, &bits, 4);
+        return result;
+    }
+
+    static OsdHalf FromFloat(float value) {
+        unsigned int bits;
+        memcpy(&bits, &value, 4);
+
+        unsigned int sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        unsigned int result;
+        if (bits >= (127 + 16) << 23) {
+            // overflow to infinity, NaN to quiet NaN
+            result = bits > (255u << 23) ? 0x7e00 : 0x7c00;
+        } else if (bits < (113 << 23)) {
+            // denormal or zero : align the mantissa with a magic number, the
+            // float addition rounds to nearest even
+            float f, magic;
+            unsigned int magicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+            memcpy(&f, &bits, 4);
+            memcpy(&magic, &magicBits, 4);
+            f += magic;
+            memcpy(&result, &f, 4);
+            result -= magicBits;
+        } else {
+            // rebias the exponent and round the mantissa to nearest even
+            unsigned int odd = (bits >> 13) & 1;
+            bits += ((unsigned int)(15 - 127) << 23) + 0xfff + odd;
+            result = bits >> 13;
+        }
+        return (OsdHalf)(result | (sign >> 16));
+    }
+};
+
+/// Converts a half precision value to single precision
+inline float OsdHalfToFloat(OsdHalf h) {
+    return OsdHalfConversion<void>::ToFloat(h);
+}
+
+/// Converts a single precision value to half precision (round to nearest even)
+inline OsdHalf OsdFloatToHalf(float f) {
+    return OsdHalfConversion<void>::FromFloat(f);
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_HALF_H
@@ -0,0 +1,456 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/hybridComputeController.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace {
+
+// thresholds of the kernels that were not calibrated
+int const g_defaultSimdThreshold = 16,
+          g_defaultParallelThreshold = 4096;
+
+// the smallest range of vertices timed by the calibration
+int const g_minCalibrationSize = 8;
+
+// the number of vertices computed by each timing of the calibration
+int const g_calibrationVertices = 16384;
+
+int const g_calibrationVersion = 1;
+
+double
+getTime() {
+
+    timeval t;
+    gettimeofday(&t, 0);
+    return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
+}
+
+} // end anonymous namespace
+
+OsdHybridComputeController::OsdHybridComputeController(
+    int numThreads, int grainSize, bool pinThreads) :
+    _parallelController(numThreads, grainSize, pinThreads) {
+}
+
+OsdHybridComputeController::~OsdHybridComputeController() {
+}
+
+OsdHybridComputeController::Thresholds
+OsdHybridComputeController::getThresholds(
+    FarKernelBatch::KernelType kernel, int numElements) const {
+
+    Thresholds result = { g_defaultSimdThreshold, g_defaultParallelThreshold };
+
+    // the closest width with thresholds for the kernel (unset thresholds are
+    // negative)
+    int distance = INT_MAX;
+    for (ThresholdMap::const_iterator it = _thresholds.begin(); it != _thresholds.end(); ++it) {
+        Thresholds const & thresholds = it->second[kernel];
+        if (thresholds.simd >= 0 and abs(it->first - numElements) < distance) {
+            distance = abs(it->first - numElements);
+            result = thresholds;
+        }
+    }
+    return result;
+}
+
+OsdHybridComputeController::Execution
+OsdHybridComputeController::GetExecution(
+    FarKernelBatch const & batch, int numElements) const {
+
+    // several edits can apply to the same vertex : they run in sequence
+    if (batch.GetKernelType() == FarKernelBatch::HIERARCHICAL_EDIT)
+        return EXEC_SCALAR;
+
+    Thresholds thresholds = getThresholds(batch.GetKernelType(), numElements);
+
+    int numVertices = batch.GetEnd() - batch.GetStart();
+    if (numVertices >= thresholds.parallel)
+        return EXEC_PARALLEL;
+    if (numVertices >= thresholds.simd)
+        return EXEC_SIMD;
+    return EXEC_SCALAR;
+}
+
+void
+OsdHybridComputeController::setThresholds(ThresholdMap & map,
+    FarKernelBatch::KernelType kernel, int numElements, int simd, int parallel) {
+
+    assert(kernel >= 0 and kernel < FarKernelBatch::HIERARCHICAL_EDIT);
+
+    std::vector<Thresholds> & thresholds = map[numElements];
+    if (thresholds.empty()) {
+        Thresholds unset = { -1, -1 };
+        thresholds.resize(FarKernelBatch::HIERARCHICAL_EDIT, unset);
+    }
+    thresholds[kernel].simd = std::max(simd, 0);
+    thresholds[kernel].parallel = std::max(parallel, 0);
+}
+
+void
+OsdHybridComputeController::SetThresholds(
+    FarKernelBatch::KernelType kernel, int numElements, int simd, int parallel) {
+
+    setThresholds(_thresholds, kernel, numElements, simd, parallel);
+}
+
+void
+OsdHybridComputeController::GetThresholds(
+    FarKernelBatch::KernelType kernel, int numElements, int *simd, int *parallel) const {
+
+    assert(kernel >= 0 and kernel < FarKernelBatch::HIERARCHICAL_EDIT);
+
+    Thresholds thresholds = getThresholds(kernel, numElements);
+    if (simd)
+        *simd = thresholds.simd;
+    if (parallel)
+        *parallel = thresholds.parallel;
+}
+
+void
+OsdHybridComputeController::ResetThresholds() {
+
+    _thresholds.clear();
+}
+
+bool
+OsdHybridComputeController::SaveCalibration(char const * path) const {
+
+    FILE * file = fopen(path, "w");
+    if (not file)
+        return false;
+
+    fprintf(file, "# OpenSubdiv hybrid compute controller calibration\n");
+    fprintf(file, "version %d\n", g_calibrationVersion);
+    fprintf(file, "isa %s\n", OsdCpuSimd::GetISAName(OsdCpuSimd::GetISA()));
+    fprintf(file, "threads %d\n", GetNumThreads());
+
+    // elements, kernel, simd and parallel thresholds
+    for (ThresholdMap::const_iterator it = _thresholds.begin(); it != _thresholds.end(); ++it) {
+        for (int kernel = 0; kernel < (int)it->second.size(); ++kernel) {
+            Thresholds const & thresholds = it->second[kernel];
+            if (thresholds.simd >= 0)
+                fprintf(file, "%d %d %d %d\n", it->first, kernel,
+                        thresholds.simd, thresholds.parallel);
+        }
+    }
+
+    return fclose(file) == 0;
+}
+
+bool
+OsdHybridComputeController::LoadCalibration(char const * path) {
+
+    FILE * file = fopen(path, "r");
+    if (not file)
+        return false;
+
+    char comment[256], isa[32];
+    int version = 0, numThreads = 0;
+
+    // the thresholds only apply to the instruction set and threads they were
+    // measured with
+    bool valid = fgets(comment, sizeof(comment), file) and
+                 fscanf(file, " version %d isa %31s threads %d",
+                        &version, isa, &numThreads) == 3 and
+                 version == g_calibrationVersion and
+                 strcmp(isa, OsdCpuSimd::GetISAName(OsdCpuSimd::GetISA())) == 0 and
+                 numThreads == GetNumThreads();
+
+    ThresholdMap thresholds;
+
+    int numElements, kernel, simd, parallel;
+    while (valid and fscanf(file, "%d %d %d %d", &numElements, &kernel, &simd, &parallel) == 4) {
+        if (numElements < 0 or kernel < 0 or kernel >= FarKernelBatch::HIERARCHICAL_EDIT) {
+            valid = false;
+        } else {
+            setThresholds(thresholds, (FarKernelBatch::KernelType)kernel,
+                          numElements, simd, parallel);
+        }
+    }
+    valid = valid and feof(file);
+
+    fclose(file);
+
+    if (valid)
+        _thresholds.swap(thresholds);
+    return valid;
+}
+
+void
+OsdHybridComputeController::calibrate(
+    OsdCpuComputeContext *context, FarKernelBatchVector const & batches) {
+
+    assert(context);
+
+    int numElements = context->GetVertexDescriptor().GetNumElements();
+
+    for (int kernel = 0; kernel < FarKernelBatch::HIERARCHICAL_EDIT; ++kernel) {
+
+        // the largest batch of the kernel
+        int largest = -1, size = 0;
+        for (int i = 0; i < (int)batches.size(); ++i) {
+            if (batches[i].GetKernelType() == kernel and
+                batches[i].GetEnd() - batches[i].GetStart() > size) {
+                largest = i;
+                size = batches[i].GetEnd() - batches[i].GetStart();
+            }
+        }
+        if (largest < 0)
+            continue;
+
+        FarKernelBatch const & batch = batches[largest];
+
+        // ranges of vertices of growing sizes, from the start of the batch
+        std::vector<int> sizes;
+        for (int n = g_minCalibrationSize; n < size; n *= 2)
+            sizes.push_back(n);
+        sizes.push_back(size);
+
+        // best time of each execution on each range (the kernels are run
+        // several times on the small ranges : the vertices they compute are
+        // refined again by Calibrate())
+        std::vector<double> times(sizes.size() * EXEC_COUNT);
+        for (int i = 0; i < (int)sizes.size(); ++i) {
+
+            FarKernelBatch range(batch.GetKernelType(),
+                                 batch.GetLevel(),
+                                 batch.GetTableIndex(),
+                                 batch.GetStart(),
+                                 batch.GetStart() + sizes[i],
+                                 batch.GetTableOffset(),
+                                 batch.GetVertexOffset(),
+                                 batch.GetMeshIndex());
+
+            int repeats = std::max(1, g_calibrationVertices / sizes[i]);
+
+            for (int execution = 0; execution < EXEC_COUNT; ++execution) {
+                double best = DBL_MAX;
+                for (int trial = 0; trial < 3; ++trial) {
+                    double start = getTime();
+                    for (int j = 0; j < repeats; ++j)
+                        execute((Execution)execution, range, context);
+                    best = std::min(best, getTime() - start);
+                }
+                times[i * EXEC_COUNT + execution] = best;
+            }
+        }
+
+        Thresholds thresholds = getThresholds((FarKernelBatch::KernelType)kernel, numElements);
+
+        // the smallest range from which the SIMD kernels are faster on every
+        // larger range
+        int i = (int)sizes.size();
+        while (i > 0 and times[(i-1) * EXEC_COUNT + EXEC_SIMD] <=
+                         times[(i-1) * EXEC_COUNT + EXEC_SCALAR])
+            --i;
+        thresholds.simd = i == 0 ? 0 : (i == (int)sizes.size() ? INT_MAX : sizes[i]);
+
+        // the smallest range from which the threads are faster on every
+        // larger range (the ranges above the largest batch are unknown)
+        i = (int)sizes.size();
+        while (i > 0 and times[(i-1) * EXEC_COUNT + EXEC_PARALLEL] <
+                         std::min(times[(i-1) * EXEC_COUNT + EXEC_SIMD],
+                                  times[(i-1) * EXEC_COUNT + EXEC_SCALAR]))
+            --i;
+        if (i < (int)sizes.size()) {
+            thresholds.parallel = sizes[i];
+        } else if (thresholds.parallel <= size) {
+            thresholds.parallel = size + 1;
+        }
+
+        SetThresholds((FarKernelBatch::KernelType)kernel, numElements,
+                      thresholds.simd, thresholds.parallel);
+    }
+}
+
+void
+OsdHybridComputeController::execute(
+    Execution execution, FarKernelBatch const &batch, OsdCpuComputeContext * context) const {
+
+    // the scalar and SIMD kernels produce identical results
+    context->SetKernelISA(execution == EXEC_SCALAR ?
+                          OsdCpuSimd::ISA_NONE : OsdCpuSimd::GetISA());
+
+    if (execution == EXEC_PARALLEL) {
+        FarDispatcher::ApplyKernel(&_parallelController, batch, context);
+    } else {
+        FarDispatcher::ApplyKernel(&_cpuController, batch, context);
+    }
+}
+
+void
+OsdHybridComputeController::apply(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    OsdCpuComputeContext * context = static_cast<OsdCpuComputeContext *>(clientdata);
+    assert(context);
+
+    execute(GetExecution(batch, context->GetVertexDescriptor().GetNumElements()),
+            batch, context);
+}
+
+void
+OsdHybridComputeController::ApplyBilinearFaceVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyBilinearEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyBilinearVertexVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyCatmarkFaceVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyCatmarkEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyCatmarkVertexVerticesKernelB(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyCatmarkVertexVerticesKernelA1(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyCatmarkVertexVerticesKernelA2(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyLoopEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyLoopVertexVerticesKernelB(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyLoopVertexVerticesKernelA1(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyLoopVertexVerticesKernelA2(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::ApplyVertexEdits(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    apply(batch, clientdata);
+}
+
+void
+OsdHybridComputeController::Synchronize() {
+    // the kernels are complete when Refine returns
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
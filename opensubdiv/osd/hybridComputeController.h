@@ -0,0 +1,436 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_HYBRID_COMPUTE_CONTROLLER_H
+#define OSD_HYBRID_COMPUTE_CONTROLLER_H
+
+#include "../version.h"
+
+#include "../far/dispatcher.h"
+#include "../osd/cpuComputeContext.h"
+#include "../osd/cpuComputeController.h"
+#include "../osd/threadPoolComputeController.h"
+
+#include <map>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Compute controller choosing how to run the CPU kernels of each
+/// batch.
+///
+/// Small batches run faster on the calling thread, where the portable scalar
+/// kernels can even beat the SIMD ones, while large batches benefit from the
+/// threads of an OsdThreadPool. OsdHybridComputeController selects the
+/// execution of every batch from its number of vertices, its kernel and the
+/// number of primvar elements of the bound buffers, so that meshes mixing
+/// tiny adaptive batches and large uniform ones get the best of each.
+///
+/// The selection uses two thresholds per kernel and primvar width : batches of
+/// at least 'simd' vertices use the SIMD kernels, and batches of at least
+/// 'parallel' vertices are split across the threads. Calibrate() measures the
+/// thresholds on the host, and SaveCalibration() / LoadCalibration() persist
+/// them so that the measurements run only once. All the executions produce
+/// identical results.
+///
+/// Controller entities execute requests from Context instances that they share
+/// common interfaces with. Controllers are attached to discrete compute devices
+/// and share the devices resources with Context entities.
+///
+class OsdHybridComputeController {
+public:
+    typedef OsdCpuComputeContext ComputeContext;
+
+    /// Execution of the kernels of a batch
+    enum Execution {
+        EXEC_SCALAR = 0, ///< portable scalar kernels on the calling thread
+        EXEC_SIMD,       ///< SIMD kernels (see OsdCpuSimd) on the calling thread
+        EXEC_PARALLEL,   ///< SIMD kernels split across the threads
+        EXEC_COUNT
+    };
+
+    /// Constructor.
+    ///
+    /// @param numThreads  the number of threads running the parallel batches,
+    ///                    including the calling thread. -1 uses all available
+    ///                    processors.
+    ///
+    /// @param grainSize   the number of vertices computed by a thread in one go
+    ///
+    /// @param pinThreads  pins each worker thread to a processor (Linux only)
+    ///
+    explicit OsdHybridComputeController(int numThreads=-1,
+                                        int grainSize=256,
+                                        bool pinThreads=false);
+
+    /// Destructor.
+    ~OsdHybridComputeController();
+
+    /// Launch subdivision kernels and apply to given vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to given vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        FarDispatcher::Refine(this, plan, context);
+        context->Unbind();
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, plan, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels and apply to the elements of given vertex
+    /// buffers described by buffer descriptors.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer (can be the same
+    ///                       as vertexBuffer)
+    ///
+    /// @param  varyingDesc   the varying-interpolated elements in varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER *varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to the elements of a given vertex
+    /// buffer described by a buffer descriptor.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc) {
+        Refine(context, batches, vertexBuffer, vertexDesc,
+               (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+    }
+
+    /// Measures the thresholds of the kernels used by the batches, for the
+    /// primvar width of the given buffers : the largest batch of each kernel
+    /// is timed on growing ranges of vertices with each execution. The
+    /// batches are refined again once the measures are complete, so that
+    /// the buffers hold the same vertices as after Refine().
+    ///
+    /// Calibrating on a mesh with large batches gives the best parallel
+    /// thresholds : the thresholds above the largest batch are left unchanged.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Calibrate(OsdCpuComputeContext *context,
+                   FarKernelBatchVector const & batches,
+                   VERTEX_BUFFER *vertexBuffer,
+                   VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        calibrate(context, batches);
+        context->Unbind();
+
+        Refine(context, batches, vertexBuffer, varyingBuffer);
+    }
+
+    /// Measures the thresholds of the kernels used by the batches, for the
+    /// primvar width of the given buffer.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Calibrate(OsdCpuComputeContext *context,
+                   FarKernelBatchVector const & batches,
+                   VERTEX_BUFFER *vertexBuffer) {
+        Calibrate(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Returns the execution selected for a batch
+    ///
+    /// @param  batch         the batch of vertices
+    ///
+    /// @param  numElements   the number of vertex and varying primvar elements
+    ///
+    Execution GetExecution(FarKernelBatch const & batch, int numElements) const;
+
+    /// Sets the thresholds of a kernel for a primvar width. The thresholds of
+    /// the closest width are used for the widths that have none (default ones
+    /// if there is no threshold at all).
+    ///
+    /// @param  kernel        the kernel of the batches
+    ///
+    /// @param  numElements   the number of vertex and varying primvar elements
+    ///
+    /// @param  simd          the number of vertices from which the batches run
+    ///                       the SIMD kernels
+    ///
+    /// @param  parallel      the number of vertices from which the batches are
+    ///                       split across the threads
+    ///
+    void SetThresholds(FarKernelBatch::KernelType kernel, int numElements,
+                       int simd, int parallel);
+
+    /// Returns the thresholds used for a kernel and a primvar width (see
+    /// SetThresholds())
+    void GetThresholds(FarKernelBatch::KernelType kernel, int numElements,
+                       int *simd, int *parallel) const;
+
+    /// Removes all the thresholds, reverting to the default ones
+    void ResetThresholds();
+
+    /// Writes the thresholds to a text file, along with the instruction set
+    /// and the number of threads they were measured with.
+    ///
+    /// @param  path          the path of the file
+    ///
+    /// @return               false if the file cannot be written
+    ///
+    bool SaveCalibration(char const * path) const;
+
+    /// Reads thresholds written by SaveCalibration(). The calibration is
+    /// rejected if it was measured with another instruction set or number of
+    /// threads.
+    ///
+    /// @param  path          the path of the file
+    ///
+    /// @return               false if the file cannot be read or does not
+    ///                       match the controller (the thresholds are left
+    ///                       unchanged)
+    ///
+    bool LoadCalibration(char const * path);
+
+    /// Waits until all running subdivision kernels finish.
+    void Synchronize();
+
+    /// Returns the number of threads running the parallel batches
+    int GetNumThreads() const {
+        return _parallelController.GetNumThreads();
+    }
+
+protected:
+    friend class FarDispatcher;
+    void ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyBilinearEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyBilinearVertexVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyCatmarkFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelB(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelA1(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelA2(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyLoopEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelB(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelA1(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelA2(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyVertexEdits(FarKernelBatch const &batch, void * clientdata) const;
+
+private:
+    // the number of vertices from which a kernel runs each execution
+    struct Thresholds {
+        int simd,
+            parallel;
+    };
+
+    // the thresholds of the kernels (indexed by FarKernelBatch::KernelType),
+    // keyed by number of primvar elements
+    typedef std::map<int, std::vector<Thresholds> > ThresholdMap;
+
+    static void setThresholds(ThresholdMap & map, FarKernelBatch::KernelType kernel,
+                              int numElements, int simd, int parallel);
+
+    // returns the thresholds of a kernel for the closest primvar width
+    Thresholds getThresholds(FarKernelBatch::KernelType kernel, int numElements) const;
+
+    // runs the kernel of a batch with a given execution
+    void execute(Execution execution, FarKernelBatch const &batch,
+                 OsdCpuComputeContext * context) const;
+
+    // runs the kernel of a batch with the selected execution
+    void apply(FarKernelBatch const &batch, void * clientdata) const;
+
+    // times the executions of the kernels on the bound buffers
+    void calibrate(OsdCpuComputeContext *context, FarKernelBatchVector const & batches);
+
+    OsdCpuComputeController _cpuController;                // serial batches
+
+    OsdThreadPoolComputeController _parallelController;    // parallel batches
+
+    ThresholdMap _thresholds;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_HYBRID_COMPUTE_CONTROLLER_H
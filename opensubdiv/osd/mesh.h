@@ -67,6 +67,7 @@
 #include "../osd/vertex.h"
 
 #include <bitset>
+#include <cassert>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -81,6 +82,8 @@ enum OsdMeshBits {
 };
 typedef std::bitset<NUM_MESH_BITS> OsdMeshBitset;
 
+template <class COMPUTE_CONTEXT> class OsdTopologyCache;
+
 template <class DRAW_CONTEXT>
 class OsdMeshInterface {
 public:
@@ -124,7 +127,8 @@ public:
             _vertexBuffer(0),
             _computeContext(0),
             _computeController(computeController),
-            _drawContext(0)
+            _drawContext(0),
+            _topologyCache(0)
     {
         FarMeshFactory<OsdVertex> meshFactory(hmesh, level, bits.test(MeshAdaptive));
         _farMesh = meshFactory.Create(bits.test(MeshFVarData));
@@ -136,10 +140,42 @@ public:
                                            bits.test(MeshFVarData));
     }
 
+    /// Constructor sharing the FarMesh and compute context of the instances
+    /// of the same topology through 'topologyCache' (see OsdTopologyCache).
+    /// Face-varying data is not supported.
+    OsdMesh(ComputeController * computeController,
+            OsdTopologyCache<ComputeContext> * topologyCache,
+            HbrMesh<OsdVertex> * hmesh,
+            int numElements,
+            int level,
+            OsdMeshBitset bits = OsdMeshBitset()) :
+
+            _farMesh(0),
+            _vertexBuffer(0),
+            _computeContext(0),
+            _computeController(computeController),
+            _drawContext(0),
+            _topologyCache(topologyCache)
+    {
+        assert(not bits.test(MeshFVarData));
+
+        _farMesh = _topologyCache->AcquireMesh(hmesh, level, bits.test(MeshAdaptive));
+
+        int numVertices = _farMesh->GetNumVertices();
+        _vertexBuffer = VertexBuffer::Create(numElements, numVertices);
+        _computeContext = _topologyCache->GetComputeContext(_farMesh);
+        _drawContext = DrawContext::Create(_farMesh, _vertexBuffer,
+                                           bits.test(MeshFVarData));
+    }
+
     virtual ~OsdMesh() {
-        delete _farMesh;
+        if (_topologyCache) {
+            _topologyCache->Release(_farMesh);
+        } else {
+            delete _farMesh;
+            delete _computeContext;
+        }
         delete _vertexBuffer;
-        delete _computeContext;
         delete _drawContext;
     }
 
@@ -149,7 +185,7 @@ public:
         _vertexBuffer->UpdateData(vertexData, startVertex, numVerts);
     }
     virtual void Refine() {
-        _computeController->Refine(_computeContext, _vertexBuffer);
+        _computeController->Refine(_computeContext, _farMesh->GetKernelBatches(), _vertexBuffer);
     }
     virtual void Synchronize() {
         _computeController->Synchronize();
@@ -162,11 +198,12 @@ public:
     }
 
 private:
-    FarMesh<OsdVertex> *_farMesh;
+    FarMesh<OsdVertex> const *_farMesh;
     VertexBuffer *_vertexBuffer;
     ComputeContext *_computeContext;
     ComputeController *_computeController;
     DrawContext *_drawContext;
+    OsdTopologyCache<ComputeContext> *_topologyCache;
 };
 
 }  // end namespace OPENSUBDIV_VERSION
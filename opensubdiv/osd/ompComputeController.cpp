@@ -73,6 +73,60 @@ OsdOmpComputeController::OsdOmpComputeController(int numThreads) {
 }
 
 
+void
+OsdOmpComputeController::applyStencils(
+    OsdCpuComputeContext *context,
+    FarStencilTables const * vertexStencils,
+    FarStencilTables const * varyingStencils) const {
+
+    assert(context and vertexStencils);
+
+    FAR_TRACE_SCOPE("OsdOmpComputeController::applyStencils", "refine");
+
+    FarStencilBatchVector const & batches = vertexStencils->GetBatches();
+
+    // both tables are generated from the same mesh : their batches match
+    float * varying = varyingStencils ? context->GetCurrentVaryingBuffer() : 0;
+    assert(not varyingStencils or
+           varyingStencils->GetBatches().size() == batches.size());
+
+    for (int i = 0; i < (int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType() == FarStencilBatch::HIERARCHICAL_EDIT) {
+            ApplyVertexEdits(batch.GetEditBatch(), context);
+            continue;
+        }
+
+        if (batch.GetStart() == batch.GetEnd())
+            continue;
+
+        OsdOmpComputeVertexStencils(
+            context->GetVertexDescriptor(),
+            context->GetCurrentVertexBuffer(),
+            &vertexStencils->GetSizes()[0],
+            &vertexStencils->GetOffsets()[0],
+            &vertexStencils->GetIndices()[0],
+            &vertexStencils->GetWeights()[0],
+            batch.GetVertexOffset(), batch.GetTableOffset(),
+            batch.GetStart(), batch.GetEnd());
+
+        if (varying) {
+            FarStencilBatch const & ybatch = varyingStencils->GetBatches()[i];
+            OsdOmpComputeVaryingStencils(
+                context->GetVertexDescriptor(),
+                varying,
+                &varyingStencils->GetSizes()[0],
+                &varyingStencils->GetOffsets()[0],
+                &varyingStencils->GetIndices()[0],
+                &varyingStencils->GetWeights()[0],
+                ybatch.GetVertexOffset(), ybatch.GetTableOffset(),
+                ybatch.GetStart(), ybatch.GetEnd());
+        }
+    }
+}
+
 void
 OsdOmpComputeController::ApplyBilinearFaceVerticesKernel(
     FarKernelBatch const &batch, void *clientdata) const {
@@ -60,6 +60,7 @@
 #include "../version.h"
 
 #include "../far/dispatcher.h"
+#include "../far/stencilTables.h"
 #include "../osd/cpuComputeContext.h"
 
 #ifdef OPENSUBDIV_HAS_OPENMP
@@ -73,7 +74,8 @@ namespace OPENSUBDIV_VERSION {
 ///
 /// OsdOmpComputeController is a compute controller class to launch OpenMP
 /// threaded subdivision kernels. It requires OsdCpuVertexBufferInterface
-/// as arguments of Refine function.
+/// as arguments of Refine function. Only single precision buffers are
+/// supported (half precision buffers are refined by OsdCpuComputeController).
 ///
 /// Controller entities execute requests from Context instances that they share
 /// common interfaces with. Controllers are attached to discrete compute devices
@@ -133,10 +135,196 @@ public:
         Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers. The plan is compiled once from the kernel batches of
+    /// the mesh, which saves the per-batch dispatch of repeated refinements.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        omp_set_num_threads(_numThreads);
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        FarDispatcher::Refine(this, plan, context);
+        context->Unbind();
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, plan, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels and apply to the elements of given vertex
+    /// buffers described by buffer descriptors : the primvars can be
+    /// interleaved with other data, which is left untouched.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer (can be the same
+    ///                       as vertexBuffer)
+    ///
+    /// @param  varyingDesc   the varying-interpolated elements in varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER *varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        omp_set_num_threads(_numThreads);
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to the elements of a given vertex
+    /// buffer described by a buffer descriptor.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc) {
+        Refine(context, batches, vertexBuffer, vertexDesc,
+               (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data (see
+    ///                         FarStencilTablesFactory)
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                VARYING_BUFFER * varyingBuffer) {
+
+        omp_set_num_threads(_numThreads);
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, vertexStencils, (FarStencilTables const *)0,
+               vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Apply refinement stencils to the elements of given vertex buffers
+    /// described by buffer descriptors.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc      the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer (can be the
+    ///                         same as vertexBuffer)
+    ///
+    /// @param  varyingDesc     the varying-interpolated elements in
+    ///                         varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER * varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        omp_set_num_threads(_numThreads);
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
 protected:
+    // applies the stencil batches and hierarchical edits in sequence
+    void applyStencils(OsdCpuComputeContext *context,
+                       FarStencilTables const * vertexStencils,
+                       FarStencilTables const * varyingStencils) const;
+
     friend class FarDispatcher;
 
     void ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
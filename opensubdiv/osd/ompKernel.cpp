@@ -56,6 +56,7 @@
 //
 
 #include "../osd/ompKernel.h"
+#include "../osd/cpuKernel.h"
 #include "../osd/vertexDescriptor.h"
 
 #include <math.h>
@@ -64,27 +65,32 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-void OsdOmpComputeFace(
-    OsdVertexDescriptor const &vdesc, float * vertex, float * varying,
-    const int *F_IT, const int *F_ITa, int offset, int tableOffset, int start, int end) {
+// The OMP kernels split the batch range in one contiguous span per thread
+// and run the serial CPU kernels on each span, so that they share the SIMD
+// code paths selected at runtime (see OsdCpuSimd).
+static inline bool
+getThreadRange(int start, int end, int *threadStart, int *threadEnd) {
 
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = F_ITa[2*i];
-        int n = F_ITa[2*i+1];
+    int numThreads = omp_get_num_threads(),
+        thread = omp_get_thread_num(),
+        chunk = (end - start + numThreads - 1) / numThreads;
+
+    *threadStart = start + thread * chunk;
+    *threadEnd = *threadStart + chunk < end ? *threadStart + chunk : end;
 
-        float weight = 1.0f/n;
+    return *threadStart < *threadEnd;
+}
 
-        // XXX: should use local vertex struct variable instead of
-        // accumulating directly into global memory.
-        int dstIndex = offset + i - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+void OsdOmpComputeFace(
+    OsdVertexDescriptor const &vdesc, float * vertex, float * varying,
+    const int *F_IT, const int *F_ITa, int offset, int tableOffset, int start, int end) {
 
-        for (int j = 0; j < n; ++j) {
-            int index = F_IT[h+j];
-            vdesc.AddWithWeight(vertex, dstIndex, index, weight);
-            vdesc.AddVaryingWithWeight(varying, dstIndex, index, weight);
-        }
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeFace(vdesc, vertex, varying, F_IT, F_ITa,
+                              offset, tableOffset, s, e);
     }
 }
 
@@ -92,160 +98,105 @@ void OsdOmpComputeEdge(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
     const int *E_IT, const float *E_W, int offset, int tableOffset, int start, int end) {
 
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int eidx0 = E_IT[4*i+0];
-        int eidx1 = E_IT[4*i+1];
-        int eidx2 = E_IT[4*i+2];
-        int eidx3 = E_IT[4*i+3];
-
-        float vertWeight = E_W[i*2+0];
-
-        int dstIndex = offset + i - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, eidx0, vertWeight);
-        vdesc.AddWithWeight(vertex, dstIndex, eidx1, vertWeight);
-
-        if (eidx2 != -1) {
-            float faceWeight = E_W[i*2+1];
-
-            vdesc.AddWithWeight(vertex, dstIndex, eidx2, faceWeight);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx3, faceWeight);
-        }
-
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeEdge(vdesc, vertex, varying, E_IT, E_W,
+                              offset, tableOffset, s, e);
     }
 }
 
 void OsdOmpComputeVertexA(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, const float *V_W,
-    int offset, int tableOffset, int start, int end, int pass) {
-
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int n     = V_ITa[5*i+1];
-        int p     = V_ITa[5*i+2];
-        int eidx0 = V_ITa[5*i+3];
-        int eidx1 = V_ITa[5*i+4];
-
-        float weight = (pass == 1) ? V_W[i] : 1.0f - V_W[i];
-
-        // In the case of fractional weight, the weight must be inverted since
-        // the value is shared with the k_Smooth kernel (statistically the
-        // k_Smooth kernel runs much more often than this one)
-        if (weight > 0.0f && weight < 1.0f && n > 0)
-            weight = 1.0f - weight;
-
-        int dstIndex = offset + i - tableOffset;
-        if (not pass)
-            vdesc.Clear(vertex, varying, dstIndex);
-
-        if (eidx0 == -1 || (pass == 0 && (n == -1))) {
-            vdesc.AddWithWeight(vertex, dstIndex, p, weight);
-        } else {
-            vdesc.AddWithWeight(vertex, dstIndex, p, weight * 0.75f);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx0, weight * 0.125f);
-            vdesc.AddWithWeight(vertex, dstIndex, eidx1, weight * 0.125f);
-        }
-
-        if (not pass)
-            vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    const int *V_ITa, const float *V_W, int offset, int tableOffset, int start, int end, int pass) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeVertexA(vdesc, vertex, varying, V_ITa, V_W,
+                                 offset, tableOffset, s, e, pass);
     }
 }
 
 void OsdOmpComputeVertexB(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, const int *V_IT, const float *V_W,
-    int offset, int tableOffset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
-
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n*n);
-        float wv = (n-2.0f) * n * wp;
-
-        int dstIndex = offset + i - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, p, weight * wv);
-
-        for (int j = 0; j < n; ++j) {
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j*2], weight * wp);
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j*2+1], weight * wp);
-        }
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    const int *V_ITa, const int *V_IT, const float *V_W, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeVertexB(vdesc, vertex, varying, V_ITa, V_IT, V_W,
+                                 offset, tableOffset, s, e);
     }
 }
 
 void OsdOmpComputeLoopVertexB(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, const int *V_IT, const float *V_W,
-    int vertexOffset, int tableOffset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int h = V_ITa[5*i];
-        int n = V_ITa[5*i+1];
-        int p = V_ITa[5*i+2];
-
-        float weight = V_W[i];
-        float wp = 1.0f/static_cast<float>(n);
-        float beta = 0.25f * cosf(static_cast<float>(M_PI) * 2.0f * wp) + 0.375f;
-        beta = beta * beta;
-        beta = (0.625f - beta) * wp;
-
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, p, weight * (1.0f - (beta * n)));
-
-        for (int j = 0; j < n; ++j)
-            vdesc.AddWithWeight(vertex, dstIndex, V_IT[h+j], weight * beta);
-
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+    const int *V_ITa, const int *V_IT, const float *V_W, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeLoopVertexB(vdesc, vertex, varying, V_ITa, V_IT, V_W,
+                                     offset, tableOffset, s, e);
     }
 }
 
 void OsdOmpComputeBilinearEdge(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *E_IT, int vertexOffset, int tableOffset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int eidx0 = E_IT[2*i+0];
-        int eidx1 = E_IT[2*i+1];
-
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
-
-        vdesc.AddWithWeight(vertex, dstIndex, eidx0, 0.5f);
-        vdesc.AddWithWeight(vertex, dstIndex, eidx1, 0.5f);
-
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx0, 0.5f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, eidx1, 0.5f);
+    const int *E_IT, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeBilinearEdge(vdesc, vertex, varying, E_IT,
+                                      offset, tableOffset, s, e);
     }
 }
 
 void OsdOmpComputeBilinearVertex(
     OsdVertexDescriptor const &vdesc, float *vertex, float *varying,
-    const int *V_ITa, int vertexOffset, int tableOffset, int start, int end) {
-
-#pragma omp parallel for
-    for (int i = start + tableOffset; i < end + tableOffset; i++) {
-        int p = V_ITa[i];
+    const int *V_ITa, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeBilinearVertex(vdesc, vertex, varying, V_ITa,
+                                        offset, tableOffset, s, e);
+    }
+}
 
-        int dstIndex = i + vertexOffset - tableOffset;
-        vdesc.Clear(vertex, varying, dstIndex);
+void OsdOmpComputeVertexStencils(
+    OsdVertexDescriptor const &vdesc, float *vertex,
+    const int *sizes, const int *offsets, const int *indices,
+    const float *weights, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeVertexStencils(vdesc, vertex, sizes, offsets, indices,
+                                        weights, offset, tableOffset, s, e);
+    }
+}
 
-        vdesc.AddWithWeight(vertex, dstIndex, p, 1.0f);
-        vdesc.AddVaryingWithWeight(varying, dstIndex, p, 1.0f);
+void OsdOmpComputeVaryingStencils(
+    OsdVertexDescriptor const &vdesc, float *varying,
+    const int *sizes, const int *offsets, const int *indices,
+    const float *weights, int offset, int tableOffset, int start, int end) {
+
+#pragma omp parallel
+    {
+        int s, e;
+        if (getThreadRange(start, end, &s, &e))
+            OsdCpuComputeVaryingStencils(vdesc, varying, sizes, offsets, indices,
+                                         weights, offset, tableOffset, s, e);
     }
 }
 
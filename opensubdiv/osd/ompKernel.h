@@ -107,6 +107,20 @@ void OsdOmpComputeBilinearVertex(OsdVertexDescriptor const &vdesc,
                                  int vertexOffset, int tableOffset,
                                  int start, int end);
 
+void OsdOmpComputeVertexStencils(OsdVertexDescriptor const &vdesc,
+                                 float *vertex,
+                                 const int *sizes, const int *offsets,
+                                 const int *indices, const float *weights,
+                                 int vertexOffset, int tableOffset,
+                                 int start, int end);
+
+void OsdOmpComputeVaryingStencils(OsdVertexDescriptor const &vdesc,
+                                  float *varying,
+                                  const int *sizes, const int *offsets,
+                                  const int *indices, const float *weights,
+                                  int vertexOffset, int tableOffset,
+                                  int start, int end);
+
 void OsdOmpEditVertexAdd(OsdVertexDescriptor const &vdesc, float *vertex,
                          int primVarOffset, int primVarWidth,
                          int vertexOffset, int tableOffset,
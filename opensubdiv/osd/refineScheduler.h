@@ -0,0 +1,201 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_REFINE_SCHEDULER_H
+#define OSD_REFINE_SCHEDULER_H
+
+#include "../version.h"
+
+#include "../osd/mesh.h"
+
+#include <pthread.h>
+#include <queue>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Refines many independent meshes in parallel.
+///
+/// Scenes made of thousands of small meshes (crowds) gain little from the
+/// threaded compute controllers, whose batches are too small to split. The
+/// scheduler instead runs the refinement of whole meshes on a set of worker
+/// threads : meshes are submitted every frame, and Barrier() waits for all of
+/// them at the end of the frame.
+///
+/// Each refinement comes with an estimate of its cost (the number of vertices
+/// times the number of primvar elements for a mesh). The pending refinements
+/// are run from the most to the least expensive one, so that the large meshes
+/// do not end the frame on a single thread while the others are idle.
+///
+/// The meshes submitted within a frame must not share compute contexts or
+/// vertex buffers, and their compute controller must accept concurrent calls
+/// to Refine() : the CPU compute controllers do, and complete their kernels
+/// before Refine() returns.
+///
+class OsdRefineScheduler {
+public:
+    /// \brief A refinement run by the scheduler.
+    class Job {
+    public:
+        virtual ~Job() { }
+
+        virtual void Run() = 0;
+    };
+
+    /// Constructor : starts the worker threads.
+    ///
+    /// @param numThreads  the number of threads running the jobs, including
+    ///                    the thread calling Barrier(). -1 uses all available
+    ///                    processors.
+    ///
+    explicit OsdRefineScheduler(int numThreads=-1);
+
+    /// Destructor : runs the pending jobs and joins the worker threads.
+    ~OsdRefineScheduler();
+
+    /// Queues 'job', which is deleted once it has run. The workers start it
+    /// as soon as they are free.
+    ///
+    /// @param job   the job to run
+    ///
+    /// @param cost  the estimated cost of the job, in any unit consistent
+    ///              across the jobs
+    ///
+    void Submit(Job * job, long long cost);
+
+    /// Queues the refinement of a mesh.
+    ///
+    /// @param mesh         the mesh to refine
+    ///
+    /// @param numElements  the number of primvar elements of its vertex buffer
+    ///
+    template <class DRAW_CONTEXT>
+    void Submit(OsdMeshInterface<DRAW_CONTEXT> * mesh, int numElements) {
+        Submit(new MeshJob<DRAW_CONTEXT>(mesh),
+               (long long)mesh->GetNumVertices() * numElements);
+    }
+
+    /// Blocks until all the jobs submitted so far have run (the end of a
+    /// frame). The calling thread runs pending jobs while it waits.
+    void Barrier();
+
+    /// Returns the number of jobs waiting or running
+    int GetNumPending() const;
+
+    /// Returns the number of threads running the jobs, including the thread
+    /// calling Barrier()
+    int GetNumThreads() const {
+        return (int)_threads.size() + 1;
+    }
+
+private:
+    // refines a mesh
+    template <class DRAW_CONTEXT>
+    class MeshJob : public Job {
+    public:
+        MeshJob(OsdMeshInterface<DRAW_CONTEXT> * mesh) : _mesh(mesh) { }
+
+        virtual void Run() {
+            _mesh->Refine();
+        }
+
+    private:
+        OsdMeshInterface<DRAW_CONTEXT> * _mesh;
+    };
+
+    // a job waiting for a thread
+    struct PendingJob {
+        long long cost,
+                  order;            // submission order, among equal costs
+        Job * job;
+
+        // the most expensive job comes first in the queue
+        bool operator < (PendingJob const & other) const {
+            return cost < other.cost or (cost == other.cost and order > other.order);
+        }
+    };
+
+    static void * threadMain(void * data);
+
+    // runs the queued jobs until the scheduler is destroyed
+    void threadLoop();
+
+    // runs a job taken from the queue, with _lock held (released meanwhile)
+    void run(Job * job);
+
+    std::vector<pthread_t> _threads;
+
+    mutable pthread_mutex_t _lock;  // guards the state below
+
+    pthread_cond_t _wake,           // signals a new job (or destruction)
+                   _done;           // signals that all the jobs have run
+
+    std::priority_queue<PendingJob> _jobs;
+
+    long long _submitted;           // number of jobs submitted so far
+
+    int _pending;                   // jobs queued or running
+
+    bool _quit;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_REFINE_SCHEDULER_H
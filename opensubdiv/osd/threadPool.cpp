@@ -0,0 +1,285 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../far/trace.h"
+#include "../osd/threadPool.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+#if defined(__linux__)
+    #include <sched.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+// A thread of the pool with its range of chunks [head, tail) : the owner
+// takes chunks from the head, the other threads steal them from the tail.
+struct OsdThreadPool::Worker {
+
+    Worker(OsdThreadPool * p, int i) : pool(p), index(i), head(0), tail(0) {
+        pthread_mutex_init(&lock, 0);
+    }
+
+    ~Worker() {
+        pthread_mutex_destroy(&lock);
+    }
+
+    OsdThreadPool * pool;
+    int index;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int head,
+        tail;
+};
+
+OsdThreadPool::OsdThreadPool(int numThreads, bool pinThreads) :
+    _task(0), _begin(0), _end(0), _grainSize(1), _generation(0), _active(0),
+    _remaining(0),
+    _steal(true), _pinThreads(pinThreads), _quit(false) {
+
+    if (numThreads < 1)
+        numThreads = GetNumProcessors();
+
+    pthread_mutex_init(&_loopLock, 0);
+    pthread_mutex_init(&_lock, 0);
+    pthread_cond_init(&_wake, 0);
+    pthread_cond_init(&_done, 0);
+
+    _workers.resize(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+        _workers[i] = new Worker(this, i);
+
+    for (int i = 1; i < numThreads; ++i)
+        pthread_create(&_workers[i]->thread, 0, workerMain, _workers[i]);
+}
+
+OsdThreadPool::~OsdThreadPool() {
+
+    pthread_mutex_lock(&_lock);
+    _quit = true;
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_lock);
+
+    for (int i = 1; i < (int)_workers.size(); ++i)
+        pthread_join(_workers[i]->thread, 0);
+
+    for (int i = 0; i < (int)_workers.size(); ++i)
+        delete _workers[i];
+
+    pthread_cond_destroy(&_done);
+    pthread_cond_destroy(&_wake);
+    pthread_mutex_destroy(&_lock);
+    pthread_mutex_destroy(&_loopLock);
+}
+
+int
+OsdThreadPool::GetNumProcessors() {
+
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+void *
+OsdThreadPool::workerMain(void * data) {
+
+    Worker * worker = static_cast<Worker *>(data);
+    worker->pool->workerLoop(worker->index);
+    return 0;
+}
+
+void
+OsdThreadPool::workerLoop(int index) {
+
+#if defined(__linux__)
+    if (_pinThreads) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % GetNumProcessors(), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+
+    int generation = 0;
+
+    pthread_mutex_lock(&_lock);
+    for (;;) {
+        while (not _quit and (_task == 0 or _generation == generation))
+            pthread_cond_wait(&_wake, &_lock);
+
+        if (_quit)
+            break;
+
+        generation = _generation;
+        ++_active;
+        pthread_mutex_unlock(&_lock);
+
+        int numChunks = run(index);
+
+        pthread_mutex_lock(&_lock);
+        _remaining -= numChunks;
+        if (--_active == 0 or _remaining == 0)
+            pthread_cond_signal(&_done);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+void
+OsdThreadPool::ParallelFor(Task const & task, int begin, int end, int grainSize,
+                           bool steal) {
+
+    if (end <= begin)
+        return;
+
+    grainSize = std::max(grainSize, 1);
+
+    int numThreads = (int)_workers.size(),
+        numChunks = (end - begin + grainSize - 1) / grainSize;
+
+    if (numThreads == 1 or numChunks == 1) {
+        task.Run(begin, end);
+        return;
+    }
+
+    pthread_mutex_lock(&_loopLock);
+
+    // each thread starts with a contiguous range of chunks
+    for (int i = 0; i < numThreads; ++i) {
+        Worker * worker = _workers[i];
+        pthread_mutex_lock(&worker->lock);
+        worker->head = (int)((long long)numChunks * i / numThreads);
+        worker->tail = (int)((long long)numChunks * (i + 1) / numThreads);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    pthread_mutex_lock(&_lock);
+    _task = &task;
+    _begin = begin;
+    _end = end;
+    _grainSize = grainSize;
+    _steal = steal;
+    _remaining = numChunks;
+    ++_generation;
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_lock);
+
+    numChunks = run(0);
+
+    // once the calling thread runs out of chunks, the remaining ones are
+    // being processed by active workers (or, without stealing, still wait
+    // for their worker to wake up)
+    pthread_mutex_lock(&_lock);
+    _remaining -= numChunks;
+    while (_active > 0 or _remaining > 0)
+        pthread_cond_wait(&_done, &_lock);
+    _task = 0;
+    pthread_mutex_unlock(&_lock);
+
+    pthread_mutex_unlock(&_loopLock);
+}
+
+int
+OsdThreadPool::run(int index) {
+
+    FAR_TRACE_SCOPE("OsdThreadPool::run", "thread");
+
+    int chunk, numChunks = 0;
+    while (takeChunk(index, chunk)) {
+        int start = _begin + chunk * _grainSize;
+        _task->Run(start, std::min(start + _grainSize, _end));
+        ++numChunks;
+    }
+    return numChunks;
+}
+
+bool
+OsdThreadPool::takeChunk(int index, int & chunk) {
+
+    Worker * worker = _workers[index];
+
+    pthread_mutex_lock(&worker->lock);
+    bool found = worker->head < worker->tail;
+    if (found)
+        chunk = worker->head++;
+    pthread_mutex_unlock(&worker->lock);
+
+    return found or (_steal and stealChunk(index, chunk));
+}
+
+bool
+OsdThreadPool::stealChunk(int index, int & chunk) {
+
+    int numThreads = (int)_workers.size();
+
+    for (int i = 1; i < numThreads; ++i) {
+        Worker * victim = _workers[(index + i) % numThreads];
+
+        pthread_mutex_lock(&victim->lock);
+        bool found = victim->head < victim->tail;
+        if (found)
+            chunk = --victim->tail;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
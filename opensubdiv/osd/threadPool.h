@@ -0,0 +1,177 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_THREAD_POOL_H
+#define OSD_THREAD_POOL_H
+
+#include "../version.h"
+
+#include <pthread.h>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Persistent pool of worker threads running parallel loops.
+///
+/// OsdThreadPool keeps its threads alive between loops, which avoids paying
+/// for a fork and join of the threads on every kernel batch. A loop is split
+/// into chunks of 'grainSize' iterations and each thread is given a contiguous
+/// range of chunks, which it processes in order. Threads that run out of work
+/// steal chunks from the end of the ranges of the other threads. The calling
+/// thread takes part in the loop.
+///
+class OsdThreadPool {
+public:
+    /// \brief Body of a parallel loop.
+    class Task {
+    public:
+        virtual ~Task() { }
+
+        /// Processes the iterations [start, end) of the loop. Called
+        /// concurrently from several threads on disjoint ranges.
+        virtual void Run(int start, int end) const = 0;
+    };
+
+    /// Constructor.
+    ///
+    /// @param numThreads  the number of threads running the loops, including
+    ///                    the calling thread. -1 uses all available processors.
+    ///
+    /// @param pinThreads  pins each worker thread to a processor (Linux only,
+    ///                    ignored elsewhere). The calling thread is not pinned.
+    ///
+    explicit OsdThreadPool(int numThreads=-1, bool pinThreads=false);
+
+    /// Destructor : joins the worker threads.
+    ~OsdThreadPool();
+
+    /// Returns the number of threads running the loops
+    int GetNumThreads() const {
+        return (int)_workers.size();
+    }
+
+    /// Runs 'task' over the iterations [begin, end) and returns once they are
+    /// all complete. Loops of a single chunk run on the calling thread without
+    /// waking the workers. Loops launched from several threads are serialized.
+    ///
+    /// @param task       the body of the loop
+    ///
+    /// @param begin      the first iteration
+    ///
+    /// @param end        the iteration past the last one
+    ///
+    /// @param grainSize  the number of iterations in a chunk
+    ///
+    /// @param steal      lets the threads that run out of chunks take those of
+    ///                   the other threads. Without stealing, thread 'i' runs
+    ///                   exactly the chunks [i * n / t, (i+1) * n / t) of the
+    ///                   n chunks of the loop (t threads), so that loops over
+    ///                   the same range always give the same iterations to the
+    ///                   same thread.
+    ///
+    void ParallelFor(Task const & task, int begin, int end, int grainSize,
+                     bool steal=true);
+
+    /// Returns the number of processors available to the process
+    static int GetNumProcessors();
+
+private:
+    struct Worker;
+
+    static void * workerMain(void * data);
+
+    // waits for loops and runs them until the pool is destroyed
+    void workerLoop(int index);
+
+    // runs chunks of the current loop until there is none left to take,
+    // returns the number of chunks run
+    int run(int index);
+
+    // takes the next chunk of the range of a thread, or steals the last chunk
+    // of another thread
+    bool takeChunk(int index, int & chunk);
+
+    bool stealChunk(int index, int & chunk);
+
+    std::vector<Worker *> _workers; // _workers[0] is the calling thread
+
+    pthread_mutex_t _loopLock,      // serializes ParallelFor
+                    _lock;          // guards the state below
+
+    pthread_cond_t _wake,           // signals a new loop (or destruction)
+                   _done;           // signals the end of the workers
+
+    Task const * _task;
+
+    int _begin,
+        _end,
+        _grainSize,
+        _generation,                // incremented for each loop
+        _active,                    // workers running the current loop
+        _remaining;                 // chunks of the current loop not run yet
+
+    bool _steal,                    // threads steal chunks in the current loop
+         _pinThreads,
+         _quit;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_THREAD_POOL_H
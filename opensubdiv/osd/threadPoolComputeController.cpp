@@ -0,0 +1,456 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+
+#include "../osd/cpuComputeContext.h"
+#include "../osd/threadPoolComputeController.h"
+#include "../osd/cpuSimdKernel.h"
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+    #include "../far/kernelStats.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace {
+
+// Runs a CPU kernel over a chunk of the vertices of a batch
+class KernelTask : public OsdThreadPool::Task {
+public:
+    typedef void (OsdCpuComputeController::*Kernel)(FarKernelBatch const &, void *) const;
+
+    KernelTask(OsdCpuComputeController const * controller, Kernel kernel,
+               FarKernelBatch const & batch, void * clientdata) :
+        _controller(controller), _kernel(kernel), _batch(batch), _clientdata(clientdata) { }
+
+    virtual void Run(int start, int end) const {
+        FarKernelBatch chunk(_batch.GetKernelType(),
+                             _batch.GetLevel(),
+                             _batch.GetTableIndex(),
+                             start,
+                             end,
+                             _batch.GetTableOffset(),
+                             _batch.GetVertexOffset(),
+                             _batch.GetMeshIndex());
+        (_controller->*_kernel)(chunk, _clientdata);
+    }
+
+private:
+    OsdCpuComputeController const * _controller;
+    Kernel _kernel;
+    FarKernelBatch const & _batch;
+    void * _clientdata;
+};
+
+// Runs the chunks of the batches of a graph wave
+class WaveTask : public OsdThreadPool::Task {
+public:
+    // a range of vertices of a batch
+    struct Chunk {
+        int batch, start, end;
+    };
+
+    WaveTask(OsdCpuComputeController const * controller, FarKernelBatchVector const & batches,
+             std::vector<Chunk> const & chunks, void * clientdata) :
+        _controller(controller), _batches(batches), _chunks(chunks), _clientdata(clientdata) { }
+
+    virtual void Run(int start, int end) const {
+        for (int i = start; i < end; ++i) {
+            Chunk const & chunk = _chunks[i];
+            FarKernelBatch const & batch = _batches[chunk.batch];
+            FarDispatcher::ApplyKernel(_controller,
+                                       FarKernelBatch(batch.GetKernelType(),
+                                                      batch.GetLevel(),
+                                                      batch.GetTableIndex(),
+                                                      chunk.start,
+                                                      chunk.end,
+                                                      batch.GetTableOffset(),
+                                                      batch.GetVertexOffset(),
+                                                      batch.GetMeshIndex()),
+                                       _clientdata);
+        }
+    }
+
+private:
+    OsdCpuComputeController const * _controller;
+    FarKernelBatchVector const & _batches;
+    std::vector<Chunk> const & _chunks;
+    void * _clientdata;
+};
+
+// Applies a chunk of the stencils of a batch
+class StencilTask : public OsdThreadPool::Task {
+public:
+    StencilTask(OsdCpuComputeContext const * context, FarStencilTables const * stencils,
+                FarStencilBatch const & batch, bool varying, bool streaming) :
+        _context(context), _stencils(stencils), _batch(batch),
+        _varying(varying), _streaming(streaming) { }
+
+    virtual void Run(int start, int end) const {
+        if (_varying) {
+            _context->GetKernelBundle()->computeVaryingStencils(
+                _context->GetVertexDescriptor(),
+                _context->GetCurrentVaryingData(),
+                &_stencils->GetSizes()[0],
+                &_stencils->GetOffsets()[0],
+                &_stencils->GetIndices()[0],
+                &_stencils->GetWeights()[0],
+                _batch.GetVertexOffset(), _batch.GetTableOffset(),
+                start, end, _streaming);
+        } else {
+            _context->GetKernelBundle()->computeVertexStencils(
+                _context->GetVertexDescriptor(),
+                _context->GetCurrentVertexData(),
+                &_stencils->GetSizes()[0],
+                &_stencils->GetOffsets()[0],
+                &_stencils->GetIndices()[0],
+                &_stencils->GetWeights()[0],
+                _batch.GetVertexOffset(), _batch.GetTableOffset(),
+                start, end, _streaming);
+        }
+    }
+
+private:
+    OsdCpuComputeContext const * _context;
+    FarStencilTables const * _stencils;
+    FarStencilBatch const & _batch;
+    bool _varying,
+         _streaming;
+};
+
+// Clears a range of vertices of a buffer
+class ClearTask : public OsdThreadPool::Task {
+public:
+    ClearTask(void * buffer, int vertexSize) :
+        _buffer(static_cast<char *>(buffer)), _vertexSize(vertexSize) { }
+
+    virtual void Run(int start, int end) const {
+        memset(_buffer + (size_t)start * _vertexSize, 0,
+               (size_t)(end - start) * _vertexSize);
+    }
+
+private:
+    char * _buffer;
+    int _vertexSize;
+};
+
+} // end anonymous namespace
+
+OsdThreadPoolComputeController::OsdThreadPoolComputeController(
+    int numThreads, int grainSize, bool pinThreads) :
+    _threadPool(new OsdThreadPool(numThreads, pinThreads)),
+    _grainSize(grainSize > 0 ? grainSize : 1),
+    _streamingStores(false),
+    _partitioned(false) {
+}
+
+OsdThreadPoolComputeController::~OsdThreadPoolComputeController() {
+
+    delete _threadPool;
+}
+
+void
+OsdThreadPoolComputeController::parallelApply(
+    Kernel kernel, FarKernelBatch const &batch, void * clientdata) const {
+
+    KernelTask task(&_cpuController, kernel, batch, clientdata);
+
+    if (_partitioned) {
+        _threadPool->ParallelFor(task, batch.GetStart(), batch.GetEnd(),
+                                 getPartitionSize(batch.GetEnd() - batch.GetStart()), false);
+    } else {
+        _threadPool->ParallelFor(task, batch.GetStart(), batch.GetEnd(), _grainSize);
+    }
+}
+
+int
+OsdThreadPoolComputeController::getPartitionSize(int numVertices) const {
+
+    int numThreads = _threadPool->GetNumThreads();
+    return std::max(_grainSize, (numVertices + numThreads - 1) / numThreads);
+}
+
+void
+OsdThreadPoolComputeController::distribute(
+    FarKernelBatchVector const & batches, void * buffer, int vertexSize, int numVertices) const {
+
+    // the refined vertices, split as the partitioned batches
+    int numCoarseVertices = numVertices;
+    for (int i = 0; i < (int)batches.size(); ++i) {
+
+        FarKernelBatch const & batch = batches[i];
+        if (batch.GetKernelType() == FarKernelBatch::HIERARCHICAL_EDIT or
+            batch.GetEnd() <= batch.GetStart())
+            continue;
+
+        int start = batch.GetVertexOffset() + batch.GetStart();
+        numCoarseVertices = std::min(numCoarseVertices, start);
+
+        ClearTask task(static_cast<char *>(buffer) + (size_t)batch.GetVertexOffset() * vertexSize,
+                       vertexSize);
+        _threadPool->ParallelFor(task, batch.GetStart(), batch.GetEnd(),
+                                 getPartitionSize(batch.GetEnd() - batch.GetStart()), false);
+    }
+
+    // the coarse vertices are read by all the threads
+    ClearTask task(buffer, vertexSize);
+    _threadPool->ParallelFor(task, 0, numCoarseVertices,
+                             getPartitionSize(numCoarseVertices), false);
+}
+
+void
+OsdThreadPoolComputeController::refineWaves(
+    OsdCpuComputeContext *context, FarKernelBatchGraph const & graph) const {
+
+    assert(context);
+
+    FarKernelBatchVector const & batches = graph.GetBatches();
+
+    std::vector<WaveTask::Chunk> chunks;
+
+    for (int wave = 0; wave < graph.GetNumWaves(); ++wave) {
+
+        // split the batches of the wave into chunks of vertices : several
+        // edits can apply to the same vertex, their batches are not split
+        chunks.clear();
+
+        int const * waveBatches = graph.GetWaveBatches(wave);
+        for (int i = 0; i < graph.GetNumWaveBatches(wave); ++i) {
+
+            FarKernelBatch const & batch = batches[waveBatches[i]];
+
+            int grainSize = batch.GetKernelType() == FarKernelBatch::HIERARCHICAL_EDIT ?
+                batch.GetEnd() - batch.GetStart() : _grainSize;
+
+            for (int start = batch.GetStart(); start < batch.GetEnd(); start += grainSize) {
+                WaveTask::Chunk chunk = { waveBatches[i], start,
+                                          std::min(start + grainSize, batch.GetEnd()) };
+                chunks.push_back(chunk);
+            }
+        }
+
+        WaveTask task(&_cpuController, batches, chunks, context);
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+        // the batches of a wave run concurrently : the time of the wave is
+        // shared between its batches in proportion to their vertices
+        if (FarKernelStats * stats = FarKernelStats::GetCurrent()) {
+
+            double start = FarKernelStats::GetTime();
+
+            _threadPool->ParallelFor(task, 0, (int)chunks.size(), 1);
+
+            double seconds = FarKernelStats::GetTime() - start;
+
+            int numVertices = 0;
+            for (int i = 0; i < graph.GetNumWaveBatches(wave); ++i) {
+                FarKernelBatch const & batch = batches[waveBatches[i]];
+                numVertices += batch.GetEnd() - batch.GetStart();
+            }
+            for (int i = 0; i < graph.GetNumWaveBatches(wave); ++i) {
+                FarKernelBatch const & batch = batches[waveBatches[i]];
+                stats->Record(batch, numVertices ?
+                    seconds * (batch.GetEnd() - batch.GetStart()) / numVertices : 0.0);
+            }
+            continue;
+        }
+#endif
+
+        _threadPool->ParallelFor(task, 0, (int)chunks.size(), 1);
+    }
+}
+
+void
+OsdThreadPoolComputeController::applyStencils(
+    OsdCpuComputeContext *context,
+    FarStencilTables const * vertexStencils,
+    FarStencilTables const * varyingStencils) const {
+
+    assert(context and vertexStencils);
+
+    FarStencilBatchVector const & batches = vertexStencils->GetBatches();
+
+    // both tables are generated from the same mesh : their batches match
+    assert(not varyingStencils or
+           varyingStencils->GetBatches().size() == batches.size());
+
+    for (int i = 0; i < (int)batches.size(); ++i) {
+
+        FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType() == FarStencilBatch::HIERARCHICAL_EDIT) {
+            ApplyVertexEdits(batch.GetEditBatch(), context);
+            continue;
+        }
+
+        bool streaming = batch.GetLevel() == context->GetStreamingLevel();
+
+        StencilTask vertexTask(context, vertexStencils, batch, false, streaming);
+        _threadPool->ParallelFor(vertexTask, batch.GetStart(), batch.GetEnd(), _grainSize);
+
+        if (varyingStencils and context->GetCurrentVaryingData()) {
+            FarStencilBatch const & ybatch = varyingStencils->GetBatches()[i];
+            StencilTask varyingTask(context, varyingStencils, ybatch, true, streaming);
+            _threadPool->ParallelFor(varyingTask, ybatch.GetStart(), ybatch.GetEnd(), _grainSize);
+        }
+    }
+}
+
+void
+OsdThreadPoolComputeController::ApplyBilinearFaceVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyBilinearFaceVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyBilinearEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyBilinearEdgeVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyBilinearVertexVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyBilinearVertexVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyCatmarkFaceVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyCatmarkFaceVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyCatmarkEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyCatmarkEdgeVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyCatmarkVertexVerticesKernelB(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelB, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyCatmarkVertexVerticesKernelA1(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelA1, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyCatmarkVertexVerticesKernelA2(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyCatmarkVertexVerticesKernelA2, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyLoopEdgeVerticesKernel(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyLoopEdgeVerticesKernel, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyLoopVertexVerticesKernelB(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyLoopVertexVerticesKernelB, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyLoopVertexVerticesKernelA1(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyLoopVertexVerticesKernelA1, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyLoopVertexVerticesKernelA2(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    parallelApply(&OsdCpuComputeController::ApplyLoopVertexVerticesKernelA2, batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::ApplyVertexEdits(
+    FarKernelBatch const &batch, void * clientdata) const {
+
+    // several edits can apply to the same vertex : they run in sequence
+    _cpuController.ApplyVertexEdits(batch, clientdata);
+}
+
+void
+OsdThreadPoolComputeController::Synchronize() {
+    // the kernels are complete when Refine returns
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
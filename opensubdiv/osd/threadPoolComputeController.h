@@ -0,0 +1,584 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_THREAD_POOL_COMPUTE_CONTROLLER_H
+#define OSD_THREAD_POOL_COMPUTE_CONTROLLER_H
+
+#include "../version.h"
+
+#include "../far/dispatcher.h"
+#include "../far/kernelBatchGraph.h"
+#include "../far/stencilTables.h"
+#include "../osd/cpuComputeContext.h"
+#include "../osd/cpuComputeController.h"
+#include "../osd/threadPool.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Compute controller for launching threaded CPU subdivision kernels
+/// on a persistent pool of threads.
+///
+/// OsdThreadPoolComputeController splits every batch of kernels into chunks
+/// of vertices that run on the threads of an OsdThreadPool. The threads are
+/// created once with the controller, so small batches do not pay for a fork
+/// and join of the threads, and batches smaller than two chunks run directly
+/// on the calling thread. The chunks are processed by the kernels of
+/// OsdCpuComputeController, so the controller supports the same vertex
+/// buffers (including half precision ones) and instruction sets. It does not
+/// require OpenMP.
+///
+/// On NUMA systems, a partitioned controller with pinned threads keeps the
+/// refined vertices of each thread on its node : see SetPartitioned() and
+/// DistributeVertexBuffer().
+///
+/// Controller entities execute requests from Context instances that they share
+/// common interfaces with. Controllers are attached to discrete compute devices
+/// and share the devices resources with Context entities.
+///
+class OsdThreadPoolComputeController {
+public:
+    typedef OsdCpuComputeContext ComputeContext;
+
+    /// Constructor.
+    ///
+    /// @param numThreads  the number of threads running the kernels, including
+    ///                    the calling thread. -1 uses all available processors.
+    ///
+    /// @param grainSize   the number of vertices computed by a thread in one go
+    ///
+    /// @param pinThreads  pins each worker thread to a processor (Linux only)
+    ///
+    explicit OsdThreadPoolComputeController(int numThreads=-1,
+                                            int grainSize=256,
+                                            bool pinThreads=false);
+
+    /// Destructor.
+    ~OsdThreadPoolComputeController();
+
+    /// Launch subdivision kernels and apply to given vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(batches));
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to given vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers. The plan is compiled once from the kernel batches of
+    /// the mesh, which saves the per-batch dispatch of repeated refinements.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(plan.GetFinestLevel());
+        FarDispatcher::Refine(this, plan, context);
+        context->Unbind();
+    }
+
+    /// Launch the subdivision kernels of a refine plan and apply to given
+    /// vertex buffers.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  plan          the kernel batches compiled by FarRefinePlan
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarRefinePlan const & plan,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, plan, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels and apply to the elements of given vertex
+    /// buffers described by buffer descriptors.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer (can be the same
+    ///                       as vertexBuffer)
+    ///
+    /// @param  varyingDesc   the varying-interpolated elements in varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER *varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(batches));
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to the elements of a given vertex
+    /// buffer described by a buffer descriptor.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc) {
+        Refine(context, batches, vertexBuffer, vertexDesc,
+               (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+    }
+
+    /// Launch subdivision kernels and apply to given vertex buffers, the
+    /// independent batches of each wave of the graph running concurrently
+    /// (see FarKernelBatchGraph). The threads only synchronize between the
+    /// waves, instead of after every batch : the batches of the meshes spliced
+    /// by FarMultiMeshFactory run side by side.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  graph         dependency graph of the batches of vertices
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchGraph const & graph,
+                VERTEX_BUFFER *vertexBuffer,
+                VARYING_BUFFER *varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(graph.GetBatches()));
+        refineWaves(context, graph);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels and apply to given vertex buffers, the
+    /// independent batches of each wave of the graph running concurrently.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  graph         dependency graph of the batches of vertices
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchGraph const & graph,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, graph, vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Launch subdivision kernels and apply to the elements of given vertex
+    /// buffers described by buffer descriptors, the independent batches of
+    /// each wave of the graph running concurrently.
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  graph         dependency graph of the batches of vertices
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer varying-interpolated data buffer (can be the same
+    ///                       as vertexBuffer)
+    ///
+    /// @param  varyingDesc   the varying-interpolated elements in varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchGraph const & graph,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER *varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(graph.GetBatches()));
+        refineWaves(context, graph);
+        context->Unbind();
+    }
+
+    /// Launch subdivision kernels on several samples of the vertex-interpolated
+    /// primvars interleaved in a vertex buffer (see
+    /// OsdCpuComputeController::Refine).
+    ///
+    /// @param  context       the OsdCpuContext to apply refinement operations to
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc    the elements of the first sample in vertexBuffer
+    ///
+    /// @param  numSamples    the number of samples in each vertex
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarKernelBatchVector const & batches,
+                VERTEX_BUFFER *vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                int numSamples) {
+
+        context->BindSamples(vertexBuffer, vertexDesc, numSamples,
+                             (VERTEX_BUFFER*)0, OsdVertexBufferDescriptor());
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(batches));
+        FarDispatcher::Refine(this,
+                              batches,
+                              -1,
+                              context);
+        context->Unbind();
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data (see
+    ///                         FarStencilTablesFactory)
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                VARYING_BUFFER * varyingBuffer) {
+
+        context->Bind(vertexBuffer, varyingBuffer);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(vertexStencils->GetBatches()));
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
+    /// Apply refinement stencils to given vertex buffers.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                VERTEX_BUFFER *vertexBuffer) {
+        Refine(context, vertexStencils, (FarStencilTables const *)0,
+               vertexBuffer, (VERTEX_BUFFER*)0);
+    }
+
+    /// Apply refinement stencils to the elements of given vertex buffers
+    /// described by buffer descriptors.
+    ///
+    /// @param  context         the OsdCpuContext holding the hierarchical edits
+    ///                         of the mesh
+    ///
+    /// @param  vertexStencils  stencils of the vertex-interpolated data
+    ///
+    /// @param  varyingStencils stencils of the varying-interpolated data (can
+    ///                         be NULL if there is no varying buffer)
+    ///
+    /// @param  vertexBuffer    vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc      the vertex-interpolated elements in vertexBuffer
+    ///
+    /// @param  varyingBuffer   varying-interpolated data buffer (can be the
+    ///                         same as vertexBuffer)
+    ///
+    /// @param  varyingDesc     the varying-interpolated elements in
+    ///                         varyingBuffer
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+    void Refine(OsdCpuComputeContext *context,
+                FarStencilTables const * vertexStencils,
+                FarStencilTables const * varyingStencils,
+                VERTEX_BUFFER * vertexBuffer,
+                OsdVertexBufferDescriptor const & vertexDesc,
+                VARYING_BUFFER * varyingBuffer,
+                OsdVertexBufferDescriptor const & varyingDesc) {
+
+        context->Bind(vertexBuffer, vertexDesc, varyingBuffer, varyingDesc);
+        if (_streamingStores)
+            context->SetStreamingLevel(OsdCpuComputeController::getFinestLevel(vertexStencils->GetBatches()));
+        applyStencils(context, vertexStencils, varyingStencils);
+        context->Unbind();
+    }
+
+    /// Places the pages of a vertex buffer allocated with
+    /// OsdCpuVertexBuffer::ALLOCATE_PAGES on the NUMA nodes of the threads
+    /// of a partitioned controller : the vertices of each batch are written
+    /// (cleared) by the thread that refines them, and the coarse vertices
+    /// are spread evenly across the threads. Must be called before the
+    /// buffer is first written to, with pinned threads (the calling thread,
+    /// which runs the first partition, should be pinned by the application).
+    ///
+    /// Ordering the refined vertices for locality (see
+    /// FarMeshFactory::SetLocalityOrdering) also keeps most of the vertices
+    /// gathered by a thread in its partition of the previous level.
+    ///
+    /// @param  batches       vector of batches of vertices organized by operative 
+    ///                       kernel
+    ///
+    /// @param  vertexBuffer  vertex-interpolated data buffer
+    ///
+    template<class VERTEX_BUFFER>
+    void DistributeVertexBuffer(FarKernelBatchVector const & batches,
+                                VERTEX_BUFFER *vertexBuffer) {
+
+        distribute(batches, vertexBuffer->BindCpuBuffer(),
+                   vertexBuffer->GetNumElements() * sizeof(*vertexBuffer->BindCpuBuffer()),
+                   vertexBuffer->GetNumVertices());
+    }
+
+    /// Waits until all running subdivision kernels finish.
+    void Synchronize();
+
+    /// Returns the number of threads running the kernels
+    int GetNumThreads() const {
+        return _threadPool->GetNumThreads();
+    }
+
+    /// Sets the number of vertices computed by a thread in one go : smaller
+    /// grains balance the load better, larger ones cost less scheduling.
+    void SetGrainSize(int grainSize) {
+        _grainSize = grainSize > 0 ? grainSize : 1;
+    }
+
+    /// Returns the number of vertices computed by a thread in one go
+    int GetGrainSize() const {
+        return _grainSize;
+    }
+
+    /// Enables non-temporal stores for the vertices of the finest level (see
+    /// OsdCpuComputeController::SetStreamingStores). Disabled by default.
+    void SetStreamingStores(bool enable) {
+        _streamingStores = enable;
+    }
+
+    /// Returns true if the finest level is written with non-temporal stores
+    bool GetStreamingStores() const {
+        return _streamingStores;
+    }
+
+    /// Partitions the batches refined by Refine() : each batch is split into
+    /// one range of vertices per thread (no smaller than the grain size), and
+    /// the threads do not steal the ranges of the others. Every refinement
+    /// then writes each vertex from the same thread, which keeps the pages
+    /// placed by DistributeVertexBuffer() local to their thread. Disabled by
+    /// default (the graph waves and the stencils are not partitioned).
+    void SetPartitioned(bool enable) {
+        _partitioned = enable;
+    }
+
+    /// Returns true if the batches are partitioned across the threads
+    bool GetPartitioned() const {
+        return _partitioned;
+    }
+
+protected:
+    // applies the stencil batches and hierarchical edits in sequence, the
+    // stencils of each batch being split across the threads
+    void applyStencils(OsdCpuComputeContext *context,
+                       FarStencilTables const * vertexStencils,
+                       FarStencilTables const * varyingStencils) const;
+
+    // runs the waves of the graph in sequence, the chunks of the batches of a
+    // wave being spread across the threads
+    void refineWaves(OsdCpuComputeContext *context,
+                     FarKernelBatchGraph const & graph) const;
+
+    friend class FarDispatcher;
+    void ApplyBilinearFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyBilinearEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyBilinearVertexVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyCatmarkFaceVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelB(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelA1(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyCatmarkVertexVerticesKernelA2(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyLoopEdgeVerticesKernel(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelB(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelA1(FarKernelBatch const &batch, void * clientdata) const;
+
+    void ApplyLoopVertexVerticesKernelA2(FarKernelBatch const &batch, void * clientdata) const;
+
+
+    void ApplyVertexEdits(FarKernelBatch const &batch, void * clientdata) const;
+
+private:
+    typedef void (OsdCpuComputeController::*Kernel)(FarKernelBatch const &, void *) const;
+
+    // runs a CPU kernel over the vertices of a batch, split across the threads
+    void parallelApply(Kernel kernel, FarKernelBatch const &batch, void * clientdata) const;
+
+    // returns the number of vertices of the chunks of a partitioned batch
+    int getPartitionSize(int numVertices) const;
+
+    // clears the vertices of a buffer from the threads that refine them
+    void distribute(FarKernelBatchVector const & batches, void * buffer,
+                    int vertexSize, int numVertices) const;
+
+    OsdCpuComputeController _cpuController; // computes the chunks of vertices
+
+    OsdThreadPool * _threadPool;
+
+    int _grainSize;
+
+    bool _streamingStores,
+         _partitioned;
+};
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_THREAD_POOL_COMPUTE_CONTROLLER_H
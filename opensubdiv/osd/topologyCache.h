@@ -0,0 +1,485 @@
+//
+//     Copyright (C) Pixar. All rights reserved.
+//
+//     This license governs use of the accompanying software. If you
+//     use the software, you accept this license. If you do not accept
+//     the license, do not use the software.
+//
+//     1. Definitions
+//     The terms "reproduce," "reproduction," "derivative works," and
+//     "distribution" have the same meaning here as under U.S.
+//     copyright law.  A "contribution" is the original software, or
+//     any additions or changes to the software.
+//     A "contributor" is any person or entity that distributes its
+//     contribution under this license.
+//     "Licensed patents" are a contributor's patent claims that read
+//     directly on its contribution.
+//
+//     2. Grant of Rights
+//     (A) Copyright Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free copyright license to reproduce its contribution,
+//     prepare derivative works of its contribution, and distribute
+//     its contribution or any derivative works that you create.
+//     (B) Patent Grant- Subject to the terms of this license,
+//     including the license conditions and limitations in section 3,
+//     each contributor grants you a non-exclusive, worldwide,
+//     royalty-free license under its licensed patents to make, have
+//     made, use, sell, offer for sale, import, and/or otherwise
+//     dispose of its contribution in the software or derivative works
+//     of the contribution in the software.
+//
+//     3. Conditions and Limitations
+//     (A) No Trademark License- This license does not grant you
+//     rights to use any contributor's name, logo, or trademarks.
+//     (B) If you bring a patent claim against any contributor over
+//     patents that you claim are infringed by the software, your
+//     patent license from such contributor to the software ends
+//     automatically.
+//     (C) If you distribute any portion of the software, you must
+//     retain all copyright, patent, trademark, and attribution
+//     notices that are present in the software.
+//     (D) If you distribute any portion of the software in source
+//     code form, you may do so only under this license by including a
+//     complete copy of this license with your distribution. If you
+//     distribute any portion of the software in compiled or object
+//     code form, you may only do so under a license that complies
+//     with this license.
+//     (E) The software is licensed "as-is." You bear the risk of
+//     using it. The contributors give no express warranties,
+//     guarantees or conditions. You may have additional consumer
+//     rights under your local laws which this license cannot change.
+//     To the extent permitted under your local laws, the contributors
+//     exclude the implied warranties of merchantability, fitness for
+//     a particular purpose and non-infringement.
+//
+#ifndef OSD_TOPOLOGY_CACHE_H
+#define OSD_TOPOLOGY_CACHE_H
+
+#include "../version.h"
+
+#include "../far/mesh.h"
+#include "../far/meshFactory.h"
+#include "../far/meshSerializer.h"
+
+#include "../hbr/mesh.h"
+#include "../hbr/bilinear.h"
+#include "../hbr/catmark.h"
+#include "../hbr/loop.h"
+#include "../hbr/cornerEdit.h"
+#include "../hbr/creaseEdit.h"
+#include "../hbr/faceEdit.h"
+#include "../hbr/holeEdit.h"
+#include "../hbr/vertexEdit.h"
+
+#include "../osd/cpuComputeContext.h"
+#include "../osd/vertex.h"
+
+#include <cassert>
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+/// \brief Shares the FarMeshes and compute contexts of identical topologies.
+///
+/// Scenes instancing the same topology many times (props, crowd agents) pay
+/// for a FarMesh and a compute context per instance. The cache instead keys
+/// the refined topology by the content of the coarse HbrMesh (scheme,
+/// triangle and crease subdivision methods, boundary interpolation,
+/// face-vertex indices, holes, edge and vertex sharpness and hierarchical
+/// edits) along with the level of refinement and the adaptive flag, and hands
+/// out a single reference counted FarMesh and compute context per key :
+/// memory and construction time then scale with the number of unique
+/// topologies rather than with the number of instances.
+/// The CPU compute contexts reference the tables of their cached mesh rather
+/// than copying them.
+///
+/// With a cache directory, the meshes are also saved to and loaded from
+/// '<directory>/<hash>.far' images (see FarMeshSerializer), so that a
+/// topology is only ever built once across runs. The key of each image is
+/// saved next to it ('<hash>.key') and compared before loading it. A loaded
+/// image is mapped in memory, and referenced in place by the subdivision
+/// tables of its mesh and by the shared CPU compute context.
+///
+/// Face-varying data is not part of the key : meshes requiring it should be
+/// created with FarMeshFactory directly.
+///
+/// The cache is not thread safe. A shared compute context binds the vertex
+/// buffers of the refinement in progress, so the instances sharing it must
+/// not be refined concurrently.
+///
+template <class COMPUTE_CONTEXT=OsdCpuComputeContext>
+class OsdTopologyCache {
+
+public:
+    typedef COMPUTE_CONTEXT ComputeContext;
+
+    /// Constructor
+    ///
+    /// @param directory  the directory of the on-disk cache, NULL to only
+    ///                   share the meshes within the process
+    ///
+    explicit OsdTopologyCache(char const * directory=0) {
+        if (directory)
+            _directory = directory;
+    }
+
+    /// Destructor : deletes the meshes and contexts still referenced
+    ~OsdTopologyCache();
+
+    /// Returns the mesh refining 'hmesh', creating it on the first request
+    /// of its topology. Each call adds a reference to the mesh, which must be
+    /// released with Release().
+    ///
+    /// @param hmesh     a finalized HbrMesh, not refined yet
+    ///
+    /// @param level     the maximum level of subdivision
+    ///
+    /// @param adaptive  creates a feature-adaptive mesh
+    ///
+    FarMesh<OsdVertex> const * AcquireMesh(HbrMesh<OsdVertex> * hmesh,
+                                           int level, bool adaptive=false);
+
+    /// Returns the compute context shared by the references to 'mesh',
+    /// created on the first request.
+    ///
+    /// @param mesh  a mesh returned by AcquireMesh()
+    ///
+    ComputeContext * GetComputeContext(FarMesh<OsdVertex> const * mesh);
+
+    /// Releases a reference to 'mesh' : the mesh and its compute context are
+    /// deleted along with the last reference.
+    void Release(FarMesh<OsdVertex> const * mesh);
+
+    /// Returns the number of unique topologies in the cache
+    int GetNumMeshes() const {
+        return (int)_entries.size();
+    }
+
+    /// Returns the number of references to 'mesh'
+    int GetNumReferences(FarMesh<OsdVertex> const * mesh) const;
+
+    /// Returns the key of the topology of a mesh, as the content it hashes
+    static std::string ComputeKey(HbrMesh<OsdVertex> const * hmesh,
+                                  int level, bool adaptive);
+
+    /// Returns the 64 bits FNV-1a hash of a key, used to name its image in
+    /// the cache directory
+    static unsigned long long Hash(std::string const & key);
+
+private:
+    struct Entry {
+        Entry() : mesh(0), context(0), references(0) { }
+
+        FarMesh<OsdVertex> * mesh;
+        ComputeContext * context;
+        int references;
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+
+    template <class T> static void append(std::string & key, T value) {
+        key.append(reinterpret_cast<char const *>(&value), sizeof(T));
+    }
+
+    static void appendEdit(std::string & key, HbrHierarchicalEdit<OsdVertex> const * edit);
+
+    template <class EDIT> static void appendVertexEdit(std::string & key, char type, EDIT const * edit) {
+        append(key, type);
+        append(key, edit->GetFaceID());
+        append(key, edit->GetNSubfaces());
+        for (int i=0; i<edit->GetNSubfaces(); ++i)
+            append(key, edit->GetSubface(i));
+        append(key, edit->GetVertexID());
+        append(key, edit->GetIndex());
+        append(key, edit->GetWidth());
+        append(key, (int)edit->GetOperation());
+        for (int i=0; i<edit->GetWidth(); ++i)
+            append(key, edit->GetEdit()[i]);
+    }
+
+    template <class CONTEXT> static CONTEXT * createComputeContext(
+        FarMesh<OsdVertex> const * mesh, CONTEXT *) {
+        return CONTEXT::Create(mesh);
+    }
+
+    // the cached meshes outlive their context : the CPU contexts reference
+    // their tables rather than copying them
+    static OsdCpuComputeContext * createComputeContext(
+        FarMesh<OsdVertex> const * mesh, OsdCpuComputeContext *) {
+        return OsdCpuComputeContext::Create(mesh, OsdCpuComputeContext::TABLES_SHARED);
+    }
+
+    typename EntryMap::iterator find(FarMesh<OsdVertex> const * mesh);
+
+    typename EntryMap::const_iterator find(FarMesh<OsdVertex> const * mesh) const;
+
+    // returns the path of the image of a key in the cache directory, without
+    // extension
+    std::string getPath(std::string const & key) const;
+
+    static std::string readKey(std::string const & path);
+
+    static void writeKey(std::string const & path, std::string const & key);
+
+    std::string _directory;
+
+    EntryMap _entries;  // the entries, by topology key
+};
+
+template <class COMPUTE_CONTEXT>
+OsdTopologyCache<COMPUTE_CONTEXT>::~OsdTopologyCache() {
+
+    for (typename EntryMap::iterator it=_entries.begin(); it!=_entries.end(); ++it) {
+        delete it->second.context;
+        delete it->second.mesh;
+    }
+}
+
+template <class COMPUTE_CONTEXT> FarMesh<OsdVertex> const *
+OsdTopologyCache<COMPUTE_CONTEXT>::AcquireMesh(HbrMesh<OsdVertex> * hmesh,
+                                               int level, bool adaptive) {
+    assert(hmesh);
+
+    std::string key = ComputeKey(hmesh, level, adaptive);
+
+    Entry & entry = _entries[key];
+
+    if (not entry.mesh) {
+        // the key of the image is saved next to it, and compared before
+        // loading the image in case of a collision of the hashes
+        std::string path = getPath(key);
+
+        if (not path.empty() and readKey(path + ".key")==key)
+            entry.mesh = FarMeshSerializer<OsdVertex>::Create((path + ".far").c_str());
+
+        if (not entry.mesh) {
+            FarMeshFactory<OsdVertex> factory(hmesh, level, adaptive);
+            entry.mesh = factory.Create();
+
+            if (not path.empty() and
+                FarMeshSerializer<OsdVertex>::Write(entry.mesh, (path + ".far").c_str()))
+                writeKey(path + ".key", key);
+        }
+    }
+
+    ++entry.references;
+    return entry.mesh;
+}
+
+template <class COMPUTE_CONTEXT> COMPUTE_CONTEXT *
+OsdTopologyCache<COMPUTE_CONTEXT>::GetComputeContext(FarMesh<OsdVertex> const * mesh) {
+
+    typename EntryMap::iterator it = find(mesh);
+    if (it==_entries.end())
+        return NULL;
+
+    if (not it->second.context)
+        it->second.context = createComputeContext(mesh, (ComputeContext *)0);
+
+    return it->second.context;
+}
+
+template <class COMPUTE_CONTEXT> void
+OsdTopologyCache<COMPUTE_CONTEXT>::Release(FarMesh<OsdVertex> const * mesh) {
+
+    typename EntryMap::iterator it = find(mesh);
+    assert(it!=_entries.end() and it->second.references>0);
+
+    if (--it->second.references==0) {
+        delete it->second.context;
+        delete it->second.mesh;
+        _entries.erase(it);
+    }
+}
+
+template <class COMPUTE_CONTEXT> int
+OsdTopologyCache<COMPUTE_CONTEXT>::GetNumReferences(FarMesh<OsdVertex> const * mesh) const {
+
+    typename EntryMap::const_iterator it = find(mesh);
+    return it==_entries.end() ? 0 : it->second.references;
+}
+
+template <class COMPUTE_CONTEXT> std::string
+OsdTopologyCache<COMPUTE_CONTEXT>::ComputeKey(HbrMesh<OsdVertex> const * hmesh,
+                                              int level, bool adaptive) {
+    assert(hmesh);
+
+    std::string key;
+
+    // scheme, triangle, crease and boundary rules
+    HbrSubdivision<OsdVertex> * scheme = hmesh->GetSubdivision();
+
+    int schemeId = 0, triangleMethod = 0;
+    if (HbrCatmarkSubdivision<OsdVertex> * catmark =
+            dynamic_cast<HbrCatmarkSubdivision<OsdVertex> *>(scheme)) {
+        schemeId = 1;
+        triangleMethod = (int)catmark->GetTriangleSubdivisionMethod();
+    } else if (dynamic_cast<HbrLoopSubdivision<OsdVertex> *>(scheme))
+        schemeId = 2;
+    else if (dynamic_cast<HbrBilinearSubdivision<OsdVertex> *>(scheme))
+        schemeId = 3;
+
+    append(key, schemeId);
+    append(key, triangleMethod);
+    append(key, scheme ? (int)scheme->GetCreaseSubdivisionMethod() : 0);
+    append(key, (int)hmesh->GetInterpolateBoundaryMethod());
+    append(key, level);
+    append(key, (int)adaptive);
+
+    // vertex sharpness
+    int nverts = hmesh->GetNumVertices();
+    append(key, nverts);
+    for (int i=0; i<nverts; ++i) {
+        HbrVertex<OsdVertex> * v = hmesh->GetVertex(i);
+        append(key, v ? v->GetSharpness() : -1.0f);
+    }
+
+    // face-vertex indices, holes and edge sharpness
+    int nfaces = hmesh->GetNumCoarseFaces();
+    append(key, nfaces);
+    for (int i=0; i<nfaces; ++i) {
+        HbrFace<OsdVertex> * f = hmesh->GetFace(i);
+
+        int nv = f->GetNumVertices();
+        append(key, nv);
+        append(key, (int)f->IsHole());
+        for (int j=0; j<nv; ++j) {
+            append(key, f->GetVertex(j)->GetID());
+            append(key, f->GetEdge(j)->GetSharpness());
+        }
+    }
+
+    // hierarchical edits
+    std::vector<HbrHierarchicalEdit<OsdVertex>*> const & edits =
+        hmesh->GetHierarchicalEdits();
+
+    append(key, (int)edits.size());
+    for (int i=0; i<(int)edits.size(); ++i)
+        appendEdit(key, edits[i]);
+
+    return key;
+}
+
+template <class COMPUTE_CONTEXT> void
+OsdTopologyCache<COMPUTE_CONTEXT>::appendEdit(std::string & key,
+    HbrHierarchicalEdit<OsdVertex> const * edit) {
+
+    if (HbrVertexEdit<OsdVertex> const * e =
+        dynamic_cast<HbrVertexEdit<OsdVertex> const *>(edit)) {
+        appendVertexEdit(key, 'v', e);
+    } else if (HbrMovingVertexEdit<OsdVertex> const * e =
+        dynamic_cast<HbrMovingVertexEdit<OsdVertex> const *>(edit)) {
+        appendVertexEdit(key, 'm', e);
+    } else {
+        // the other edits print their path and values
+        std::ostringstream s;
+        s.precision(9);
+
+        if (HbrCreaseEdit<OsdVertex> const * e =
+            dynamic_cast<HbrCreaseEdit<OsdVertex> const *>(edit)) {
+            s << "c " << *e;
+        } else if (HbrCornerEdit<OsdVertex> const * e =
+            dynamic_cast<HbrCornerEdit<OsdVertex> const *>(edit)) {
+            s << "k " << *e;
+        } else if (HbrHoleEdit<OsdVertex> const * e =
+            dynamic_cast<HbrHoleEdit<OsdVertex> const *>(edit)) {
+            s << "h " << *e;
+        } else if (HbrFaceEdit<OsdVertex> const * e =
+            dynamic_cast<HbrFaceEdit<OsdVertex> const *>(edit)) {
+            s << "f " << *e;
+        } else {
+            // face-varying edits do not alter the vertex topology
+            s << "-";
+        }
+
+        std::string text = s.str();
+        append(key, (int)text.size());
+        key.append(text);
+    }
+}
+
+template <class COMPUTE_CONTEXT> unsigned long long
+OsdTopologyCache<COMPUTE_CONTEXT>::Hash(std::string const & key) {
+
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i=0; i<key.size(); ++i) {
+        hash ^= (unsigned char)key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+template <class COMPUTE_CONTEXT> typename OsdTopologyCache<COMPUTE_CONTEXT>::EntryMap::iterator
+OsdTopologyCache<COMPUTE_CONTEXT>::find(FarMesh<OsdVertex> const * mesh) {
+
+    typename EntryMap::iterator it=_entries.begin();
+    for (; it!=_entries.end(); ++it)
+        if (it->second.mesh==mesh)
+            break;
+    return it;
+}
+
+template <class COMPUTE_CONTEXT> typename OsdTopologyCache<COMPUTE_CONTEXT>::EntryMap::const_iterator
+OsdTopologyCache<COMPUTE_CONTEXT>::find(FarMesh<OsdVertex> const * mesh) const {
+
+    typename EntryMap::const_iterator it=_entries.begin();
+    for (; it!=_entries.end(); ++it)
+        if (it->second.mesh==mesh)
+            break;
+    return it;
+}
+
+template <class COMPUTE_CONTEXT> std::string
+OsdTopologyCache<COMPUTE_CONTEXT>::getPath(std::string const & key) const {
+
+    if (_directory.empty())
+        return std::string();
+
+    std::ostringstream s;
+    s << _directory << '/';
+    s.width(16);
+    s.fill('0');
+    s << std::hex << Hash(key);
+    return s.str();
+}
+
+template <class COMPUTE_CONTEXT> std::string
+OsdTopologyCache<COMPUTE_CONTEXT>::readKey(std::string const & path) {
+
+    std::string key;
+
+    FILE * f = fopen(path.c_str(), "rb");
+    if (f) {
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+            key.append(buffer, n);
+        fclose(f);
+    }
+    return key;
+}
+
+template <class COMPUTE_CONTEXT> void
+OsdTopologyCache<COMPUTE_CONTEXT>::writeKey(std::string const & path,
+                                            std::string const & key) {
+
+    FILE * f = fopen(path.c_str(), "wb");
+    if (f) {
+        fwrite(key.data(), 1, key.size(), f);
+        fclose(f);
+    }
+}
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_TOPOLOGY_CACHE_H
@@ -65,7 +65,8 @@ namespace OPENSUBDIV_VERSION {
 struct OsdVertexDescriptor {
 
     /// Constructor
-    OsdVertexDescriptor() : numVertexElements(0), numVaryingElements(0) {}
+    OsdVertexDescriptor() : numVertexElements(0), numVaryingElements(0),
+                            vertexStride(0), varyingStride(0) {}
 
     /// Constructor
     ///
@@ -75,7 +76,9 @@ struct OsdVertexDescriptor {
     ///
     OsdVertexDescriptor(int numVertexElem, int numVaryingElem)
         : numVertexElements(numVertexElem),
-        numVaryingElements(numVaryingElem) { }
+        numVaryingElements(numVaryingElem),
+        vertexStride(numVertexElem),
+        varyingStride(numVaryingElem) { }
 
     /// Sets descriptor
     ///
@@ -84,13 +87,32 @@ struct OsdVertexDescriptor {
     /// @param numVaryingElem  number of varying-interpolated data elements (floats)
     ///
     void Set(int numVertexElem, int numVaryingElem) {
+        Set(numVertexElem, numVaryingElem, numVertexElem, numVaryingElem);
+    }
+
+    /// Sets descriptor for interleaved data
+    ///
+    /// @param numVertexElem   number of vertex-interpolated data elements (floats)
+    ///
+    /// @param numVaryingElem  number of varying-interpolated data elements (floats)
+    ///
+    /// @param vertexStr       number of elements between two consecutive
+    ///                        vertices in the vertex data buffer
+    ///
+    /// @param varyingStr      number of elements between two consecutive
+    ///                        vertices in the varying data buffer
+    ///
+    void Set(int numVertexElem, int numVaryingElem, int vertexStr, int varyingStr) {
         numVertexElements = numVertexElem;
         numVaryingElements = numVaryingElem;
+        vertexStride = vertexStr;
+        varyingStride = varyingStr;
     }
     
     /// Resets the descriptor
     void Reset() {
         numVertexElements = numVaryingElements = 0;
+        vertexStride = varyingStride = 0;
     }
     
     /// Returns the total number of elements (vertex + varying)
@@ -100,7 +122,9 @@ struct OsdVertexDescriptor {
 
     bool operator == (OsdVertexDescriptor const & other) {
         return (numVertexElements == other.numVertexElements and
-                numVaryingElements == other.numVaryingElements);
+                numVaryingElements == other.numVaryingElements and
+                vertexStride == other.vertexStride and
+                varyingStride == other.varyingStride);
     }
 
     /// Resets the contents of vertex & varying primvar data buffers for a given
@@ -117,12 +141,12 @@ struct OsdVertexDescriptor {
     void Clear(float *vertex, float *varying, int index) const {
         if (vertex) {
             for (int i = 0; i < numVertexElements; ++i)
-                vertex[index*numVertexElements+i] = 0.0f;
+                vertex[index*vertexStride+i] = 0.0f;
         }
 
         if (varying) {
             for (int i = 0; i < numVaryingElements; ++i)
-                varying[index*numVaryingElements+i] = 0.0f;
+                varying[index*varyingStride+i] = 0.0f;
         }
     }
     
@@ -137,8 +161,8 @@ struct OsdVertexDescriptor {
     /// @param weight Weight applied to the primvar data.
     ///
     void AddWithWeight(float *vertex, int dstIndex, int srcIndex, float weight) const {
-        int d = dstIndex * numVertexElements;
-        int s = srcIndex * numVertexElements;
+        int d = dstIndex * vertexStride;
+        int s = srcIndex * vertexStride;
         for (int i = 0; i < numVertexElements; ++i)
             vertex[d++] += vertex[s++] * weight;
     }
@@ -154,8 +178,8 @@ struct OsdVertexDescriptor {
     /// @param weight Weight applied to the primvar data.
     ///
     void AddVaryingWithWeight(float *varying, int dstIndex, int srcIndex, float weight) const {
-        int d = dstIndex * numVaryingElements;
-        int s = srcIndex * numVaryingElements;
+        int d = dstIndex * varyingStride;
+        int s = srcIndex * varyingStride;
         for (int i = 0; i < numVaryingElements; ++i)
             varying[d++] += varying[s++] * weight;
     }
@@ -173,7 +197,7 @@ struct OsdVertexDescriptor {
     /// @param editValues The values to add to the primvar datum.
     ///
     void ApplyVertexEditAdd(float *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
-        int d = editIndex * numVertexElements + primVarOffset;
+        int d = editIndex * vertexStride + primVarOffset;
         for (int i = 0; i < primVarWidth; ++i) {
             vertex[d++] += editValues[i];
         }
@@ -192,7 +216,7 @@ struct OsdVertexDescriptor {
     /// @param editValues The values to add to the primvar datum.
     ///
     void ApplyVertexEditSet(float *vertex, int primVarOffset, int primVarWidth, int editIndex, const float *editValues) const {
-        int d = editIndex * numVertexElements + primVarOffset;
+        int d = editIndex * vertexStride + primVarOffset;
         for (int i = 0; i < primVarWidth; ++i) {
             vertex[d++] = editValues[i];
         }
@@ -200,6 +224,11 @@ struct OsdVertexDescriptor {
 
     int numVertexElements;
     int numVaryingElements;
+
+    // number of elements between consecutive vertices : larger than the
+    // number of elements for interleaved data
+    int vertexStride;
+    int varyingStride;
 };
 
 /// \brief Describes vertex elements in interleaved data buffers
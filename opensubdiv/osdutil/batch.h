@@ -111,6 +111,9 @@ public:
     virtual void UpdateCoarseVertices(int meshIndex, const float *ptrs, int numVertices) = 0;
     virtual void FinalizeUpdate() = 0;
 
+    // waits until the refinement launched by FinalizeUpdate is complete
+    virtual void Synchronize() = 0;
+
     int GetBatchIndex() const { return _batchIndex; }
 
     int GetNumVertices() const { return _numVertices; }
@@ -205,6 +208,14 @@ public:
         _computeController->Refine(_computeContext, batches, _vertexBuffer);
     }
 
+    virtual void Synchronize() {
+
+        if (not _computeController)
+            return;
+
+        _computeController->Synchronize();
+    }
+
     VertexBuffer *GetVertexBuffer() const { return _vertexBuffer; }
 
     VertexBuffer *GetVaryingBuffer() const { return _varyingBuffer; }
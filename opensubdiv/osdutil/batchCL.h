@@ -111,6 +111,10 @@ public:
         _computeController->Refine(_computeContext, batches, _vertexBuffer);
     }
 
+    virtual void Synchronize() {
+        _computeController->Synchronize();
+    }
+
     VertexBuffer *GetVertexBuffer() const { return _vertexBuffer; }
     VertexBuffer *GetVaryingBuffer() const { return _varyingBuffer; }
 
@@ -59,6 +59,18 @@
 
 #include <far/meshFactory.h>
 #include <far/dispatcher.h>
+#include <far/stencilTablesFactory.h>
+#include <far/dependencyTablesFactory.h>
+#include <far/kernelBatchGraph.h>
+#include <far/refinePlan.h>
+#include <far/multiMeshFactory.h>
+#include <far/meshSerializer.h>
+#include <far/kernelStats.h>
+#include <far/trace.h>
+#include <far/memoryReport.h>
+#include <far/topologyRefiner.h>
+
+#include <map>
 
 #include "../common/shape_utils.h"
 
@@ -331,6 +343,755 @@ bool VertexOnBoundary( xyzvertex const * v ) {
     return false;
 }
 
+//------------------------------------------------------------------------------
+// Refines the vertices of a Far mesh with its stencil tables
+static void refineWithStencils( fMesh * mesh ) {
+
+    OpenSubdiv::FarStencilTables * stencils =
+        OpenSubdiv::FarStencilTablesFactory<xyzVV>::Create(mesh);
+
+    std::vector<xyzVV> & verts = mesh->GetVertices();
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                           & offsets = stencils->GetOffsets(),
+                           & indices = stencils->GetIndices();
+    std::vector<float> const & weights = stencils->GetWeights();
+
+    OpenSubdiv::FarStencilBatchVector const & batches = stencils->GetBatches();
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        OpenSubdiv::FarStencilBatch const & batch = batches[i];
+
+        if (batch.GetBatchType()==OpenSubdiv::FarStencilBatch::HIERARCHICAL_EDIT) {
+            OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.ApplyVertexEdits(
+                batch.GetEditBatch(), mesh);
+            continue;
+        }
+
+        for (int j=batch.GetStart(); j<batch.GetEnd(); ++j) {
+            int stencil = batch.GetTableOffset()+j;
+
+            xyzVV & dst = verts[batch.GetVertexOffset()+j];
+            dst.Clear();
+            for (int k=0; k<sizes[stencil]; ++k)
+                dst.AddWithWeight( verts[indices[offsets[stencil]+k]],
+                                   weights[offsets[stencil]+k] );
+        }
+    }
+
+    delete stencils;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of vertices refined by the stencil tables that do not
+// match the vertices refined by the subdivision tables
+static int checkStencils( fMesh * mesh ) {
+
+    std::vector<xyzVV> verts = mesh->GetVertices();
+
+    refineWithStencils(mesh);
+
+    int count=0;
+    for (int i=0; i<(int)verts.size(); ++i) {
+
+        float const * p0 = verts[i].GetPos(),
+                    * p1 = mesh->GetVertex(i).GetPos();
+
+        float delta[3] = { p0[0]-p1[0], p0[1]-p1[1], p0[2]-p1[2] };
+
+        float dist = sqrtf( delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]);
+        if ( dist > PRECISION ) {
+            if (not g_debugmode)
+                printf("// FarStencilTables vertex %d fails : dist=%.10f\n", i, dist);
+            count++;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of vertices refined by the composite stencil tables that
+// do not match the finest level of the mesh
+static int checkCompositeStencils( fMesh * mesh, int level ) {
+
+    OpenSubdiv::FarStencilTables * stencils =
+        OpenSubdiv::FarStencilTablesFactory<xyzVV>::CreateComposite(mesh);
+
+    // hierarchical edits cannot be factored into composite stencils
+    if (not stencils)
+        return 0;
+
+    fSubdivision const * tables = mesh->GetSubdivisionTables();
+
+    int ncoarse = tables->GetNumVertices(0),
+        firstvert = tables->GetFirstVertexOffset(level),
+        numverts = tables->GetNumVertices(level);
+
+    // compacted vertex buffer : coarse vertices followed by the finest level
+    std::vector<xyzVV> verts(mesh->GetVertices().begin(),
+                             mesh->GetVertices().begin()+ncoarse);
+    verts.resize(ncoarse+numverts);
+
+    std::vector<int> const & sizes = stencils->GetSizes(),
+                           & offsets = stencils->GetOffsets(),
+                           & indices = stencils->GetIndices();
+    std::vector<float> const & weights = stencils->GetWeights();
+
+    OpenSubdiv::FarStencilBatchVector const & batches = stencils->GetBatches();
+    for (int i=0; i<(int)batches.size(); ++i) {
+
+        OpenSubdiv::FarStencilBatch const & batch = batches[i];
+
+        for (int j=batch.GetStart(); j<batch.GetEnd(); ++j) {
+            int stencil = batch.GetTableOffset()+j;
+
+            xyzVV & dst = verts[batch.GetVertexOffset()+j];
+            dst.Clear();
+            for (int k=0; k<sizes[stencil]; ++k)
+                dst.AddWithWeight( verts[indices[offsets[stencil]+k]],
+                                   weights[offsets[stencil]+k] );
+        }
+    }
+
+    delete stencils;
+
+    int count=0;
+    for (int i=0; i<numverts; ++i) {
+
+        float const * p0 = mesh->GetVertex(firstvert+i).GetPos(),
+                    * p1 = verts[ncoarse+i].GetPos();
+
+        float delta[3] = { p0[0]-p1[0], p0[1]-p1[1], p0[2]-p1[2] };
+
+        float dist = sqrtf( delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]);
+        if ( dist > PRECISION ) {
+            if (not g_debugmode)
+                printf("// composite FarStencilTables vertex %d fails : dist=%.10f\n", i, dist);
+            count++;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Returns the number of vertices of a mesh that do not match exactly a
+// reference. With 'remap', the reference vertex i is compared to the vertex
+// (*remap)[i] of the mesh, and skipped if that index is negative.
+static int compareVertices( std::vector<xyzVV> const & verts, fMesh * mesh,
+                            char const * name, std::vector<int> const * remap=0 ) {
+
+    int count=0;
+    for (int i=0; i<(int)verts.size(); ++i) {
+
+        int vertex = remap ? (*remap)[i] : i;
+        if (vertex<0)
+            continue;
+
+        float const * p0 = verts[i].GetPos(),
+                    * p1 = mesh->GetVertex(vertex).GetPos();
+
+        if ( p0[0]!=p1[0] or p0[1]!=p1[1] or p0[2]!=p1[2] ) {
+            if (not g_debugmode)
+                printf("// %s vertex %d fails\n", name, i);
+            count++;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Moves a control vertex and returns the number of vertices refined with the
+// dirty batches of its dependency cone that do not match a full refinement
+static int checkDependencies( fMesh * mesh, int vertex ) {
+
+    OpenSubdiv::FarComputeController<xyzVV> const & controller =
+        OpenSubdiv::FarComputeController<xyzVV>::_DefaultController;
+
+    OpenSubdiv::FarDependencyTables * dependencies =
+        OpenSubdiv::FarDependencyTablesFactory<xyzVV>::Create(mesh);
+
+    if (vertex>=dependencies->GetNumControlVertices()) {
+        delete dependencies;
+        return 0;
+    }
+
+    controller.Refine(mesh);
+
+    float const * p = mesh->GetVertex(vertex).GetPos();
+    mesh->GetVertex(vertex).SetPosition(p[0]+1.0f, p[1]-2.0f, p[2]+0.5f);
+
+    OpenSubdiv::FarKernelBatchVector batches;
+    dependencies->GetDirtyBatches(mesh->GetKernelBatches(), &vertex, 1,
+                                  batches, 1.0f);
+
+    OpenSubdiv::FarDispatcher::Refine(&controller, batches, -1, mesh);
+
+    std::vector<xyzVV> verts = mesh->GetVertices();
+
+    controller.Refine(mesh);
+
+    delete dependencies;
+
+    return compareVertices(verts, mesh, "FarDependencyTables");
+}
+
+//------------------------------------------------------------------------------
+// Refines the mesh wave after wave of its batch dependency graph, applying the
+// batches of each wave in reverse order, and returns the number of vertices
+// that do not match the sequential dispatch
+static int checkBatchGraph( fMesh * mesh ) {
+
+    OpenSubdiv::FarComputeController<xyzVV> const & controller =
+        OpenSubdiv::FarComputeController<xyzVV>::_DefaultController;
+
+    OpenSubdiv::FarKernelBatchGraph graph(mesh->GetKernelBatches());
+
+    int count=0;
+
+    // the dependencies of a batch must run in earlier waves
+    std::vector<int> waves(graph.GetNumBatches());
+    for (int i=0; i<graph.GetNumWaves(); ++i)
+        for (int j=0; j<graph.GetNumWaveBatches(i); ++j)
+            waves[graph.GetWaveBatches(i)[j]] = i;
+
+    for (int i=0; i<graph.GetNumBatches(); ++i)
+        for (int j=0; j<graph.GetNumDependencies(i); ++j)
+            if (waves[graph.GetDependencies(i)[j]]>=waves[i]) {
+                if (not g_debugmode)
+                    printf("// FarKernelBatchGraph batch %d runs before its dependency\n", i);
+                count++;
+            }
+
+    controller.Refine(mesh);
+
+    std::vector<xyzVV> verts = mesh->GetVertices();
+
+    // scramble the refined vertices so that reading a vertex before it is
+    // computed shows
+    int ncoarse = mesh->GetSubdivisionTables()->GetNumVertices(0);
+    for (int i=ncoarse; i<mesh->GetNumVertices(); ++i)
+        mesh->GetVertex(i).SetPosition(1.0e3f, -1.0e3f, (float)i);
+
+    for (int i=0; i<graph.GetNumWaves(); ++i)
+        for (int j=graph.GetNumWaveBatches(i)-1; j>=0; --j)
+            OpenSubdiv::FarDispatcher::ApplyKernel(&controller,
+                graph.GetBatches()[graph.GetWaveBatches(i)[j]], mesh);
+
+    count += compareVertices(verts, mesh, "FarKernelBatchGraph");
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Refines the mesh again through a refine plan and returns the number of
+// vertices that do not match the sequential dispatch
+static int checkRefinePlan( fMesh * mesh, int levels ) {
+
+    OpenSubdiv::FarComputeController<xyzVV> const & controller =
+        OpenSubdiv::FarComputeController<xyzVV>::_DefaultController;
+
+    OpenSubdiv::FarRefinePlan plan(mesh->GetKernelBatches());
+
+    int count=0;
+    if (plan.GetFinestLevel()!=levels) {
+        if (not g_debugmode)
+            printf("// FarRefinePlan finest level %d (expected %d)\n", plan.GetFinestLevel(), levels);
+        count++;
+    }
+
+    std::vector<xyzVV> verts = mesh->GetVertices();
+
+    int ncoarse = mesh->GetSubdivisionTables()->GetNumVertices(0);
+    for (int i=ncoarse; i<mesh->GetNumVertices(); ++i)
+        mesh->GetVertex(i).SetPosition(1.0e3f, -1.0e3f, (float)i);
+
+    controller.Refine(mesh, plan);
+
+    count += compareVertices(verts, mesh, "FarRefinePlan");
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Serializes the mesh, creates a mesh back from the image and returns the
+// number of vertices that do not match the refinement of the mesh
+static int checkSerialization( fMesh * mesh ) {
+
+    typedef OpenSubdiv::FarMeshSerializer<xyzVV> Serializer;
+
+    std::vector<unsigned char> image(Serializer::GetSize(mesh));
+    Serializer::Write(mesh, &image[0]);
+
+    // the tables of the meshes created in place and from a file reference
+    // their image
+    char const * path = "far_regression.far";
+
+    fMesh * results[3] = { Serializer::Create(&image[0], image.size()),
+                           Serializer::Create(&image[0], image.size(), false),
+                           Serializer::Write(mesh, path) ? Serializer::Create(path) : 0 };
+    remove(path);
+
+    if (not results[0] or not results[1] or not results[2]) {
+        if (not g_debugmode)
+            printf("// FarMeshSerializer image is not valid\n");
+        for (int i=0; i<3; ++i)
+            delete results[i];
+        return 1;
+    }
+
+    int count=0;
+
+    OpenSubdiv::FarTable<int> const & V_ITa = results[1]->GetSubdivisionTables()->Get_V_ITa();
+    unsigned char const * tableData = reinterpret_cast<unsigned char const *>(&V_ITa[0]);
+    if (not results[0]->GetSubdivisionTables()->Get_V_ITa().IsOwned() or
+        V_ITa.IsOwned() or tableData < &image[0] or tableData >= &image[0] + image.size() or
+        results[2]->GetSubdivisionTables()->Get_V_ITa().IsOwned()) {
+        if (not g_debugmode)
+            printf("// FarMeshSerializer does not reference the image in place\n");
+        count++;
+    }
+
+    int ncoarse = mesh->GetSubdivisionTables()->GetNumVertices(0);
+    for (int i=0; i<3; ++i) {
+        for (int j=0; j<ncoarse; ++j)
+            results[i]->GetVertex(j) = mesh->GetVertex(j);
+
+        OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.Refine(results[i]);
+
+        count += compareVertices(mesh->GetVertices(), results[i], "FarMeshSerializer");
+    }
+
+    // the image of the created mesh is identical
+    std::vector<unsigned char> copy(Serializer::GetSize(results[0]));
+    Serializer::Write(results[0], &copy[0]);
+    if (copy != image) {
+        if (not g_debugmode)
+            printf("// FarMeshSerializer images differ\n");
+        count++;
+    }
+
+    for (int i=0; i<3; ++i)
+        delete results[i];
+
+    // truncated or altered images are rejected, as well as images with a
+    // batch that computes vertices past the end of its level
+    OpenSubdiv::FarKernelBatchVector & batches =
+        const_cast<OpenSubdiv::FarKernelBatchVector &>(mesh->GetKernelBatches());
+    OpenSubdiv::FarKernelBatch batch = batches[0];
+    batches[0] = OpenSubdiv::FarKernelBatch(batch.GetKernelType(), batch.GetLevel(),
+        batch.GetTableIndex(), batch.GetStart(), batch.GetEnd() + mesh->GetNumVertices(),
+        batch.GetTableOffset(), batch.GetVertexOffset());
+    std::vector<unsigned char> corrupted(Serializer::GetSize(mesh));
+    Serializer::Write(mesh, &corrupted[0]);
+    batches[0] = batch;
+
+    copy[copy.size()/2]++;
+    image[8]++;
+    if (Serializer::Create(&image[0], image.size()) or
+        Serializer::Create(&copy[0], copy.size()) or
+        Serializer::Create(&copy[0], copy.size()-1) or
+        Serializer::Create(&corrupted[0], corrupted.size())) {
+        if (not g_debugmode)
+            printf("// FarMeshSerializer accepts an invalid image\n");
+        count++;
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Records the batches of a refinement and checks the number of batches,
+// vertices and bytes written counted per level
+static int checkKernelStats( fMesh * mesh ) {
+
+    typedef OpenSubdiv::FarComputeController<xyzVV> Controller;
+
+    OpenSubdiv::FarKernelBatchVector const & batches = mesh->GetKernelBatches();
+
+    OpenSubdiv::FarKernelStats stats;
+    stats.SetVertexSize(7);
+
+#ifdef OPENSUBDIV_KERNEL_STATS
+    // the dispatcher records the batches
+    OpenSubdiv::FarKernelStats::SetCurrent(&stats);
+    Controller::_DefaultController.Refine(mesh);
+    OpenSubdiv::FarKernelStats::SetCurrent(0);
+#else
+    // the batches are measured the way the dispatcher does when recording
+    for (int i=0; i<(int)batches.size(); ++i) {
+        OpenSubdiv::FarKernelStats::Sample sample = stats.Begin();
+        OpenSubdiv::FarDispatcher::ApplyKernel(&Controller::_DefaultController, batches[i], mesh);
+        stats.End(batches[i], sample);
+    }
+#endif
+
+    std::vector<long long> expectedBatches(stats.GetNumLevels(), 0),
+                           expectedVertices(stats.GetNumLevels(), 0);
+    for (int i=0; i<(int)batches.size(); ++i) {
+        int level = batches[i].GetLevel();
+        if (level >= (int)expectedVertices.size()) {
+            if (not g_debugmode)
+                printf("// FarKernelStats level %d not recorded\n", level);
+            return 1;
+        }
+        expectedBatches[level]++;
+        expectedVertices[level] += batches[i].GetEnd() - batches[i].GetStart();
+    }
+
+    int count=0;
+    for (int level=0; level<stats.GetNumLevels(); ++level) {
+        long long numBatches = 0,
+                  numVertices = 0,
+                  bytesWritten = 0;
+        for (int kernel=0; kernel<=OpenSubdiv::FarKernelBatch::HIERARCHICAL_EDIT; ++kernel) {
+            OpenSubdiv::FarKernelStats::Counters const & counters = stats.GetCounters(kernel, level);
+            numBatches += counters.numBatches;
+            numVertices += counters.numVertices;
+            bytesWritten += counters.bytesWritten;
+        }
+        if (numBatches != expectedBatches[level] or
+            numVertices != expectedVertices[level] or
+            bytesWritten != numVertices * stats.GetVertexSize()) {
+            if (not g_debugmode)
+                printf("// FarKernelStats level %d counts %lld batches, %lld vertices, "
+                       "%lld bytes written (expected %lld, %lld, %lld)\n",
+                       level, numBatches, numVertices, bytesWritten,
+                       expectedBatches[level], expectedVertices[level],
+                       expectedVertices[level] * stats.GetVertexSize());
+            count++;
+        }
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Checks the memory report of a mesh against the size of its tables, and the
+// peak memory of its factory against the final memory of the Hbr and Far
+// meshes
+static int checkMemoryReport( fMeshFactory const & fact, fMesh * mesh ) {
+
+    OpenSubdiv::FarMemoryReport report;
+
+    OpenSubdiv::FarMemoryReport::AddHbrMesh(report, fact.GetHbrMesh(), "hbr.");
+    mesh->ReportMemoryUsage(report, "far.");
+
+    int count=0;
+
+    size_t hbrMemory = report.GetSize("hbr.");
+    if (hbrMemory < fact.GetHbrMesh()->GetMemStats()) {
+        if (not g_debugmode)
+            printf("// FarMemoryReport Hbr memory %d < %d bytes\n",
+                   (int)hbrMemory, (int)fact.GetHbrMesh()->GetMemStats());
+        count++;
+    }
+
+    size_t subdivisionMemory = report.GetSize("far.subdivision.");
+    if (subdivisionMemory < (size_t)mesh->GetSubdivisionTables()->GetMemoryUsed()) {
+        if (not g_debugmode)
+            printf("// FarMemoryReport subdivision tables %d < %d bytes\n",
+                   (int)subdivisionMemory, mesh->GetSubdivisionTables()->GetMemoryUsed());
+        count++;
+    }
+
+    if (report.GetSize("far.patches.") < mesh->GetPatchTables()->GetPatchTable().size() * sizeof(unsigned int)) {
+        if (not g_debugmode)
+            printf("// FarMemoryReport patch tables too small\n");
+        count++;
+    }
+
+    size_t sum = 0;
+    for (int i=0; i<report.GetNumComponents(); ++i)
+        sum += report.GetComponentSize(i);
+    if (sum != report.GetTotal() or report.GetTotal() != hbrMemory + report.GetSize("far.")) {
+        if (not g_debugmode)
+            printf("// FarMemoryReport components do not add up to the total\n");
+        count++;
+    }
+
+    if (fact.GetPeakMemoryUsed() < report.GetTotal()) {
+        if (not g_debugmode)
+            printf("// FarMeshFactory peak memory %d < %d bytes\n",
+                   (int)fact.GetPeakMemoryUsed(), (int)report.GetTotal());
+        count++;
+    }
+
+    std::ostringstream json;
+    report.WriteJSON(json);
+    if (json.str().find("\"far.subdivision.V_IT\"") == std::string::npos) {
+        if (not g_debugmode)
+            printf("// FarMemoryReport JSON misses the subdivision tables\n");
+        count++;
+    }
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Traces the construction and refinement of a mesh and checks that every
+// batch is recorded
+static int checkTrace( xyzmesh * hmesh, int levels ) {
+
+#ifdef OPENSUBDIV_TRACE
+    OpenSubdiv::FarTrace trace;
+    OpenSubdiv::FarTrace::SetCurrent(&trace);
+
+    fMeshFactory fact( hmesh, levels );
+    fMesh * mesh = fact.Create( );
+    OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.Refine(mesh);
+
+    OpenSubdiv::FarTrace::SetCurrent(0);
+
+    int numKernels=0, numCreates=0;
+    for (int i=0; i<trace.GetNumEvents(); ++i) {
+        OpenSubdiv::FarTrace::Event const & event = trace.GetEvent(i);
+        if (not strcmp(event.category, "kernel"))
+            ++numKernels;
+        if (not strcmp(event.name, "FarMeshFactory::Create"))
+            ++numCreates;
+        if (event.end < event.begin) {
+            if (not g_debugmode)
+                printf("// FarTrace span %s ends before it begins\n", event.name);
+            delete mesh;
+            return 1;
+        }
+    }
+
+    int count=0;
+    if (numKernels != (int)mesh->GetKernelBatches().size() or numCreates != 1) {
+        if (not g_debugmode)
+            printf("// FarTrace recorded %d kernels (expected %d) and %d meshes\n",
+                   numKernels, (int)mesh->GetKernelBatches().size(), numCreates);
+        count++;
+    }
+    delete mesh;
+    return count;
+#else
+    (void)hmesh;
+    (void)levels;
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Splices copies of the mesh with coalesced kernel batches and returns the
+// number of vertices that do not match the refinement of the mesh
+static int checkCoalescedBatches( fMesh * mesh ) {
+
+    static int const ncopies = 3;
+
+    std::vector<fMesh const *> meshes(ncopies, mesh);
+
+    OpenSubdiv::FarMultiMeshFactory<xyzVV> fact;
+    fact.SetCoalesceBatches(true);
+
+    fMesh * m = fact.Create(meshes);
+
+    int count=0;
+
+    // without hierarchical edits, each kernel runs once per level
+    if (not mesh->GetVertexEdit() and
+        m->GetKernelBatches().size()!=mesh->GetKernelBatches().size()) {
+        if (not g_debugmode)
+            printf("// coalesced batches : %d batches (expected %d)\n",
+                (int)m->GetKernelBatches().size(), (int)mesh->GetKernelBatches().size());
+        count++;
+    }
+
+    std::vector<int> const & remap = fact.GetRemappingTable();
+
+    int nverts = mesh->GetNumVertices(),
+        ncoarse = mesh->GetSubdivisionTables()->GetNumVertices(0);
+
+    for (int i=0; i<ncopies; ++i)
+        for (int j=0; j<ncoarse; ++j) {
+            int vertex = i*nverts + j;
+            m->GetVertex(remap.empty() ? vertex : remap[vertex]) = mesh->GetVertex(j);
+        }
+
+    OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.Refine(m);
+
+    // each copy must match the mesh
+    std::vector<xyzVV> verts;
+    verts.reserve(ncopies*nverts);
+    for (int i=0; i<ncopies; ++i)
+        verts.insert(verts.end(), mesh->GetVertices().begin(), mesh->GetVertices().end());
+
+    count += compareVertices(verts, m, "coalesced batches :", remap.empty() ? 0 : &remap);
+
+    delete m;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Creates the mesh again with the locality ordering of the refined vertices and
+// returns the number of vertices that do not match the default ordering
+static int checkLocalityOrdering( xyzmesh * hmesh, int levels, fMesh * mesh,
+                                  std::vector<int> const & remap ) {
+
+    fMeshFactory fact( hmesh, levels );
+    fact.SetLocalityOrdering(true);
+
+    fMesh * m = fact.Create( );
+    OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.Refine(m);
+
+    std::vector<int> const & localRemap = fact.GetRemappingTable();
+
+    int count=0;
+    if (m->GetKernelBatches().size()!=mesh->GetKernelBatches().size()) {
+        if (not g_debugmode)
+            printf("// locality ordering : kernel batches do not match\n");
+        count++;
+    }
+
+    // compare the vertices by their HbrVertex<T> index
+    std::vector<xyzVV> verts(remap.size());
+    std::vector<int> localIndices(remap.size(), -1);
+    for (int i=0; i<(int)remap.size(); ++i)
+        if (remap[i]>=0) {
+            verts[i] = mesh->GetVertex(remap[i]);
+            localIndices[i] = localRemap[i];
+        }
+
+    count += compareVertices(verts, m, "locality ordering : Hbr", &localIndices);
+
+    delete m;
+    return count;
+}
+
+//------------------------------------------------------------------------------
+// Creates the mesh again from the face-vertex arrays and sharpness tags of the
+// coarse Hbr mesh with a FarTopologyRefiner, and compares the tables sizes,
+// the kernel batches and the refined quads (matched by their ptex
+// parameterization) with those of the Hbr path
+static int checkTopologyRefiner( xyzmesh * hmesh, int levels, fMesh * mesh ) {
+
+    typedef OpenSubdiv::FarTopologyRefiner<xyzVV> Refiner;
+
+    if (hmesh->HasVertexEdits())
+        return 0;
+
+    int nverts = mesh->GetSubdivisionTables()->GetNumVertices(0),
+        nfaces = hmesh->GetNumCoarseFaces();
+
+    std::vector<int> nvertsPerFace(nfaces), faceverts;
+    for (int i=0; i<nfaces; ++i) {
+        xyzface * f = hmesh->GetFace(i);
+        if (f->IsHole())
+            return 0;
+        nvertsPerFace[i] = f->GetNumVertices();
+        for (int j=0; j<f->GetNumVertices(); ++j)
+            faceverts.push_back(f->GetVertex(j)->GetID());
+    }
+
+    Refiner refiner(nverts, nfaces, &nvertsPerFace[0], &faceverts[0], levels);
+
+    // non-manifold meshes are not supported
+    if (not refiner.IsValid())
+        return 0;
+
+    switch (hmesh->GetInterpolateBoundaryMethod()) {
+        case xyzmesh::k_InterpolateBoundaryEdgeOnly :
+            refiner.SetInterpolateBoundary(Refiner::INTERPOLATE_BOUNDARY_EDGE_ONLY); break;
+        case xyzmesh::k_InterpolateBoundaryEdgeAndCorner :
+            refiner.SetInterpolateBoundary(Refiner::INTERPOLATE_BOUNDARY_EDGE_AND_CORNER); break;
+        default : break;
+    }
+
+    OpenSubdiv::HbrCatmarkSubdivision<xyzVV> * scheme =
+        dynamic_cast<OpenSubdiv::HbrCatmarkSubdivision<xyzVV> *>(hmesh->GetSubdivision());
+    if (scheme->GetTriangleSubdivisionMethod()==OpenSubdiv::HbrCatmarkSubdivision<xyzVV>::k_New)
+        refiner.SetTriangleSubdivision(Refiner::TRIANGLE_SUBDIVISION_SMOOTH);
+
+    int count=0;
+
+    std::vector<xyzVV> coarseVerts(nverts);
+    for (int i=0; i<nverts; ++i) {
+        xyzvertex * v = hmesh->GetVertex(i);
+        coarseVerts[i] = v->GetData();
+        if (v->GetSharpness()>0.0f)
+            refiner.SetCornerSharpness(i, v->GetSharpness());
+    }
+
+    for (int i=0; i<nfaces; ++i) {
+        xyzface * f = hmesh->GetFace(i);
+        for (int j=0; j<f->GetNumVertices(); ++j) {
+            xyzhalfedge * e = f->GetEdge(j);
+            if (e->GetSharpness()>0.0f and
+                not refiner.SetCreaseSharpness(e->GetOrgVertex()->GetID(), e->GetDestVertex()->GetID(), e->GetSharpness()))
+                count++;
+        }
+    }
+
+    fMesh * m = refiner.Create(&coarseVerts[0]);
+    OpenSubdiv::FarComputeController<xyzVV>::_DefaultController.Refine(m);
+
+    // tables and batches
+    fSubdivision const * tables = mesh->GetSubdivisionTables(),
+                       * refined = m->GetSubdivisionTables();
+
+    for (int level=0; level<=levels; ++level)
+        if (tables->GetNumVertices(level)!=refined->GetNumVertices(level))
+            count++;
+
+    if (tables->Get_F_IT().size()!=refined->Get_F_IT().size() or
+        tables->Get_E_IT().size()!=refined->Get_E_IT().size() or
+        tables->Get_V_ITa().size()!=refined->Get_V_ITa().size() or
+        tables->Get_V_IT().size()!=refined->Get_V_IT().size())
+        count++;
+
+    if (mesh->GetKernelBatches().size()!=m->GetKernelBatches().size() or
+        mesh->GetNumPtexFaces()!=m->GetNumPtexFaces())
+        count++;
+
+    if (count and not g_debugmode)
+        printf("// FarTopologyRefiner tables do not match\n");
+
+    // refined quads
+    fPatches::PTable const & patches = mesh->GetPatchTables()->GetPatchTable(),
+                           & refinedPatches = m->GetPatchTables()->GetPatchTable();
+    fPatches::PatchParamTable const & params = mesh->GetPatchTables()->GetPatchParamTable(),
+                                    & refinedParams = m->GetPatchTables()->GetPatchParamTable();
+
+    std::map<std::pair<unsigned int, unsigned int>, int> quads;
+    for (int i=0; i<(int)refinedParams.size(); ++i)
+        quads[std::make_pair(refinedParams[i].faceIndex, refinedParams[i].bitField.field)] = i;
+
+    if (params.size()!=refinedParams.size() or quads.size()!=refinedParams.size()) {
+        if (not g_debugmode)
+            printf("// FarTopologyRefiner quads do not match\n");
+        count++;
+    } else {
+        for (int i=0; i<(int)params.size(); ++i) {
+
+            std::map<std::pair<unsigned int, unsigned int>, int>::const_iterator it =
+                quads.find(std::make_pair(params[i].faceIndex, params[i].bitField.field));
+
+            if (it==quads.end()) {
+                if (not g_debugmode)
+                    printf("// FarTopologyRefiner quad %d not found\n", i);
+                count++;
+                continue;
+            }
+
+            for (int j=0; j<4; ++j) {
+                float const * p0 = mesh->GetVertex(patches[i*4+j]).GetPos(),
+                            * p1 = m->GetVertex(refinedPatches[it->second*4+j]).GetPos();
+
+                float delta[3] = { p0[0]-p1[0], p0[1]-p1[1], p0[2]-p1[2] };
+
+                float dist = sqrtf(delta[0]*delta[0]+delta[1]*delta[1]+delta[2]*delta[2]);
+                if (dist > PRECISION) {
+                    if (not g_debugmode)
+                        printf("// FarTopologyRefiner quad %d vertex %d fails : dist=%.10f\n", i, j, dist);
+                    count++;
+                }
+            }
+        }
+    }
+
+    delete m;
+    return count;
+}
+
 //------------------------------------------------------------------------------
 int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCatmark ) {
 
@@ -399,6 +1160,32 @@ int checkMesh( char const * msg, xyzmesh * hmesh, int levels, Scheme scheme=kCat
         }
     }
 
+    if (scheme==kCatmark)
+        count += checkTopologyRefiner(hmesh, levels, m);
+
+    count += checkLocalityOrdering(hmesh, levels, m, remap);
+
+    count += checkStencils(m);
+
+    count += checkCompositeStencils(m, levels);
+
+    count += checkDependencies(m, 0);
+    count += checkDependencies(m, m->GetSubdivisionTables()->GetNumVertices(0)/2);
+
+    count += checkBatchGraph(m);
+
+    count += checkRefinePlan(m, levels);
+
+    count += checkCoalescedBatches(m);
+
+    count += checkKernelStats(m);
+
+    count += checkSerialization(m);
+
+    count += checkTrace(hmesh, levels);
+
+    count += checkMemoryReport(fact, m);
+
     if (deltaCnt[0])
         deltaAvg[0]/=deltaCnt[0];
     if (deltaCnt[1])
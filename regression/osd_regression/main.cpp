@@ -85,9 +85,18 @@
 #include <osd/cpuVertexBuffer.h>
 #include <osd/cpuComputeController.h>
 #include <osd/cpuComputeContext.h>
+#include <osd/cpuSimd.h>
+#include <osd/topologyCache.h>
 
 #include <osd/cpuGLVertexBuffer.h>
 
+#ifdef OPENSUBDIV_HAS_PTHREADS
+    #include <osd/threadPoolComputeController.h>
+    #include <osd/asyncComputeController.h>
+    #include <osd/hybridComputeController.h>
+    #include <osd/refineScheduler.h>
+#endif
+
 #ifdef OPENSUBDIV_HAS_CUDA
 #endif
 
@@ -120,6 +129,10 @@ enum BackendType {
     kBackendCPU   = 0, // raw CPU
     kBackendCPUGL = 1, // CPU with GL-backed buffer
     kBackendCL    = 2, // OpenCL
+    kBackendThreadPool = 3, // CPU kernels on a pool of threads
+    kBackendAsync = 4, // CPU kernels on a background thread
+    kBackendHybrid = 5, // CPU kernels selected per batch
+    kBackendScheduler = 6, // CPU refinements run side by side
     kBackendCount
 };
 
@@ -127,6 +140,10 @@ static const char* g_BackendNames[kBackendCount] = {
     "CPU",
     "CPUGL",
     "CL",
+    "ThreadPool",
+    "Async",
+    "Hybrid",
+    "Scheduler",
 };
 
 static int g_Backend = -1;
@@ -335,6 +352,18 @@ refine( xyzmesh * mesh, int maxlevel ) {
     }
 }
 
+//------------------------------------------------------------------------------
+// Returns the number of elements that are not bitwise identical
+static int
+compareBuffers( const float * a, const float * b, int size ) {
+
+    int count=0;
+    for (int i=0; i<size; ++i)
+        if (a[i]!=b[i])
+            ++count;
+    return count;
+}
+
 //------------------------------------------------------------------------------
 static int 
 checkMeshCPU( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
@@ -345,14 +374,146 @@ checkMeshCPU( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
     static OpenSubdiv::OsdCpuComputeController *controller = new OpenSubdiv::OsdCpuComputeController();
     
     OpenSubdiv::OsdCpuComputeContext *context = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    // run the kernels for every instruction set supported by the host : the
+    // scalar results are checked against hbr, the SIMD variants must match
+    // them bitwise.
+    typedef OpenSubdiv::OsdCpuSimd Simd;
+
+    Simd::ISA defaultISA = Simd::GetISA();
+
+    std::vector<float> reference;
+
+    int result = 0;
+    for (int isa=Simd::ISA_NONE; isa<Simd::ISA_COUNT; ++isa) {
+
+        if (not Simd::SetISA((Simd::ISA)isa))
+            continue;
+
+        OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
     
-    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+        vb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
     
+        controller->Refine( context, farmesh->GetKernelBatches(), vb );
+
+        const float * data = vb->BindCpuBuffer();
+
+        int size = vb->GetNumVertices() * vb->GetNumElements();
+
+        if (reference.empty()) {
+            result += checkVertexBuffer(refmesh, data, vb->GetNumElements(), remap);
+            reference.assign(data, data+size);
+        } else {
+            int count = compareBuffers(&reference[0], data, size);
+            if (count)
+                printf("    %s kernels : %d elements differ from scalar kernels\n",
+                    Simd::GetISAName((Simd::ISA)isa), count);
+            result += count;
+        }
+
+        delete vb;
+    }
+
+    Simd::SetISA(defaultISA);
+
+    delete context;
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Instances of the same shape must share a single mesh and compute context
+static int 
+checkTopologyCache( std::string const & shape, int levels, Scheme scheme,
+                    const std::vector<float>& coarseverts,
+                    xyzmesh * refmesh,
+                    const std::vector<int>& remap) {
+
+    static OpenSubdiv::OsdCpuComputeController *controller = new OpenSubdiv::OsdCpuComputeController();
+
+    OpenSubdiv::OsdTopologyCache<> cache;
+
+    int result = 0;
+
+    OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> const * meshes[2];
+    for (int i=0; i<2; ++i) {
+        std::vector<float> verts;
+        OsdHbrMesh * hmesh = simpleHbr<OpenSubdiv::OsdVertex>(shape.c_str(), scheme, verts);
+        meshes[i] = cache.AcquireMesh(hmesh, levels);
+        delete hmesh;
+    }
+
+    if (meshes[0]!=meshes[1] or cache.GetNumMeshes()!=1 or
+        cache.GetNumReferences(meshes[0])!=2) {
+        printf("    topology cache : instances do not share their mesh\n");
+        ++result;
+    }
+
+    OpenSubdiv::OsdCpuComputeContext * context = cache.GetComputeContext(meshes[0]);
+    if (context!=cache.GetComputeContext(meshes[1]) or
+        context->GetTableStorage()!=OpenSubdiv::OsdCpuComputeContext::TABLES_SHARED) {
+        printf("    topology cache : instances do not share their context\n");
+        ++result;
+    }
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, meshes[0]->GetNumVertices());
+
     vb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
-    
-    controller->Refine( context, farmesh->GetKernelBatches(), vb );
-    
-    return checkVertexBuffer(refmesh, vb->BindCpuBuffer(), vb->GetNumElements(), remap);
+
+    controller->Refine( context, meshes[0]->GetKernelBatches(), vb );
+
+    result += checkVertexBuffer(refmesh, vb->BindCpuBuffer(), vb->GetNumElements(), remap);
+
+    delete vb;
+
+    cache.Release(meshes[0]);
+    cache.Release(meshes[1]);
+
+    if (cache.GetNumMeshes()!=0) {
+        printf("    topology cache : mesh not released\n");
+        ++result;
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Instances differing only in their triangle subdivision rule must not share
+// a mesh
+static int
+checkTopologyCacheRules( std::string const & shape, int levels ) {
+
+    typedef OpenSubdiv::HbrCatmarkSubdivision<OpenSubdiv::OsdVertex> CatmarkSubdivision;
+
+    OpenSubdiv::OsdTopologyCache<> cache;
+
+    int result = 0;
+
+    OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> const * meshes[2];
+    for (int i=0; i<2; ++i) {
+        std::vector<float> verts;
+        OsdHbrMesh * hmesh = simpleHbr<OpenSubdiv::OsdVertex>(shape.c_str(), kCatmark, verts);
+
+        // the Catmark scheme of the shapes is shared : restore its rule after use
+        CatmarkSubdivision * scheme = dynamic_cast<CatmarkSubdivision *>(hmesh->GetSubdivision());
+        assert(scheme);
+
+        scheme->SetTriangleSubdivisionMethod(i ? CatmarkSubdivision::k_New : CatmarkSubdivision::k_Normal);
+        meshes[i] = cache.AcquireMesh(hmesh, levels);
+        scheme->SetTriangleSubdivisionMethod(CatmarkSubdivision::k_Normal);
+
+        delete hmesh;
+    }
+
+    if (meshes[0]==meshes[1] or cache.GetNumMeshes()!=2) {
+        printf("    topology cache : smooth and Catmark triangles share their mesh\n");
+        ++result;
+    }
+
+    cache.Release(meshes[0]);
+    cache.Release(meshes[1]);
+
+    return result;
 }
 
 //------------------------------------------------------------------------------
@@ -375,6 +536,261 @@ checkMeshCPUGL( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
     return checkVertexBuffer(refmesh, vb->BindCpuBuffer(), vb->GetNumElements(), remap);
 }
 
+//------------------------------------------------------------------------------
+static int 
+checkMeshThreadPool( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
+                     const std::vector<float>& coarseverts,
+                     xyzmesh * refmesh,
+                     const std::vector<int>& remap) {
+
+#ifdef OPENSUBDIV_HAS_PTHREADS
+
+    static OpenSubdiv::OsdCpuComputeController *cpuController = new OpenSubdiv::OsdCpuComputeController();
+
+    // small grains split every batch across all the threads
+    static OpenSubdiv::OsdThreadPoolComputeController *controller = new OpenSubdiv::OsdThreadPoolComputeController(4, 16);
+
+    OpenSubdiv::OsdCpuComputeContext *context = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices()),
+                                   * cpuvb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+
+    vb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+    cpuvb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+
+    controller->Refine( context, farmesh->GetKernelBatches(), vb );
+    cpuController->Refine( context, farmesh->GetKernelBatches(), cpuvb );
+
+    int result = checkVertexBuffer(refmesh, vb->BindCpuBuffer(), vb->GetNumElements(), remap);
+
+    // the threads compute the same vertices as the single threaded kernels
+    int count = compareBuffers(cpuvb->BindCpuBuffer(), vb->BindCpuBuffer(),
+                               vb->GetNumVertices() * vb->GetNumElements());
+    if (count)
+        printf("    %d elements differ from single threaded kernels\n", count);
+    result += count;
+
+    // partitioned batches write the pages placed by the same threads
+    static OpenSubdiv::OsdThreadPoolComputeController *partitionedController = 0;
+    if (not partitionedController) {
+        partitionedController = new OpenSubdiv::OsdThreadPoolComputeController(4, 16);
+        partitionedController->SetPartitioned(true);
+    }
+
+    OpenSubdiv::OsdCpuVertexBuffer * pagesvb = OpenSubdiv::OsdCpuVertexBuffer::Create(
+        3, farmesh->GetNumVertices(), OpenSubdiv::OsdCpuVertexBuffer::ALLOCATE_PAGES);
+
+    partitionedController->DistributeVertexBuffer( farmesh->GetKernelBatches(), pagesvb );
+    pagesvb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+    partitionedController->Refine( context, farmesh->GetKernelBatches(), pagesvb );
+
+    count = compareBuffers(cpuvb->BindCpuBuffer(), pagesvb->BindCpuBuffer(),
+                           pagesvb->GetNumVertices() * pagesvb->GetNumElements());
+    if (count)
+        printf("    %d elements differ from partitioned kernels\n", count);
+    result += count;
+
+    delete pagesvb;
+    delete vb;
+    delete cpuvb;
+    delete context;
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+static int 
+checkMeshAsync( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
+                const std::vector<float>& coarseverts,
+                xyzmesh * refmesh,
+                const std::vector<int>& remap) {
+
+#ifdef OPENSUBDIV_HAS_PTHREADS
+
+    typedef OpenSubdiv::OsdAsyncComputeController<OpenSubdiv::OsdCpuComputeController> AsyncController;
+
+    static OpenSubdiv::OsdCpuComputeController *cpuController = new OpenSubdiv::OsdCpuComputeController();
+
+    static AsyncController *controller = new AsyncController(cpuController);
+
+    OpenSubdiv::OsdCpuComputeContext *context0 = OpenSubdiv::OsdCpuComputeContext::Create(farmesh),
+                                     *context1 = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb0 = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices()),
+                                   * vb1 = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+
+    vb0->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+
+    AsyncController::Handle handle =
+        controller->Refine( context0, farmesh->GetKernelBatches(), vb0 );
+
+    // the second buffer is updated while the first one is refined
+    vb1->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+
+    controller->Refine( context1, farmesh->GetKernelBatches(), vb1 );
+
+    controller->Wait(handle);
+
+    int result = checkVertexBuffer(refmesh, vb0->BindCpuBuffer(), vb0->GetNumElements(), remap);
+
+    controller->Synchronize();
+
+    if (controller->GetNumPending()) {
+        printf("    %d refinements pending after Synchronize\n", controller->GetNumPending());
+        ++result;
+    }
+
+    int count = compareBuffers(vb0->BindCpuBuffer(), vb1->BindCpuBuffer(),
+                               vb0->GetNumVertices() * vb0->GetNumElements());
+    if (count)
+        printf("    %d elements differ between the refinements\n", count);
+    result += count;
+
+    delete vb0;
+    delete vb1;
+    delete context0;
+    delete context1;
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+static int 
+checkMeshHybrid( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
+                 const std::vector<float>& coarseverts,
+                 xyzmesh * refmesh,
+                 const std::vector<int>& remap) {
+
+#ifdef OPENSUBDIV_HAS_PTHREADS
+
+    static OpenSubdiv::OsdCpuComputeController *cpuController = new OpenSubdiv::OsdCpuComputeController();
+
+    static OpenSubdiv::OsdHybridComputeController *controller = 0;
+
+    if (not controller) {
+        // low thresholds run the small, medium and large batches with each
+        // of the executions
+        controller = new OpenSubdiv::OsdHybridComputeController(4, 16);
+        for (int kernel = 0; kernel < OpenSubdiv::FarKernelBatch::HIERARCHICAL_EDIT; ++kernel)
+            controller->SetThresholds((OpenSubdiv::FarKernelBatch::KernelType)kernel, 3, 8, 64);
+    }
+
+    OpenSubdiv::OsdCpuComputeContext *context = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+
+    OpenSubdiv::OsdCpuVertexBuffer * vb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices()),
+                                   * cpuvb = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+
+    vb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+    cpuvb->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+
+    controller->Refine( context, farmesh->GetKernelBatches(), vb );
+    cpuController->Refine( context, farmesh->GetKernelBatches(), cpuvb );
+
+    int result = checkVertexBuffer(refmesh, vb->BindCpuBuffer(), vb->GetNumElements(), remap);
+
+    // all the executions compute the same vertices as the CPU kernels
+    int count = compareBuffers(cpuvb->BindCpuBuffer(), vb->BindCpuBuffer(),
+                               vb->GetNumVertices() * vb->GetNumElements());
+    if (count)
+        printf("    %d elements differ from the CPU kernels\n", count);
+    result += count;
+
+    delete vb;
+    delete cpuvb;
+    delete context;
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+#ifdef OPENSUBDIV_HAS_PTHREADS
+// Refines a copy of the mesh on the threads of the scheduler
+class RefineJob : public OpenSubdiv::OsdRefineScheduler::Job {
+public:
+    RefineJob(OpenSubdiv::OsdCpuComputeController * controller,
+              OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * farmesh,
+              OpenSubdiv::OsdCpuComputeContext * context,
+              OpenSubdiv::OsdCpuVertexBuffer * vb) :
+        _controller(controller), _farmesh(farmesh), _context(context), _vb(vb) { }
+
+    virtual void Run() {
+        _controller->Refine( _context, _farmesh->GetKernelBatches(), _vb );
+    }
+
+private:
+    OpenSubdiv::OsdCpuComputeController * _controller;
+    OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex> * _farmesh;
+    OpenSubdiv::OsdCpuComputeContext * _context;
+    OpenSubdiv::OsdCpuVertexBuffer * _vb;
+};
+#endif
+
+//------------------------------------------------------------------------------
+static int 
+checkMeshScheduler( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
+                    const std::vector<float>& coarseverts,
+                    xyzmesh * refmesh,
+                    const std::vector<int>& remap) {
+
+#ifdef OPENSUBDIV_HAS_PTHREADS
+
+    static OpenSubdiv::OsdCpuComputeController *controller = new OpenSubdiv::OsdCpuComputeController();
+
+    static OpenSubdiv::OsdRefineScheduler *scheduler = new OpenSubdiv::OsdRefineScheduler(4);
+
+    // copies of the mesh refined side by side, as the meshes of a crowd
+    const int numCopies = 8;
+
+    std::vector<OpenSubdiv::OsdCpuComputeContext *> contexts(numCopies);
+    std::vector<OpenSubdiv::OsdCpuVertexBuffer *> vbs(numCopies);
+
+    for (int i = 0; i < numCopies; ++i) {
+        contexts[i] = OpenSubdiv::OsdCpuComputeContext::Create(farmesh);
+        vbs[i] = OpenSubdiv::OsdCpuVertexBuffer::Create(3, farmesh->GetNumVertices());
+        vbs[i]->UpdateData( & coarseverts[0], 0, (int)coarseverts.size()/3 );
+
+        scheduler->Submit(new RefineJob(controller, farmesh, contexts[i], vbs[i]),
+                          farmesh->GetNumVertices() * 3);
+    }
+
+    scheduler->Barrier();
+
+    int result = 0;
+    if (scheduler->GetNumPending()) {
+        printf("    %d refinements pending after Barrier\n", scheduler->GetNumPending());
+        ++result;
+    }
+
+    result += checkVertexBuffer(refmesh, vbs[0]->BindCpuBuffer(), vbs[0]->GetNumElements(), remap);
+
+    for (int i = 1; i < numCopies; ++i) {
+        int count = compareBuffers(vbs[0]->BindCpuBuffer(), vbs[i]->BindCpuBuffer(),
+                                   vbs[0]->GetNumVertices() * vbs[0]->GetNumElements());
+        if (count)
+            printf("    %d elements differ between the refinements\n", count);
+        result += count;
+    }
+
+    for (int i = 0; i < numCopies; ++i) {
+        delete vbs[i];
+        delete contexts[i];
+    }
+
+    return result;
+#else
+    return 0;
+#endif
+}
+
 //------------------------------------------------------------------------------
 static int 
 checkMeshCL( OpenSubdiv::FarMesh<OpenSubdiv::OsdVertex>* farmesh,
@@ -434,9 +850,14 @@ checkMesh( char const * msg, std::string const & shape, int levels, Scheme schem
     std::vector<int> remap = meshFactory.GetRemappingTable();
 
     switch (backend) {
-        case kBackendCPU   : result = checkMeshCPU(farmesh, coarseverts, refmesh, remap); break;
+        case kBackendCPU   : result = checkMeshCPU(farmesh, coarseverts, refmesh, remap);
+                             result += checkTopologyCache(shape, levels, scheme, coarseverts, refmesh, remap); break;
         case kBackendCPUGL : result = checkMeshCPUGL(farmesh, coarseverts, refmesh, remap); break;
         case kBackendCL    : result = checkMeshCL(farmesh, coarseverts, refmesh, remap); break;
+        case kBackendThreadPool : result = checkMeshThreadPool(farmesh, coarseverts, refmesh, remap); break;
+        case kBackendAsync : result = checkMeshAsync(farmesh, coarseverts, refmesh, remap); break;
+        case kBackendHybrid : result = checkMeshHybrid(farmesh, coarseverts, refmesh, remap); break;
+        case kBackendScheduler : result = checkMeshScheduler(farmesh, coarseverts, refmesh, remap); break;
     }
 
     delete hmesh;
@@ -461,6 +882,14 @@ int checkBackend(int backend, int levels) {
 #endif
     }
 
+    if (backend == kBackendThreadPool or backend == kBackendAsync or
+        backend == kBackendHybrid or backend == kBackendScheduler) {
+#ifndef OPENSUBDIV_HAS_PTHREADS
+        printf("  No pthreads available, skipping...\n");
+        return 0;
+#endif
+    }
+
     int total = 0;
 
 #define test_catmark_edgeonly
@@ -515,6 +944,8 @@ int checkBackend(int backend, int levels) {
 #ifdef test_catmark_pyramid
 #include "../shapes/catmark_pyramid.h"
     total += checkMesh( "test_catmark_pyramid", catmark_pyramid, levels, kCatmark, backend );
+    if (backend == kBackendCPU)
+        total += checkTopologyCacheRules( catmark_pyramid, levels );
 #endif
 
 #ifdef test_catmark_pyramid_creases0